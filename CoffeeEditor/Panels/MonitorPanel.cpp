@@ -3,6 +3,8 @@
 #include "CoffeeEngine/Core/SystemInfo.h"
 #include "CoffeeEngine/Core/Application.h"
 #include "CoffeeEngine/Core/Timer.h"
+#include "CoffeeEngine/IO/Resource.h"
+#include "CoffeeEngine/Project/Project.h"
 #include <cstdint>
 #include <imgui.h>
 #include <string>
@@ -14,10 +16,14 @@ namespace Coffee {
         static float FPS = 0.0f;
         static float FrameTime = 0.0f;
         static uint64_t MemoryUsage = 0.0f;
+        static float ResourceCPUMemory = 0.0f;
+        static float ResourceGPUMemory = 0.0f;
 
         FPS = Application::Get().GetFPS();
         FrameTime = Application::Get().GetFrameTime();
         MemoryUsage = SystemInfo::GetProcessMemoryUsage();
+        ResourceCPUMemory = Resource::GetTotalCPUMemoryUsage() / (1024.0f * 1024.0f);
+        ResourceGPUMemory = Resource::GetTotalGPUMemoryUsage() / (1024.0f * 1024.0f);
 
 
         ImGui::Begin("Monitor");
@@ -69,6 +75,29 @@ namespace Coffee {
             ImGui::Checkbox("Memory Usage", &m_MemoryUsage);
             ImGui::TableNextColumn();
             ImGui::Text("%lu", MemoryUsage);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Checkbox("Resource Memory", &m_ResourceMemory);
+            ImGui::TableNextColumn();
+            ImGui::Text("CPU %.1f MB / GPU %.1f MB", ResourceCPUMemory, ResourceGPUMemory);
+
+            // Saved with the project, unused resources are evicted once the budget is exceeded
+            if (Project::GetActive())
+            {
+                uint64_t cpuBudget = Project::GetCPUMemoryBudgetMB();
+                uint64_t gpuBudget = Project::GetGPUMemoryBudgetMB();
+
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("Resource Budget (MB, 0 = none)");
+                ImGui::TableNextColumn();
+                bool changed = ImGui::InputScalar("CPU##ResourceBudget", ImGuiDataType_U64, &cpuBudget);
+                changed |= ImGui::InputScalar("GPU##ResourceBudget", ImGuiDataType_U64, &gpuBudget);
+                if (changed)
+                {
+                    Project::SetMemoryBudget(cpuBudget, gpuBudget);
+                }
+            }
             ImGui::EndTable();
             ImGui::TreePop();
         }
@@ -123,6 +152,32 @@ namespace Coffee {
                 return mu;
             }, &memoryUsage, memoryUsage.size(), 0, MemoryUsageOverlay.c_str(), yMin, yMax, ImVec2(0, 80)); // Minimum height of 80
         }
+
+        if (m_ResourceMemory)
+        {
+            // Data of the loaded resources, CPU copies released after their upload do not count
+            ImGui::Text("Resource Memory");
+
+            static CircularBuffer<float> cpuMemory(10000);
+            static CircularBuffer<float> gpuMemory(10000);
+
+            static Timer timer(0.5f, true, false, [&]() {
+                cpuMemory.push_back(ResourceCPUMemory);
+                gpuMemory.push_back(ResourceGPUMemory);
+            });
+
+            auto getValue = [](void* data, int idx) -> float {
+                return (*(CircularBuffer<float>*)data)[idx];
+            };
+
+            std::string CPUOverlay = "CPU: " + std::to_string(ResourceCPUMemory) + " MB";
+            ImGui::PlotLines("##ResourceCPUMemory", getValue, &cpuMemory, cpuMemory.size(), 0, CPUOverlay.c_str(),
+                             0.0f, FLT_MAX, ImVec2(0, 80)); // Minimum height of 80
+
+            std::string GPUOverlay = "GPU: " + std::to_string(ResourceGPUMemory) + " MB";
+            ImGui::PlotLines("##ResourceGPUMemory", getValue, &gpuMemory, gpuMemory.size(), 0, GPUOverlay.c_str(),
+                             0.0f, FLT_MAX, ImVec2(0, 80)); // Minimum height of 80
+        }
         ImGui::EndChild();
 
         ImGui::End();
@@ -12,5 +12,6 @@ namespace Coffee {
         bool m_ShowFPS = true;
         bool m_ShowFrameTime = true;
         bool m_MemoryUsage = true;
+        bool m_ResourceMemory = true;
     };
 }
\ No newline at end of file
@@ -348,6 +348,7 @@ namespace Coffee {
             bool isCollapsingHeaderOpen = true;
             if(ImGui::CollapsingHeader("Mesh", &isCollapsingHeaderOpen, ImGuiTreeNodeFlags_DefaultOpen))
             {
+                Ref<Mesh> previousMesh = meshComponent.mesh;
                 ImGui::Text("Mesh");
                 ImGui::SameLine();
                 if(ImGui::Button(meshComponent.GetMesh()->GetName().c_str(), {64, 32}))
@@ -394,7 +395,13 @@ namespace Coffee {
                     }
                     ImGui::EndPopup();
                 }
+                if(meshComponent.mesh != previousMesh)
+                {
+                    // Let the scene refresh the bounds of the entity
+                    m_Context->m_Registry.patch<MeshComponent>((entt::entity)entity);
+                }
                 ImGui::Checkbox("Draw AABB", &meshComponent.drawAABB);
+                ImGui::Checkbox("Occluder", &meshComponent.isOccluder);
 
                 if(!isCollapsingHeaderOpen)
                 {
@@ -3,30 +3,38 @@
 
 layout (location = 0) in vec3 a_Position;
 layout (location = 1) in vec2 a_TexCoord;
+layout (location = 5) in vec4 a_Color;
+layout (location = 6) in vec3 a_EntityID;
 
 uniform mat4 u_ViewProjection;
-uniform mat4 u_Transform;
 
 out vec2 v_TexCoord;
+out vec4 v_Color;
+flat out vec3 v_EntityID;
 
 void main()
 {
     v_TexCoord = a_TexCoord;
-    gl_Position = u_ViewProjection * u_Transform * vec4(a_Position, 1.0);
+    v_Color = a_Color;
+    v_EntityID = a_EntityID;
+    gl_Position = u_ViewProjection * vec4(a_Position, 1.0);
 }
 
 #[fragment]
 #version 450 core
 
 layout(location = 0) out vec4 o_Color;
+layout(location = 1) out vec3 o_EntityID;
 
 in vec2 v_TexCoord;
+in vec4 v_Color;
+flat in vec3 v_EntityID;
 
 uniform sampler2D u_Texture;
-uniform vec4 u_Color = vec4(1.0);
 
 void main()
 {
     vec4 texColor = texture(u_Texture, v_TexCoord);
-    o_Color = texColor * u_Color;
-}
\ No newline at end of file
+    o_Color = texColor * v_Color;
+    o_EntityID = v_EntityID;
+}
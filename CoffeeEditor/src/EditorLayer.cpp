@@ -12,6 +12,7 @@
 #include "CoffeeEngine/IO/ResourceLoader.h"
 #include "CoffeeEngine/IO/ResourceRegistry.h"
 #include "CoffeeEngine/IO/ResourceUtils.h"
+#include "CoffeeEngine/Math/Ray.h"
 #include "CoffeeEngine/Project/Project.h"
 #include "CoffeeEngine/Renderer/DebugRenderer.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
@@ -31,6 +32,7 @@
 #include <glm/fwd.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
+#include <limits>
 #include <string>
 #include <sys/types.h>
 #include <tracy/Tracy.hpp>
@@ -41,6 +43,9 @@ namespace Coffee {
 
     static RendererStats s_RendererData;
 
+    // Size of the boxes lights and cameras are picked with in the viewport
+    static constexpr float PickProxySize = 0.5f;
+
     EditorLayer::EditorLayer() : Layer("Example")
     {
 
@@ -140,16 +145,34 @@ namespace Coffee {
 
                 if (mouseX >= 0 && mouseY >= 0 && mouseX < (int)viewportSize.x && mouseY < (int)viewportSize.y)
                 {
-                    const glm::vec4& pixelData = Renderer::GetEntityIDAtPixel(mouseX, mouseY);
-
-                    /// Convert the vec3 back to uint32_t
-                    uint32_t r = static_cast<uint32_t>(pixelData.r * 255.0f);
-                    uint32_t g = static_cast<uint32_t>(pixelData.g * 255.0f);
-                    uint32_t b = static_cast<uint32_t>(pixelData.b * 255.0f);
-
-                    uint32_t entityID = (r << 0) | (g << 8) | (b << 16);
+                    // Unproject the pixel to the near and far planes of the camera shown in the viewport
+                    glm::mat4 viewProjection = m_SceneState == SceneState::Edit ? m_EditorCamera.GetViewProjection()
+                                                                                : m_ActiveScene->GetRuntimeViewProjection();
+                    glm::vec2 ndc = (glm::vec2(mouseX, mouseY) + 0.5f) / viewportSize * 2.0f - 1.0f;
+                    glm::mat4 inverseViewProjection = glm::inverse(viewProjection);
+                    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc, -1.0f, 1.0f);
+                    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc, 1.0f, 1.0f);
+                    nearPoint /= nearPoint.w;
+                    farPoint /= farPoint.w;
+
+                    Ray ray(glm::vec3(nearPoint), glm::normalize(glm::vec3(farPoint - nearPoint)));
+
+                    // Picked on the CPU, reading the entity ID buffer back would stall until the GPU catches up.
+                    // Only mesh entities are in the octree, the rest is tested against proxy boxes in front of them
+                    RaycastHit hit;
+                    bool found = m_ActiveScene->Raycast(ray, hit);
+
+                    RaycastHit proxyHit;
+                    if (m_ActiveScene->RaycastProxies(ray, proxyHit, PickProxySize,
+                                                      found ? hit.distance : std::numeric_limits<float>::max()))
+                    {
+                        hit = proxyHit;
+                        found = true;
+                    }
 
-                    Entity hoveredEntity = entityID == 16777215 ? Entity() : Entity((entt::entity)entityID, m_ActiveScene.get());
+                    Entity hoveredEntity;
+                    if (found)
+                        hoveredEntity = Entity(hit.entity, m_ActiveScene.get());
 
                     m_SceneTreePanel.SetSelectedEntity(hoveredEntity);
                 }
@@ -403,6 +426,12 @@ namespace Coffee {
         ImGui::Text("Draw Calls: %d", Renderer::GetStats().DrawCalls);
         ImGui::Text("Vertex Count: %d", Renderer::GetStats().VertexCount);
         ImGui::Text("Index Count: %d", Renderer::GetStats().IndexCount);
+        if (m_ActiveScene && m_ActiveScene->GetOcclusionCuller().IsEnabled())
+        {
+            const OcclusionStats& occlusionStats = m_ActiveScene->GetOcclusionCuller().GetStats();
+            ImGui::Text("Occluders: %d (%d triangles)", occlusionStats.OccluderCount, occlusionStats.OccluderTriangles);
+            ImGui::Text("Occlusion Culled: %d / %d", occlusionStats.CulledCount, occlusionStats.TestedCount);
+        }
         ImGui::End();
 
         // Display EditorCamera speed vertical slider & zoom vertical slider at the center left
@@ -503,21 +532,26 @@ namespace Coffee {
             ImGui::TableSetupColumn("Use Count", ImGuiTableColumnFlags_DefaultSort);
             ImGui::TableHeadersRow();
         
-            auto& resources = ResourceRegistry::GetResourceRegistry();
+            auto resources = ResourceRegistry::GetSnapshot();
             for (auto& resource : resources)
             {
+                const ResourceEntry& entry = resource.second;
+
                 // Filter resources based on the search query
-                if (searchQuery.empty() || resource.second->GetName().find(searchQuery) != std::string::npos)
+                if (searchQuery.empty() || entry.name.find(searchQuery) != std::string::npos)
                 {
                     ImGui::TableNextRow();
                     ImGui::TableSetColumnIndex(0);
-                    ImGui::Text("%s", resource.second->GetName().c_str());
+                    ImGui::Text("%s", entry.name.c_str());
                     ImGui::TableSetColumnIndex(1);
                     ImGui::Text("%lu", resource.first);
                     ImGui::TableSetColumnIndex(2);
-                    ImGui::Text("%s", ResourceTypeToString(resource.second->GetType()).c_str());
+                    ImGui::Text("%s", ResourceTypeToString(entry.type).c_str());
                     ImGui::TableSetColumnIndex(3);
-                    ImGui::Text("%d", resource.second.use_count());
+                    if (entry.resource)
+                        ImGui::Text("%d", entry.resource.use_count());
+                    else
+                        ImGui::TextDisabled("Evicted");
                 }
             }
         
@@ -528,14 +562,28 @@ namespace Coffee {
 
         //Debug Scene Octree
         ImGui::Begin("Octree Debug");
-        if(ImGui::Button("Clear Octree"))
+        if(ImGui::Button("Rebuild Octree"))
         {
-            m_ActiveScene->m_Octree.Clear();
+            m_ActiveScene->RebuildOctree();
         }
         if(ImGui::Button("Add Point"))
         {
             //m_ActiveScene->m_Octree.Insert({{rand() % 20 - 10, rand() % 20 - 10, rand() % 20 - 10}});
         }
+        ImGui::Text("Objects: %zu", m_ActiveScene->m_Octree.Size());
+        ImGui::Text("Nodes: %zu", m_ActiveScene->m_Octree.GetNodeCount());
+
+        OcclusionCuller& occlusionCuller = m_ActiveScene->GetOcclusionCuller();
+        bool occlusionEnabled = occlusionCuller.IsEnabled();
+        if (ImGui::Checkbox("Occlusion Culling", &occlusionEnabled))
+        {
+            occlusionCuller.SetEnabled(occlusionEnabled);
+        }
+        bool occlusionDebugDraw = occlusionCuller.IsDebugDrawEnabled();
+        if (ImGui::Checkbox("Draw Occluded Bounds", &occlusionDebugDraw))
+        {
+            occlusionCuller.SetDebugDrawEnabled(occlusionDebugDraw);
+        }
         ImGui::End();
     }
        
@@ -557,8 +605,7 @@ namespace Coffee {
 
                 if (meshComponent.drawAABB)
                 {
-                    const AABB& aabb = meshComponent.mesh->GetAABB().CalculateTransformedAABB(transform);
-                    DebugRenderer::DrawBox(aabb, {0.27f, 0.52f, 0.53f, 1.0f});
+                    DebugRenderer::DrawBox(meshComponent.worldAABB, {0.27f, 0.52f, 0.53f, 1.0f});
                 }
 
                 OBB obb = meshComponent.mesh->GetOBB(transform);
@@ -650,17 +697,9 @@ namespace Coffee {
 
     void EditorLayer::OnScenePlay()
     {
-        if(m_ActiveScene->m_FilePath.empty())
-        {
-            COFFEE_ERROR("Scene is not saved! Please save the scene before playing.");
-            return;
-        }
-
         m_SceneState = SceneState::Play;
 
-        Scene::Save(m_EditorScene->m_FilePath, m_EditorScene);
-
-        m_ActiveScene = Scene::Load(m_ActiveScene->m_FilePath);
+        m_ActiveScene = Scene::Clone(m_EditorScene);
         m_ActiveScene->OnInitRuntime();
 
         m_SceneTreePanel.SetContext(m_ActiveScene);
@@ -742,12 +781,19 @@ namespace Coffee {
     void EditorLayer::OpenScene()
     {
         FileDialogArgs args;
-        args.Filters = {{"Coffee Scene", "TeaScene"}};
+        args.Filters = {{"Coffee Scene", "TeaScene"}, {"Coffee Scene (JSON)", "json"}};
         const std::filesystem::path& path = FileDialog::OpenFile(args);
 
-        if (!path.empty() and path.extension() == ".TeaScene")
+        if (!path.empty() and (path.extension() == ".TeaScene" or path.extension() == ".json"))
         {
-            m_EditorScene = Scene::Load(path);
+            Ref<Scene> scene = Scene::Load(path);
+            if (!scene)
+            {
+                COFFEE_CORE_ERROR("Open Scene: Could not load {0}", path.string());
+                return;
+            }
+
+            m_EditorScene = scene;
             m_ActiveScene = m_EditorScene;
             m_ActiveScene->OnInitEditor();
 
@@ -765,12 +811,14 @@ namespace Coffee {
     void EditorLayer::SaveScene()
     {
         FileDialogArgs args;
-        args.Filters = {{"Coffee Scene", "TeaScene"}};
+        args.Filters = {{"Coffee Scene", "TeaScene"}, {"Coffee Scene (JSON)", "json"}};
         const std::filesystem::path& path = FileDialog::SaveFile(args);
 
         if (!path.empty())
         {
-            Scene::Save(path, m_ActiveScene);
+            // JSON is kept to export scenes in a readable, diffable form
+            ResourceFormat format = path.extension() == ".json" ? ResourceFormat::JSON : ResourceFormat::Binary;
+            Scene::Save(path, m_ActiveScene, format);
         }
         else
         {
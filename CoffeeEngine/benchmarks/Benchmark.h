@@ -0,0 +1,62 @@
+/**
+ * @file Benchmark.h
+ * @brief Timing helpers shared by the microbenchmarks.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace Coffee::Benchmark {
+
+    /**
+     * @brief Times a function, once to warm up and then over several runs.
+     * @param runs The number of timed runs.
+     * @param func The work to time.
+     * @return The median run time in milliseconds.
+     */
+    template <typename Func>
+    double Run(uint32_t runs, Func&& func)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        func();
+
+        std::vector<double> times(runs);
+        for (double& time : times)
+        {
+            Clock::time_point start = Clock::now();
+            func();
+            time = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        }
+
+        std::sort(times.begin(), times.end());
+        return times[runs / 2];
+    }
+
+    /**
+     * @brief Prints a timing next to its speedup over a baseline.
+     * @param name The name of the measured path.
+     * @param milliseconds The median run time of the path.
+     * @param baseline The median run time of the path it is compared against.
+     */
+    inline void Report(const char* name, double milliseconds, double baseline)
+    {
+        std::printf("%-40s %10.3f ms %8.2fx\n", name, milliseconds, baseline / milliseconds);
+    }
+
+    /**
+     * @brief Keeps a result observable so the compiler cannot drop the work that produced it.
+     * @param value The result.
+     */
+    inline void Consume(uint64_t value)
+    {
+        static volatile uint64_t s_Sink = 0;
+        s_Sink = s_Sink + value;
+    }
+
+}
@@ -0,0 +1,90 @@
+/**
+ * @file FrustumCullingBench.cpp
+ * @brief Culls 100k scattered boxes one at a time with Frustum::Contains and in batches with
+ * FrustumCulling::CullBounds, with and without the plane cache.
+ */
+
+#include "Benchmark.h"
+
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Math/Frustum.h"
+#include "CoffeeEngine/Math/FrustumCulling.h"
+
+#include <bit>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+using namespace Coffee;
+
+static constexpr uint32_t BoxCount = 100000;
+static constexpr uint32_t Runs = 50;
+
+static uint64_t CountVisible(const std::vector<uint64_t>& visibility)
+{
+    uint64_t count = 0;
+    for (uint64_t word : visibility)
+        count += std::popcount(word);
+    return count;
+}
+
+int main()
+{
+    Log::Init();
+
+    // Boxes all around the camera, so roughly a tenth of them end up inside the frustum
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+
+    std::vector<AABB> boxes;
+    BoundsSoA bounds;
+    for (uint32_t i = 0; i < BoxCount; ++i)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        glm::vec3 extent(size(random), size(random), size(random));
+        boxes.emplace_back(center - extent, center + extent);
+        bounds.PushBack(boxes.back());
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 200.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum(projection * view);
+
+    std::vector<uint64_t> visibility(FrustumCulling::GetVisibilityWordCount(BoxCount));
+
+    double contains = Benchmark::Run(Runs, [&]() {
+        std::fill(visibility.begin(), visibility.end(), 0);
+        for (uint32_t i = 0; i < BoxCount; ++i)
+        {
+            if (frustum.Contains(boxes[i]))
+                visibility[i / 64] |= 1ull << (i % 64);
+        }
+        Benchmark::Consume(visibility[0]);
+    });
+    uint64_t containsVisible = CountVisible(visibility);
+
+    double batched = Benchmark::Run(Runs, [&]() {
+        FrustumCulling::CullBounds(frustum.GetPlanes(), FrustumCulling::AllPlanes, bounds, visibility.data());
+        Benchmark::Consume(visibility[0]);
+    });
+    uint64_t batchedVisible = CountVisible(visibility);
+
+    // The camera does not move, after the warmup every group is rejected by its cached plane
+    std::vector<uint8_t> planeCache(FrustumCulling::GetPlaneCacheSize(BoxCount), 0);
+    double cached = Benchmark::Run(Runs, [&]() {
+        FrustumCulling::CullBounds(frustum.GetPlanes(), FrustumCulling::AllPlanes, bounds, visibility.data(),
+                                   planeCache.data());
+        Benchmark::Consume(visibility[0]);
+    });
+
+    // Frustum::Contains also tests the frustum corners against the box, so it may reject a few more
+    std::printf("%u boxes, %llu visible with Contains, %llu with CullBounds\n", BoxCount,
+                (unsigned long long)containsVisible, (unsigned long long)batchedVisible);
+    Benchmark::Report("Frustum::Contains", contains, contains);
+    Benchmark::Report("CullBounds", batched, contains);
+    Benchmark::Report("CullBounds + plane cache", cached, contains);
+
+    return 0;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file HierarchyBench.cpp
+ * @brief Updates the world transforms of wide, balanced and deep hierarchies with the recursive walk the scene
+ * tree used to do and with the flat depth-sorted SceneTree::Update.
+ */
+
+#include "Benchmark.h"
+
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/Scene.h"
+#include "CoffeeEngine/Scene/SceneTree.h"
+
+#include <vector>
+
+using namespace Coffee;
+
+static constexpr uint32_t Runs = 20;
+
+struct Hierarchy
+{
+    std::vector<entt::entity> Roots;
+    std::vector<entt::entity> Entities;
+};
+
+// Builds a tree level by level, every node of a level gets the same number of children
+static Hierarchy BuildTree(Scene& scene, uint32_t rootCount, const std::vector<uint32_t>& childCounts)
+{
+    Hierarchy hierarchy;
+    for (uint32_t i = 0; i < rootCount; ++i)
+    {
+        hierarchy.Roots.push_back(scene.CreateEntity());
+    }
+    hierarchy.Entities = hierarchy.Roots;
+
+    std::vector<entt::entity> level = hierarchy.Roots;
+    for (uint32_t childCount : childCounts)
+    {
+        std::vector<entt::entity> nextLevel;
+        for (entt::entity parent : level)
+        {
+            std::vector<entt::entity> children;
+            for (uint32_t i = 0; i < childCount; ++i)
+            {
+                Entity child = scene.CreateEntity();
+                child.GetComponent<TransformComponent>().Position = glm::vec3(1.0f, 0.0f, 0.0f);
+                children.push_back(child);
+            }
+
+            Entity(parent, &scene).AddChildren(children);
+            nextLevel.insert(nextLevel.end(), children.begin(), children.end());
+        }
+
+        hierarchy.Entities.insert(hierarchy.Entities.end(), nextLevel.begin(), nextLevel.end());
+        level = std::move(nextLevel);
+    }
+
+    return hierarchy;
+}
+
+// The scene tree update before it was flattened, following the hierarchy links through the registry
+static void UpdateRecursive(Scene& scene, entt::entity entity, const glm::mat4& parentTransform)
+{
+    Entity node(entity, &scene);
+    TransformComponent& transform = node.GetComponent<TransformComponent>();
+    transform.SetWorldTransform(parentTransform);
+
+    for (entt::entity child = node.GetComponent<HierarchyComponent>().m_First; child != entt::null;
+         child = Entity(child, &scene).GetComponent<HierarchyComponent>().m_Next)
+    {
+        UpdateRecursive(scene, child, transform.GetWorldTransform());
+    }
+}
+
+static void MarkAllDirty(Scene& scene, const Hierarchy& hierarchy)
+{
+    for (entt::entity entity : hierarchy.Entities)
+    {
+        Entity(entity, &scene).GetComponent<TransformComponent>().MarkDirty();
+    }
+}
+
+static void RunShape(const char* name, uint32_t rootCount, const std::vector<uint32_t>& childCounts)
+{
+    Scene scene;
+    Hierarchy hierarchy = BuildTree(scene, rootCount, childCounts);
+
+    // A tree of its own, the one of the scene is only updated by the scene update
+    SceneTree sceneTree(&scene);
+    sceneTree.Update();
+
+    double recursive = Benchmark::Run(Runs, [&]() {
+        MarkAllDirty(scene, hierarchy);
+        for (entt::entity root : hierarchy.Roots)
+        {
+            UpdateRecursive(scene, root, glm::mat4(1.0f));
+        }
+    });
+
+    double flat = Benchmark::Run(Runs, [&]() {
+        MarkAllDirty(scene, hierarchy);
+        sceneTree.Update();
+        Benchmark::Consume(sceneTree.GetChangedEntities().size());
+    });
+
+    double flatStatic = Benchmark::Run(Runs, [&]() {
+        sceneTree.Update();
+        Benchmark::Consume(sceneTree.GetChangedEntities().size());
+    });
+
+    std::printf("%s: %zu entities, %zu levels\n", name, hierarchy.Entities.size(), childCounts.size() + 1);
+    Benchmark::Report("  Recursive, all dirty", recursive, recursive);
+    Benchmark::Report("  Flat levels, all dirty", flat, recursive);
+    Benchmark::Report("  Flat levels, static", flatStatic, recursive);
+}
+
+int main()
+{
+    Log::Init();
+    JobSystem::Init();
+
+    std::printf("%u threads\n", JobSystem::GetThreadCount());
+
+    RunShape("Wide", 1000, {100});
+    RunShape("Balanced", 1, {4, 4, 4, 4, 4, 4, 4, 4});
+    RunShape("Deep", 100, std::vector<uint32_t>(999, 1));
+
+    JobSystem::Shutdown();
+    return 0;
+}
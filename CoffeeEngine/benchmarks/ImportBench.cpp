@@ -0,0 +1,90 @@
+/**
+ * @file ImportBench.cpp
+ * @brief Loads a project directory with ResourceLoader::LoadDirectory on an increasing number of job threads,
+ * once with a cold cache so every source is decoded and once from the cache.
+ *
+ * Usage: ImportBench <directory>. The missing .import files are written next to the resources, the cache goes
+ * to a temporary directory.
+ */
+
+#include "Benchmark.h"
+
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/Core/Window.h"
+#include "CoffeeEngine/IO/CacheManager.h"
+#include "CoffeeEngine/IO/ResourceLoader.h"
+#include "CoffeeEngine/IO/ResourceRegistry.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
+
+#include <filesystem>
+#include <thread>
+#include <vector>
+
+using namespace Coffee;
+
+static constexpr uint32_t Runs = 3;
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::printf("Usage: %s <directory>\n", argv[0]);
+        return 1;
+    }
+
+    const std::filesystem::path directory = argv[1];
+
+    Log::Init();
+
+    // Textures and shaders are created on the graphics context of this thread
+    Scope<Window> window = Window::Create(WindowProps("ImportBench"));
+    UploadQueue::Init();
+
+    CacheManager::SetCachePath(std::filesystem::temp_directory_path() / "CoffeeImportBench");
+
+    std::vector<uint32_t> threadCounts;
+    const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (uint32_t threads = 1; threads < hardwareThreads; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(hardwareThreads);
+
+    auto load = [&](bool coldCache) {
+        ResourceRegistry::Clear();
+        if (coldCache)
+        {
+            CacheManager::ClearCache();
+            CacheManager::CreateCacheDirectory();
+        }
+        ResourceLoader::LoadDirectory(directory);
+    };
+
+    double coldBaseline = 0.0;
+    double warmBaseline = 0.0;
+    for (uint32_t threads : threadCounts)
+    {
+        // Without workers every job runs inline on this thread
+        if (threads > 1)
+            JobSystem::Init(threads - 1);
+
+        double cold = Benchmark::Run(Runs, [&]() { load(true); });
+        double warm = Benchmark::Run(Runs, [&]() { load(false); });
+
+        if (threads == 1)
+        {
+            coldBaseline = cold;
+            warmBaseline = warm;
+        }
+
+        std::printf("%u threads\n", JobSystem::GetThreadCount());
+        Benchmark::Report("  Cold cache", cold, coldBaseline);
+        Benchmark::Report("  Warm cache", warm, warmBaseline);
+
+        if (threads > 1)
+            JobSystem::Shutdown();
+    }
+
+    ResourceRegistry::Clear();
+    CacheManager::ClearCache();
+    return 0;
+}
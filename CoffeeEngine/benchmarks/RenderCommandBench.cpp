@@ -0,0 +1,73 @@
+/**
+ * @file RenderCommandBench.cpp
+ * @brief Builds the render commands of 100k mesh entities with Scene::BuildRenderCommands, the builder of
+ * Scene::OnUpdateEditor, on one thread and on every hardware thread.
+ */
+
+#include "Benchmark.h"
+
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/Renderer/RenderQueue.h"
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Scene.h"
+
+#include <entt/entt.hpp>
+#include <vector>
+
+using namespace Coffee;
+
+static constexpr uint32_t EntityCount = 100000;
+static constexpr uint32_t Runs = 50;
+
+// Builds the commands and merges the chunk queues in order, as the renderer consumes them
+static double Run(entt::registry& registry, const std::vector<entt::entity>& entities)
+{
+    std::vector<RenderQueue> chunkQueues;
+    RenderQueue mergedQueue;
+
+    return Benchmark::Run(Runs, [&]() {
+        uint32_t chunkCount = Scene::BuildRenderCommands(registry, entities, chunkQueues);
+
+        mergedQueue.Reset();
+        for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+            mergedQueue.Append(chunkQueues[chunk]);
+
+        Benchmark::Consume(mergedQueue.Size());
+    });
+}
+
+int main()
+{
+    Log::Init();
+
+    // Meshes and materials are only borrowed by the commands, null ones avoid creating GPU objects
+    entt::registry registry;
+    std::vector<entt::entity> entities(EntityCount);
+    for (uint32_t i = 0; i < EntityCount; ++i)
+    {
+        entt::entity entity = registry.create();
+        TransformComponent& transform = registry.emplace<TransformComponent>(entity, glm::vec3(i % 100, i / 100 % 100, i / 10000));
+        transform.SetWorldTransform(glm::mat4(1.0f));
+        registry.emplace<MeshComponent>(entity, Ref<Mesh>());
+
+        // Every other entity has a material, so both sides of the lookup are exercised
+        if (i % 2 == 0)
+            registry.emplace<MaterialComponent>(entity, Ref<Material>());
+
+        entities[i] = entity;
+    }
+
+    // Without workers every job runs inline on this thread
+    double serial = Run(registry, entities);
+
+    JobSystem::Init();
+    double parallel = Run(registry, entities);
+
+    std::printf("%u entities, %u threads\n", EntityCount, JobSystem::GetThreadCount());
+    Benchmark::Report("1 thread", serial, serial);
+    Benchmark::Report("All threads", parallel, serial);
+
+    JobSystem::Shutdown();
+    return 0;
+}
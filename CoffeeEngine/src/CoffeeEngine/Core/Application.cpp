@@ -1,8 +1,11 @@
 #include "CoffeeEngine/Core/Application.h"
+#include "CoffeeEngine/Core/JobSystem.h"
 #include "CoffeeEngine/Core/Layer.h"
 #include "CoffeeEngine/Core/Stopwatch.h"
 #include "CoffeeEngine/Events/KeyEvent.h"
+#include "CoffeeEngine/IO/ResourceLoader.h"
 #include "CoffeeEngine/Renderer/Renderer.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
 
 #include <SDL3/SDL_timer.h>
 #include <SDL3/SDL.h>
@@ -22,6 +25,10 @@ namespace Coffee
         m_Window = Window::Create(WindowProps("Coffee Engine"));
         SetEventCallback(COFFEE_BIND_EVENT_FN(OnEvent));
 
+        UploadQueue::Init();
+        JobSystem::Init();
+        ResourceLoader::SetEventCallback(COFFEE_BIND_EVENT_FN(OnEvent));
+
         BillboardRenderer::Init();
         Renderer::Init();
         /*BillboardRenderer::Init();*/
@@ -32,6 +39,7 @@ namespace Coffee
 
     Application::~Application()
     {
+        JobSystem::Shutdown();
     }
 
     void Application::PushLayer(Layer* layer)
@@ -90,6 +98,12 @@ namespace Coffee
             //Poll and handle events
             ProcessEvents();
 
+            //Create the GPU objects of the resources loaded on job threads
+            UploadQueue::Flush(UploadQueue::GetFrameBudget());
+
+            //Evict the unused resources once over the memory budget
+            ResourceLoader::EnforceMemoryBudget();
+
             //Update and render
             {
                 ZoneScopedN("LayerStack Update");
@@ -12,16 +12,24 @@ namespace Coffee
 
     glm::mat4 Billboard::CalculateTransform(const glm::vec3& cameraPosition, const glm::vec3& cameraUp)
     {
+        glm::mat4 transform = glm::mat4(1.0f);
         switch (m_Type)
         {
         case BillboardType::SCREEN_ALIGNED:
-            return CalculateScreenAligned(cameraPosition, cameraUp);
+            transform = CalculateScreenAligned(cameraPosition, cameraUp);
+            break;
         case BillboardType::WORLD_ALIGNED:
-            return CalculateWorldAligned(cameraPosition, cameraUp);
+            transform = CalculateWorldAligned(cameraPosition, cameraUp);
+            break;
         case BillboardType::AXIS_ALIGNED:
-            return CalculateAxisAligned(cameraPosition);
+            transform = CalculateAxisAligned(cameraPosition);
+            break;
         }
-        return glm::mat4(1.0f);
+
+        if (m_Rotation != 0.0f)
+            transform = glm::rotate(transform, m_Rotation, glm::vec3(0.0f, 0.0f, 1.0f));
+
+        return transform;
     }
 
     glm::mat4 Billboard::CalculateScreenAligned(const glm::vec3& cameraPosition, const glm::vec3& cameraUp)
@@ -27,12 +27,14 @@ namespace Coffee
         void SetType(BillboardType type) { m_Type = type; }
         void SetMaterial(const Ref<Material>& material) { m_Material = material; }
         void SetColor(const glm::vec4& color) { m_Color = color; }
+        void SetRotation(float rotation) { m_Rotation = rotation; }
 
         const glm::vec4& GetColor() const { return m_Color; }
         const glm::vec3& GetPosition() const { return m_Position; }
         const glm::vec3& GetScale() const { return m_Scale; }
         BillboardType GetType() const { return m_Type; }
         const Ref<Material>& GetMaterial() const { return m_Material; }
+        float GetRotation() const { return m_Rotation; }
 
         glm::mat4 CalculateTransform(const glm::vec3& cameraPosition, const glm::vec3& cameraUp);
 
@@ -46,6 +48,7 @@ namespace Coffee
         glm::vec3 m_Scale = {1.0f, 1.0f, 1.0f};
         Ref<Material> m_Material;
         glm::vec4 m_Color = glm::vec4(1.0f);
+        float m_Rotation = 0.0f; ///< Rotation around the facing direction, in radians.
     };
 
 } // namespace Coffee
\ No newline at end of file
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup core Core
+     * @{
+     */
+
+    /**
+     * @brief Bump allocator that hands out memory from a list of fixed-size blocks.
+     *
+     * Allocations are never freed individually; the whole arena is released at once with Reset(),
+     * which is O(1) and keeps the blocks around so the next frame does not touch the heap again.
+     * Only trivially destructible types may be constructed in the arena since no destructors are run.
+     */
+    class LinearAllocator
+    {
+    public:
+        /**
+         * @brief Constructs the allocator.
+         * @param blockSize Size in bytes of each block requested from the heap.
+         */
+        explicit LinearAllocator(size_t blockSize = 64 * 1024) : m_BlockSize(blockSize) {}
+
+        LinearAllocator(const LinearAllocator&) = delete;
+        LinearAllocator& operator=(const LinearAllocator&) = delete;
+
+        LinearAllocator(LinearAllocator&&) noexcept = default;
+        LinearAllocator& operator=(LinearAllocator&&) noexcept = default;
+
+        /**
+         * @brief Allocates raw memory from the arena.
+         * @param size The number of bytes to allocate.
+         * @param alignment The required alignment, must be a power of two.
+         * @return A pointer to the allocated memory. Valid until the next Reset().
+         */
+        void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t))
+        {
+            while (m_CurrentBlock < m_Blocks.size())
+            {
+                Block& block = m_Blocks[m_CurrentBlock];
+                uintptr_t base = reinterpret_cast<uintptr_t>(block.Data.get());
+                uintptr_t aligned = (base + m_Offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+                size_t newOffset = (aligned - base) + size;
+
+                if (newOffset <= block.Size)
+                {
+                    m_Offset = newOffset;
+                    m_UsedBytes += size;
+                    return reinterpret_cast<void*>(aligned);
+                }
+
+                // The current block is exhausted, continue with the next one kept from previous frames
+                m_CurrentBlock++;
+                m_Offset = 0;
+            }
+
+            // Every block is in use, grow the arena. Oversized requests get a dedicated block.
+            size_t blockSize = std::max(m_BlockSize, size + alignment);
+            m_Blocks.push_back({std::make_unique<std::byte[]>(blockSize), blockSize});
+            m_CurrentBlock = m_Blocks.size() - 1;
+            m_Offset = 0;
+            m_Capacity += blockSize;
+
+            return Allocate(size, alignment);
+        }
+
+        /**
+         * @brief Constructs an object inside the arena.
+         * @tparam T The type of the object, must be trivially destructible.
+         * @param args The constructor arguments.
+         * @return A pointer to the constructed object.
+         */
+        template <typename T, typename... Args>
+        T* New(Args&&... args)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "LinearAllocator never runs destructors");
+            return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Allocates uninitialized storage for an array of objects.
+         * @tparam T The element type, must be trivially destructible.
+         * @param count The number of elements.
+         * @return A pointer to the first element.
+         */
+        template <typename T>
+        T* AllocateArray(size_t count)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "LinearAllocator never runs destructors");
+            return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+        }
+
+        /**
+         * @brief Releases every allocation at once. The blocks are kept for reuse.
+         */
+        void Reset()
+        {
+            m_CurrentBlock = 0;
+            m_Offset = 0;
+            m_UsedBytes = 0;
+        }
+
+        /**
+         * @brief Gets the number of bytes handed out since the last Reset().
+         * @return The used bytes.
+         */
+        size_t GetUsedBytes() const { return m_UsedBytes; }
+
+        /**
+         * @brief Gets the total number of bytes owned by the arena.
+         * @return The capacity in bytes.
+         */
+        size_t GetCapacity() const { return m_Capacity; }
+
+    private:
+        struct Block
+        {
+            std::unique_ptr<std::byte[]> Data;
+            size_t Size;
+        };
+
+        std::vector<Block> m_Blocks;
+        size_t m_BlockSize;
+        size_t m_CurrentBlock = 0;
+        size_t m_Offset = 0;
+        size_t m_UsedBytes = 0;
+        size_t m_Capacity = 0;
+    };
+
+    /** @} */
+}
@@ -1,246 +1,891 @@
 #pragma once
 
 #include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Core/JobSystem.h"
 #include "CoffeeEngine/Math/BoundingBox.h"
 #include "CoffeeEngine/Math/Frustum.h"
+#include "CoffeeEngine/Math/FrustumCulling.h"
+#include "CoffeeEngine/Math/Ray.h"
 #include "CoffeeEngine/Renderer/Mesh.h"
 #include "CoffeeEngine/Renderer/DebugRenderer.h"
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <tracy/Tracy.hpp>
+#include <unordered_map>
 #include <vector>
-#include <memory>
 
 namespace Coffee {
 
+    /**
+     * @brief Entry of the octree, owned by value.
+     * @tparam T The handle type used to identify the object, usually an entity.
+     */
     template <typename T>
     struct ObjectContainer
     {
-        const glm::mat4& transform;
-        const AABB& aabb;
-        const T& object;
+        T object;  ///< The handle of the object.
+        AABB aabb; ///< The bounds of the object in world space.
     };
 
+    /**
+     * @brief Object hit by a ray query.
+     * @tparam T The handle type used to identify the object.
+     */
+    template <typename T>
+    struct OctreeRayHit
+    {
+        T object;       ///< The handle of the object.
+        float distance; ///< The distance along the ray where it enters the bounds of the object.
+    };
+
+    /**
+     * @brief Result of culling several views at once.
+     * @tparam T The handle type used to identify the objects.
+     */
+    template <typename T>
+    struct OctreeViewResults
+    {
+        std::vector<ObjectContainer<T>> objects; ///< The objects visible in at least one view.
+        std::vector<uint32_t> viewMasks;         ///< For each object, bit v is set if it is visible in view v.
+
+        void Clear()
+        {
+            objects.clear();
+            viewMasks.clear();
+        }
+    };
+
+    /**
+     * @brief Node of the octree, stored in the node pool of its tree and linked by index.
+     */
     template <typename T>
     class OctreeNode
     {
     public:
-        AABB aabb;
-        bool isLeaf = true;
-        std::vector<ObjectContainer<T>> objectList;
-        std::array<Scope<OctreeNode>, 8> children;
+        static constexpr uint32_t InvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        /**
+         * @brief Prepares the node for a new cell. The arrays are cleared but keep their capacity.
+         * @param cell The cell of the node.
+         * @param parentIndex The index of the parent, InvalidIndex for the root.
+         * @param nodeDepth The depth of the node.
+         */
+        void Reset(const AABB& cell, uint32_t parentIndex, int nodeDepth)
+        {
+            aabb = cell;
+
+            // Loose bounds, the cell grown by half its size on every side
+            glm::vec3 margin = cell.GetHalfSize();
+            looseAabb = AABB(cell.min - margin, cell.max + margin);
+
+            parent = parentIndex;
+            firstChild = InvalidIndex;
+            depth = nodeDepth;
+            subtreeCount = 0;
+            objects.clear();
+            bounds.Clear();
+            planeCache.clear();
+        }
+
+        AABB aabb;      ///< The cell of the node.
+        AABB looseAabb; ///< The bounds an object must fit in to be stored in the node.
+        uint32_t parent = InvalidIndex;
+        uint32_t firstChild = InvalidIndex; ///< Index of the first of the eight consecutive children, InvalidIndex for leaves.
+        int depth = 0;
+        uint32_t subtreeCount = 0; ///< Number of objects in this node and all its descendants.
+        std::vector<T> objects;    ///< The objects stored in the node.
+        BoundsSoA bounds;          ///< The world bounds of each object, in the same order.
+        mutable std::vector<uint8_t> planeCache; ///< Last plane that culled each group of four objects.
 
-        void DebugDrawAABB();
-        int GetChildIndex(const AABB& bounds, const glm::vec3& point) const;
+        bool IsLeaf() const { return firstChild == InvalidIndex; }
+
+        void Add(const ObjectContainer<T>& object)
+        {
+            objects.push_back(object.object);
+            bounds.PushBack(object.aabb);
+        }
+
+        void RemoveAt(uint32_t index)
+        {
+            objects[index] = objects.back();
+            objects.pop_back();
+            bounds.SwapRemove(index);
+        }
+
+        uint32_t IndexOf(const T& object) const
+        {
+            return static_cast<uint32_t>(std::find(objects.begin(), objects.end(), object) - objects.begin());
+        }
+
+        int GetChildIndex(const glm::vec3& point) const;
     };
 
+    /**
+     * @brief Dynamic loose octree.
+     *
+     * Objects are identified by a handle and stored with a copy of their world bounds, so the tree never points
+     * into external storage. An object goes down to the deepest node whose loose bounds (the cell grown by half
+     * its size) contain it; objects too big for any child, or outside of the root, stay in the node above. The
+     * loose bounds let an object move a bit without changing node, which keeps Update() cheap for moving
+     * objects, and empty subtrees are released as objects leave them.
+     *
+     * The nodes live in a single pool and link to each other by index, the eight children of a node being
+     * consecutive. Released children go to a free list and are reused with the capacity of their arrays, so
+     * once the tree has warmed up, moving objects and querying do not allocate. Queries either append to a
+     * buffer owned by the caller or invoke a visitor, visitor(const T& object, const AABB& bounds).
+     *
+     * The bounds of each node are kept as structure of arrays and frustum queries test them in batches with
+     * FrustumCulling, skipping the planes the node is already completely inside of. Frustum queries update
+     * per node caches, so they must not run concurrently.
+     *
+     * @tparam T The handle type, it must be hashable.
+     */
     template <typename T>
     class Octree
     {
     public:
-        Octree();
+        static constexpr uint32_t RootIndex = 0;
+        static constexpr uint32_t MaxViews = 32; ///< Maximum number of views of QueryViews, one bit of the view masks each.
+
         Octree(const AABB& bounds, int maxObjectsPerNode = 8, int maxDepth = 5);
-        ~Octree();
 
         void Insert(const ObjectContainer<T>& object);
+
+        /**
+         * @brief Inserts an object, or moves it if it is already in the tree.
+         * @param object The handle of the object.
+         * @param aabb The bounds of the object in world space.
+         */
+        void Update(const T& object, const AABB& aabb);
+
+        /**
+         * @brief Removes an object.
+         * @param object The handle of the object.
+         * @return False if the object was not in the tree.
+         */
+        bool Remove(const T& object);
+
+        bool Contains(const T& object) const { return locations.contains(object); }
+        size_t Size() const { return locations.size(); }
+
+        /**
+         * @brief Gets the number of nodes in use, the released ones excluded.
+         */
+        size_t GetNodeCount() const { return nodes.size() - freeBlocks.size() * 8; }
+
         void DebugDraw();
+
+        /**
+         * @brief Removes every object and releases all the nodes but the root.
+         */
         void Clear();
 
-        std::vector<ObjectContainer<T>> Query(const Frustum& frustum) const;
+        /**
+         * @brief Appends the objects whose bounds are inside or intersect a frustum.
+         * @param frustum The frustum.
+         * @param results The buffer to append to, it is not cleared.
+         */
+        void Query(const Frustum& frustum, std::vector<ObjectContainer<T>>& results) const;
+
+        template <typename Visitor>
+        void Query(const Frustum& frustum, Visitor&& visitor) const;
+
+        /**
+         * @brief Appends the objects whose bounds overlap a box.
+         * @param aabb The box in world space.
+         * @param results The buffer to append to, it is not cleared.
+         */
+        void Query(const AABB& aabb, std::vector<ObjectContainer<T>>& results) const;
+
+        template <typename Visitor>
+        void Query(const AABB& aabb, Visitor&& visitor) const;
+
+        /**
+         * @brief Appends the objects whose bounds overlap a sphere.
+         * @param center The center of the sphere in world space.
+         * @param radius The radius of the sphere.
+         * @param results The buffer to append to, it is not cleared.
+         */
+        void Query(const glm::vec3& center, float radius, std::vector<ObjectContainer<T>>& results) const;
+
+        template <typename Visitor>
+        void Query(const glm::vec3& center, float radius, Visitor&& visitor) const;
+
+        /**
+         * @brief Appends the objects whose bounds are hit by a ray.
+         * @param ray The ray in world space.
+         * @param maxDistance The maximum distance along the ray.
+         * @param results The buffer to append to, it is not cleared. The appended hits are sorted from the
+         * closest to the farthest.
+         */
+        void Raycast(const Ray& ray, float maxDistance, std::vector<OctreeRayHit<T>>& results) const;
+
+        /**
+         * @brief Culls the objects against several frusta in a single traversal.
+         *
+         * The tree is traversed once, each node being classified against the views that still see its parent,
+         * and the objects of the nodes seen by any view are gathered. Then every view tests the bounds of the
+         * nodes it sees on its own job, and the visibility bits of the views are merged into one mask per
+         * object. The plane caches of the nodes are not used, they belong to the single view queries.
+         *
+         * @param frusta The frusta of the views, for example split-screen cameras or shadow cascades.
+         * @param viewCount The number of views, at most MaxViews.
+         * @param results Replaced with the objects visible in at least one view and their view masks.
+         */
+        void QueryViews(const Frustum* frusta, uint32_t viewCount, OctreeViewResults<T>& results) const;
 
     private:
-        void Insert(OctreeNode<T>& node, const ObjectContainer<T>& object);
-        void InsertIntoLeaf(OctreeNode<T>& node, const ObjectContainer<T>& object);
-        void InsertIntoChild(OctreeNode<T>& node, const ObjectContainer<T>& object);
-        void RedistributeObjects(OctreeNode<T>& node);
-        void Subdivide(OctreeNode<T>& node);
-        void CreateChildren(OctreeNode<T>& node, const glm::vec3& center);
-
-        void Query(const OctreeNode<T>& node, const Frustum& frustum, std::vector<ObjectContainer<T>>& results) const;
-
-        OctreeNode<T> rootNode;
+        void Insert(uint32_t nodeIndex, const ObjectContainer<T>& object);
+        void RedistributeObjects(uint32_t nodeIndex);
+        void Subdivide(uint32_t nodeIndex);
+        void Collapse(uint32_t nodeIndex);
+
+        /**
+         * @brief Takes a block of eight nodes from the free list, or grows the pool.
+         * @return The index of the first node of the block.
+         */
+        uint32_t AllocateChildren();
+
+        /**
+         * @brief Returns the children of a node, and all their descendants, to the free list.
+         */
+        void FreeChildren(uint32_t nodeIndex);
+
+        /**
+         * @brief Gets the child of a subdivided node an object fits in.
+         * @return The child index, or -1 if the object has to stay in the node.
+         */
+        int GetFittingChild(const OctreeNode<T>& node, const AABB& aabb) const;
+
+        template <typename Visitor>
+        void Query(uint32_t nodeIndex, const glm::vec4* planes, uint32_t planeMask, Visitor& visitor) const;
+
+        template <typename Visitor>
+        void CollectAll(uint32_t nodeIndex, Visitor& visitor) const;
+
+        /**
+         * @brief Visits the objects of the nodes whose loose bounds pass a test.
+         * @param nodeTest Called with the loose bounds of a node, false skips the node and its descendants.
+         * @param visitor Called with each object and its bounds in the nodes that passed.
+         */
+        template <typename NodeTest, typename Visitor>
+        void VisitNodes(uint32_t nodeIndex, const NodeTest& nodeTest, Visitor& visitor) const;
+
+        /**
+         * @brief Gathers the objects of the nodes seen by any of the views of QueryViews.
+         * @param activeViews Bit v is set if view v sees the parent node.
+         * @param planeMasks The planes each view still has to test, as left by the parent node.
+         */
+        void GatherViews(uint32_t nodeIndex, const Frustum* frusta, uint32_t viewCount, uint32_t activeViews,
+                         const uint8_t* planeMasks, OctreeViewResults<T>& results) const;
+
+        void DebugDraw(uint32_t nodeIndex);
+
+        /**
+         * @brief Node gathered by QueryViews.
+         */
+        struct ViewNode
+        {
+            uint32_t node;        ///< The index of the node.
+            uint32_t firstObject; ///< The index of its first object in the gathered objects.
+            uint32_t activeViews; ///< Bit v is set if view v sees the node.
+        };
+
+        std::vector<OctreeNode<T>> nodes;           ///< Node pool, the root is the first node.
+        std::vector<uint32_t> freeBlocks;           ///< First index of each released block of eight nodes.
+        std::unordered_map<T, uint32_t> locations;  ///< Index of the node holding each object.
+        mutable std::vector<uint64_t> visibility;   ///< Scratch bitset of the frustum queries.
+
+        // Scratch buffers of QueryViews
+        mutable std::vector<ViewNode> viewNodes;                     ///< The nodes seen by any view.
+        mutable std::vector<uint8_t> viewPlaneMasks;                 ///< Plane masks of each view for each gathered node.
+        mutable std::vector<std::vector<uint64_t>> viewVisibility;   ///< Per view bitset over the gathered objects.
+        mutable std::vector<std::vector<uint64_t>> viewNodeVisibility; ///< Per view bitset of the node being tested.
         int maxObjectsPerNode;
         int maxDepth;
     };
 
+    static inline bool ContainsAABB(const AABB& outer, const AABB& inner)
+    {
+        return glm::all(glm::greaterThanEqual(inner.min, outer.min)) && glm::all(glm::lessThanEqual(inner.max, outer.max));
+    }
+
+    template <typename T>
+    int OctreeNode<T>::GetChildIndex(const glm::vec3& point) const
+    {
+        glm::vec3 center = (aabb.min + aabb.max) * 0.5f;
+        int index = 0;
+        if (point.x > center.x) index |= 1;
+        if (point.y > center.y) index |= 2;
+        if (point.z > center.z) index |= 4;
+        return index;
+    }
+
     template <typename T>
-    void Octree<T>::Insert(OctreeNode<T>& node, const ObjectContainer<T>& object)
+    Octree<T>::Octree(const AABB& bounds, int maxObjectsPerNode, int maxDepth)
+        : nodes(1), maxObjectsPerNode(maxObjectsPerNode), maxDepth(maxDepth)
     {
-        AABB objectTransformedAABB = object.aabb.CalculateTransformedAABB(object.transform);
+        nodes[RootIndex].Reset(bounds, OctreeNode<T>::InvalidIndex, 0);
+    }
 
-        switch (node.aabb.Intersect(objectTransformedAABB))
+    template <typename T>
+    int Octree<T>::GetFittingChild(const OctreeNode<T>& node, const AABB& aabb) const
+    {
+        int childIndex = node.GetChildIndex(aabb.GetCenter());
+        return ContainsAABB(nodes[node.firstChild + childIndex].looseAabb, aabb) ? childIndex : -1;
+    }
+
+    template <typename T>
+    void Octree<T>::Insert(uint32_t nodeIndex, const ObjectContainer<T>& object)
+    {
+        uint32_t target = nodeIndex;
+        while (!nodes[target].IsLeaf())
         {
-            using enum IntersectionType;
-            case Outside:
-                return;
-            case Inside:
-            case Intersect:
-                if (node.isLeaf)
-                {
-                    InsertIntoLeaf(node, object);
-                }
-                else
-                {
-                    InsertIntoChild(node, object);
-                }
+            int childIndex = GetFittingChild(nodes[target], object.aabb);
+            if (childIndex < 0)
+                break;
+
+            target = nodes[target].firstChild + childIndex;
+        }
+
+        nodes[target].Add(object);
+        locations[object.object] = target;
+
+        for (uint32_t n = target; n != OctreeNode<T>::InvalidIndex; n = nodes[n].parent)
+        {
+            nodes[n].subtreeCount++;
+        }
+
+        if (nodes[target].IsLeaf() && nodes[target].objects.size() > maxObjectsPerNode && nodes[target].depth < maxDepth)
+        {
+            Subdivide(target);
+            RedistributeObjects(target);
         }
     }
 
     template <typename T>
-    void Octree<T>::InsertIntoLeaf(OctreeNode<T>& node, const ObjectContainer<T>& object) {
-        node.objectList.push_back(object);
-        if (node.objectList.size() > maxObjectsPerNode && maxDepth > 0) {
-            Subdivide(node);
-            RedistributeObjects(node);
+    void Octree<T>::RedistributeObjects(uint32_t nodeIndex)
+    {
+        // Nothing is allocated in the pool until the recursion, so the references stay valid
+        OctreeNode<T>& node = nodes[nodeIndex];
+
+        for (uint32_t i = 0; i < node.objects.size();)
+        {
+            int childIndex = GetFittingChild(node, node.bounds.Get(i));
+            if (childIndex < 0)
+            {
+                ++i;
+                continue;
+            }
+
+            uint32_t targetIndex = node.firstChild + childIndex;
+            OctreeNode<T>& target = nodes[targetIndex];
+            target.objects.push_back(node.objects[i]);
+            target.bounds.PushBack(node.bounds, i);
+            target.subtreeCount++;
+            locations[node.objects[i]] = targetIndex;
+
+            node.RemoveAt(i);
+        }
+
+        const uint32_t firstChild = node.firstChild;
+        for (uint32_t child = firstChild; child < firstChild + 8; ++child)
+        {
+            if (nodes[child].objects.size() > maxObjectsPerNode && nodes[child].depth < maxDepth)
+            {
+                Subdivide(child);
+                RedistributeObjects(child);
+            }
         }
     }
 
     template <typename T>
-    void Octree<T>::InsertIntoChild(OctreeNode<T>& node, const ObjectContainer<T>& object) {
-        int childIndex = node.GetChildIndex(node.aabb, object.transform[3]);
-        Insert(*node.children[childIndex], object);
+    void Octree<T>::Insert(const ObjectContainer<T>& object) {
+        if (locations.contains(object.object)) {
+            Update(object.object, object.aabb);
+            return;
+        }
+
+        Insert(RootIndex, object);
     }
 
     template <typename T>
-    void Octree<T>::RedistributeObjects(OctreeNode<T>& node) {
-        for (const auto& obj : node.objectList) {
-            int childIndex = node.GetChildIndex(node.aabb, obj.transform[3]);
-            Insert(*node.children[childIndex], obj);
+    void Octree<T>::Update(const T& object, const AABB& aabb)
+    {
+        auto it = locations.find(object);
+        if (it == locations.end())
+        {
+            Insert(RootIndex, {object, aabb});
+            return;
         }
-        node.objectList.clear();
+
+        OctreeNode<T>& node = nodes[it->second];
+
+        // Objects outside of the root stay in it, the rest stay while they fit and cannot go any deeper
+        bool fitsNode = it->second == RootIndex || ContainsAABB(node.looseAabb, aabb);
+        if (fitsNode && (node.IsLeaf() || GetFittingChild(node, aabb) < 0))
+        {
+            node.bounds.Set(node.IndexOf(object), aabb);
+            return;
+        }
+
+        Remove(object);
+        Insert(RootIndex, {object, aabb});
     }
 
     template <typename T>
-    void Octree<T>::Insert(const ObjectContainer<T>& object) {
-        Insert(rootNode, object);
+    bool Octree<T>::Remove(const T& object)
+    {
+        auto it = locations.find(object);
+        if (it == locations.end())
+            return false;
+
+        uint32_t nodeIndex = it->second;
+        locations.erase(it);
+
+        OctreeNode<T>& node = nodes[nodeIndex];
+        node.RemoveAt(node.IndexOf(object));
+
+        for (uint32_t n = nodeIndex; n != OctreeNode<T>::InvalidIndex; n = nodes[n].parent)
+        {
+            nodes[n].subtreeCount--;
+        }
+
+        Collapse(nodeIndex);
+        return true;
     }
 
     template <typename T>
-    void Octree<T>::Subdivide(OctreeNode<T>& node)
+    void Octree<T>::Collapse(uint32_t nodeIndex)
     {
-        glm::vec3 center = (node.aabb.min + node.aabb.max) * 0.5f;
-        CreateChildren(node, center);
-        node.isLeaf = false;
+        // Release the children of every ancestor whose subtree only has objects in the node itself
+        uint32_t emptiest = OctreeNode<T>::InvalidIndex;
+        for (uint32_t n = nodeIndex; n != OctreeNode<T>::InvalidIndex; n = nodes[n].parent)
+        {
+            if (!nodes[n].IsLeaf() && nodes[n].subtreeCount == nodes[n].objects.size())
+                emptiest = n;
+        }
+
+        if (emptiest != OctreeNode<T>::InvalidIndex)
+        {
+            FreeChildren(emptiest);
+        }
     }
 
     template <typename T>
-    void Octree<T>::CreateChildren(OctreeNode<T>& node, const glm::vec3& center) {
-        node.children[0] = CreateScope<OctreeNode<T>>(AABB(node.aabb.min, center));
-        node.children[1] = CreateScope<OctreeNode<T>>(AABB(glm::vec3(center.x, node.aabb.min.y, node.aabb.min.z),
-                                                        glm::vec3(node.aabb.max.x, center.y, center.z)));
-        node.children[2] = CreateScope<OctreeNode<T>>(AABB(glm::vec3(node.aabb.min.x, center.y, node.aabb.min.z),
-                                                        glm::vec3(center.x, node.aabb.max.y, center.z)));
-        node.children[3] = CreateScope<OctreeNode<T>>(AABB(glm::vec3(center.x, center.y, node.aabb.min.z),
-                                                        glm::vec3(node.aabb.max.x, node.aabb.max.y, center.z)));
-        node.children[4] = CreateScope<OctreeNode<T>>(AABB(glm::vec3(node.aabb.min.x, node.aabb.min.y, center.z),
-                                                        glm::vec3(center.x, center.y, node.aabb.max.z)));
-        node.children[5] = CreateScope<OctreeNode<T>>(AABB(glm::vec3(center.x, node.aabb.min.y, center.z),
-                                                        glm::vec3(node.aabb.max.x, center.y, node.aabb.max.z)));
-        node.children[6] = CreateScope<OctreeNode<T>>(AABB(glm::vec3(node.aabb.min.x, center.y, center.z),
-                                                        glm::vec3(center.x, node.aabb.max.y, node.aabb.max.z)));
-        node.children[7] = CreateScope<OctreeNode<T>>(AABB(center, node.aabb.max));
+    uint32_t Octree<T>::AllocateChildren()
+    {
+        if (!freeBlocks.empty())
+        {
+            uint32_t firstChild = freeBlocks.back();
+            freeBlocks.pop_back();
+            return firstChild;
+        }
+
+        uint32_t firstChild = static_cast<uint32_t>(nodes.size());
+        nodes.resize(nodes.size() + 8);
+        return firstChild;
     }
 
     template <typename T>
-    void Octree<T>::Query(const OctreeNode<T>& node, const Frustum& frustum, std::vector<ObjectContainer<T>>& results) const
+    void Octree<T>::FreeChildren(uint32_t nodeIndex)
     {
-        if (!frustum.Contains(node.aabb))
+        const uint32_t firstChild = nodes[nodeIndex].firstChild;
+        for (uint32_t child = firstChild; child < firstChild + 8; ++child)
+        {
+            if (!nodes[child].IsLeaf())
+                FreeChildren(child);
+        }
+
+        freeBlocks.push_back(firstChild);
+        nodes[nodeIndex].firstChild = OctreeNode<T>::InvalidIndex;
+    }
+
+    template <typename T>
+    void Octree<T>::Subdivide(uint32_t nodeIndex)
+    {
+        // Allocating can grow the pool, so the node is only accessed afterwards
+        const uint32_t firstChild = AllocateChildren();
+        OctreeNode<T>& node = nodes[nodeIndex];
+        node.firstChild = firstChild;
+
+        const AABB& cell = node.aabb;
+        const glm::vec3 center = (cell.min + cell.max) * 0.5f;
+        const int depth = node.depth + 1;
+
+        // Child i is on the max side of the axes whose bit is set, matching GetChildIndex
+        for (int i = 0; i < 8; ++i)
+        {
+            glm::vec3 min((i & 1) ? center.x : cell.min.x, (i & 2) ? center.y : cell.min.y, (i & 4) ? center.z : cell.min.z);
+            glm::vec3 max((i & 1) ? cell.max.x : center.x, (i & 2) ? cell.max.y : center.y, (i & 4) ? cell.max.z : center.z);
+            nodes[firstChild + i].Reset(AABB(min, max), nodeIndex, depth);
+        }
+    }
+
+    template <typename T>
+    template <typename Visitor>
+    void Octree<T>::Query(uint32_t nodeIndex, const glm::vec4* planes, uint32_t planeMask, Visitor& visitor) const
+    {
+        const OctreeNode<T>& node = nodes[nodeIndex];
+        if (node.subtreeCount == 0)
             return;
 
-        for (const auto& object : node.objectList)
+        // The root also keeps the objects outside of its bounds, so it is always visited
+        if (nodeIndex != RootIndex && FrustumCulling::Classify(planes, node.looseAabb, planeMask) == IntersectionType::Outside)
+            return;
+
+        // Completely inside the frustum, nothing below needs to be tested
+        if (planeMask == 0)
+        {
+            CollectAll(nodeIndex, visitor);
+            return;
+        }
+
+        const uint32_t count = static_cast<uint32_t>(node.objects.size());
+        if (count > 0)
+        {
+            const uint32_t wordCount = FrustumCulling::GetVisibilityWordCount(count);
+            visibility.resize(std::max<size_t>(visibility.size(), wordCount));
+            node.planeCache.resize(FrustumCulling::GetPlaneCacheSize(count), 0);
+
+            FrustumCulling::CullBounds(planes, planeMask, node.bounds, visibility.data(), node.planeCache.data());
+
+            for (uint32_t word = 0; word < wordCount; ++word)
+            {
+                for (uint64_t bits = visibility[word]; bits != 0; bits &= bits - 1)
+                {
+                    uint32_t i = word * 64 + static_cast<uint32_t>(std::countr_zero(bits));
+                    visitor(node.objects[i], node.bounds.Get(i));
+                }
+            }
+        }
+
+        if (node.IsLeaf())
+            return;
+
+        for (uint32_t child = node.firstChild; child < node.firstChild + 8; ++child)
+        {
+            Query(child, planes, planeMask, visitor);
+        }
+    }
+
+    template <typename T>
+    template <typename Visitor>
+    void Octree<T>::CollectAll(uint32_t nodeIndex, Visitor& visitor) const
+    {
+        const OctreeNode<T>& node = nodes[nodeIndex];
+        for (uint32_t i = 0; i < node.objects.size(); ++i)
+        {
+            visitor(node.objects[i], node.bounds.Get(i));
+        }
+
+        if (node.IsLeaf())
+            return;
+
+        for (uint32_t child = node.firstChild; child < node.firstChild + 8; ++child)
+        {
+            if (nodes[child].subtreeCount > 0)
+                CollectAll(child, visitor);
+        }
+    }
+
+    template <typename T>
+    template <typename NodeTest, typename Visitor>
+    void Octree<T>::VisitNodes(uint32_t nodeIndex, const NodeTest& nodeTest, Visitor& visitor) const
+    {
+        const OctreeNode<T>& node = nodes[nodeIndex];
+        if (node.subtreeCount == 0)
+            return;
+
+        // The root also keeps the objects outside of its bounds, so it is always visited
+        if (nodeIndex != RootIndex && !nodeTest(node.looseAabb))
+            return;
+
+        for (uint32_t i = 0; i < node.objects.size(); ++i)
         {
-            if (frustum.Contains(object.aabb.CalculateTransformedAABB(object.transform)))
-                results.push_back(object);
+            visitor(node.objects[i], node.bounds.Get(i));
         }
-    
-        if (node.isLeaf)
+
+        if (node.IsLeaf())
             return;
-    
-        for (const auto& child : node.children)
+
+        for (uint32_t child = node.firstChild; child < node.firstChild + 8; ++child)
         {
-            if (child)
+            VisitNodes(child, nodeTest, visitor);
+        }
+    }
+
+    template <typename T>
+    void Octree<T>::GatherViews(uint32_t nodeIndex, const Frustum* frusta, uint32_t viewCount, uint32_t activeViews,
+                                const uint8_t* planeMasks, OctreeViewResults<T>& results) const
+    {
+        const OctreeNode<T>& node = nodes[nodeIndex];
+        if (node.subtreeCount == 0)
+            return;
+
+        uint8_t nodePlaneMasks[MaxViews];
+        std::copy_n(planeMasks, viewCount, nodePlaneMasks);
+
+        // The root also keeps the objects outside of its bounds, so it is always visited
+        if (nodeIndex != RootIndex)
+        {
+            for (uint32_t views = activeViews; views != 0; views &= views - 1)
             {
-                Query(*child, frustum, results);
+                uint32_t view = static_cast<uint32_t>(std::countr_zero(views));
+                uint32_t planeMask = nodePlaneMasks[view];
+
+                if (FrustumCulling::Classify(frusta[view].GetPlanes(), node.looseAabb, planeMask) == IntersectionType::Outside)
+                    activeViews &= ~(1u << view);
+
+                nodePlaneMasks[view] = static_cast<uint8_t>(planeMask);
             }
+
+            if (activeViews == 0)
+                return;
+        }
+
+        if (!node.objects.empty())
+        {
+            viewNodes.push_back({nodeIndex, static_cast<uint32_t>(results.objects.size()), activeViews});
+            viewPlaneMasks.insert(viewPlaneMasks.end(), nodePlaneMasks, nodePlaneMasks + viewCount);
+
+            for (uint32_t i = 0; i < node.objects.size(); ++i)
+            {
+                results.objects.push_back({node.objects[i], node.bounds.Get(i)});
+            }
+        }
+
+        if (node.IsLeaf())
+            return;
+
+        for (uint32_t child = node.firstChild; child < node.firstChild + 8; ++child)
+        {
+            GatherViews(child, frusta, viewCount, activeViews, nodePlaneMasks, results);
         }
     }
 
     template <typename T>
-    void OctreeNode<T>::DebugDrawAABB()
+    void Octree<T>::DebugDraw(uint32_t nodeIndex)
     {
-        // Assuming you have a function to get the number of objects in the node
-        int numObjects = objectList.size();
+        const OctreeNode<T>& node = nodes[nodeIndex];
 
         // Calculate the color based on the number of objects
+        int numObjects = node.objects.size();
         float green = glm::clamp(numObjects / 10.0f, 0.0f, 1.0f);
         float red = glm::clamp(1.0f - (numObjects / 10.0f), 0.0f, 1.0f);
         glm::vec4 color(red, green, 0.0f, 1.0f);
 
         // Draw the box with the calculated color
-        DebugRenderer::DrawBox(aabb.min, aabb.max, color);
-        if (!isLeaf)
+        DebugRenderer::DrawBox(node.aabb.min, node.aabb.max, color);
+        if (!node.IsLeaf())
         {
-            for (auto& child : children)
+            for (uint32_t child = node.firstChild; child < node.firstChild + 8; ++child)
             {
-                if (child)
+                if (nodes[child].subtreeCount > 0)
                 {
-                    child->DebugDrawAABB();
+                    DebugDraw(child);
                 }
             }
         }
 
-        for (auto& obj : objectList)
+        for (uint32_t i = 0; i < node.bounds.Size(); ++i)
         {
-            AABB aabb = obj.aabb.CalculateTransformedAABB(obj.transform);
+            AABB aabb = node.bounds.Get(i);
             DebugRenderer::DrawBox(aabb.min, aabb.max, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
         }
     }
 
     template <typename T>
-    int OctreeNode<T>::GetChildIndex(const AABB& bounds, const glm::vec3& point) const
+    void Octree<T>::DebugDraw()
     {
-        glm::vec3 center = (bounds.min + bounds.max) * 0.5f;
-        int index = 0;
-        if (point.x > center.x) index |= 1;
-        if (point.y > center.y) index |= 2;
-        if (point.z > center.z) index |= 4;
-        return index;
+        DebugDraw(RootIndex);
     }
 
     template <typename T>
-    Octree<T>::Octree(const AABB& bounds, int maxObjectsPerNode, int maxDepth) : maxObjectsPerNode(maxObjectsPerNode), maxDepth(maxDepth)
+    void Octree<T>::Clear()
     {
-        rootNode.aabb = bounds;
+        AABB bounds = nodes[RootIndex].aabb;
+
+        // Drop the whole pool, so the memory of every descendant and of their arrays is released
+        nodes.clear();
+        nodes.shrink_to_fit();
+        nodes.resize(1);
+        nodes[RootIndex].Reset(bounds, OctreeNode<T>::InvalidIndex, 0);
+
+        freeBlocks.clear();
+        locations.clear();
     }
 
     template <typename T>
-    Octree<T>::~Octree()
+    template <typename Visitor>
+    void Octree<T>::Query(const Frustum& frustum, Visitor&& visitor) const
     {
-        Clear();
+        Query(RootIndex, frustum.GetPlanes(), FrustumCulling::AllPlanes, visitor);
     }
 
     template <typename T>
-    void Octree<T>::DebugDraw()
+    void Octree<T>::Query(const Frustum& frustum, std::vector<ObjectContainer<T>>& results) const
     {
-        rootNode.DebugDrawAABB();
+        Query(frustum, [&](const T& object, const AABB& bounds) { results.push_back({object, bounds}); });
     }
 
     template <typename T>
-    void Octree<T>::Clear()
+    template <typename Visitor>
+    void Octree<T>::Query(const AABB& aabb, Visitor&& visitor) const
     {
-        rootNode.objectList.clear();
-        for (auto& child : rootNode.children) {
-            if (child) {
-                child->objectList.clear();
-                child.reset();
-            }
-        }
-        rootNode.isLeaf = true;
+        auto overlaps = [&](const AABB& bounds) { return aabb.Intersect(bounds) != IntersectionType::Outside; };
+        auto filter = [&](const T& object, const AABB& bounds) {
+            if (overlaps(bounds))
+                visitor(object, bounds);
+        };
+
+        VisitNodes(RootIndex, overlaps, filter);
     }
 
     template <typename T>
-    std::vector<ObjectContainer<T>> Octree<T>::Query(const Frustum& frustum) const
+    void Octree<T>::Query(const AABB& aabb, std::vector<ObjectContainer<T>>& results) const
     {
-        std::vector<ObjectContainer<T>> results;
-        Query(rootNode, frustum, results);
-        return results;
+        Query(aabb, [&](const T& object, const AABB& bounds) { results.push_back({object, bounds}); });
+    }
+
+    template <typename T>
+    template <typename Visitor>
+    void Octree<T>::Query(const glm::vec3& center, float radius, Visitor&& visitor) const
+    {
+        auto overlaps = [&](const AABB& bounds) { return bounds.OverlapsSphere(center, radius); };
+        auto filter = [&](const T& object, const AABB& bounds) {
+            if (overlaps(bounds))
+                visitor(object, bounds);
+        };
+
+        VisitNodes(RootIndex, overlaps, filter);
+    }
+
+    template <typename T>
+    void Octree<T>::Query(const glm::vec3& center, float radius, std::vector<ObjectContainer<T>>& results) const
+    {
+        Query(center, radius, [&](const T& object, const AABB& bounds) { results.push_back({object, bounds}); });
+    }
+
+    template <typename T>
+    void Octree<T>::Raycast(const Ray& ray, float maxDistance, std::vector<OctreeRayHit<T>>& results) const
+    {
+        const size_t first = results.size();
+        float distance;
+
+        auto hits = [&](const AABB& bounds) { return ray.Intersect(bounds, maxDistance, distance); };
+        auto collect = [&](const T& object, const AABB& bounds) {
+            if (hits(bounds))
+                results.push_back({object, distance});
+        };
+
+        VisitNodes(RootIndex, hits, collect);
+
+        std::sort(results.begin() + first, results.end(),
+                  [](const OctreeRayHit<T>& a, const OctreeRayHit<T>& b) { return a.distance < b.distance; });
+    }
+
+    template <typename T>
+    void Octree<T>::QueryViews(const Frustum* frusta, uint32_t viewCount, OctreeViewResults<T>& results) const
+    {
+        ZoneScoped;
+
+        results.Clear();
+        viewNodes.clear();
+        viewPlaneMasks.clear();
+
+        viewCount = std::min(viewCount, MaxViews);
+        if (viewCount == 0)
+            return;
+
+        // Single traversal, gathering the objects of the nodes any view sees
+        uint8_t planeMasks[MaxViews];
+        std::fill_n(planeMasks, viewCount, static_cast<uint8_t>(FrustumCulling::AllPlanes));
+        const uint32_t allViews = viewCount == 32 ? ~0u : (1u << viewCount) - 1;
+        GatherViews(RootIndex, frusta, viewCount, allViews, planeMasks, results);
+
+        const uint32_t objectCount = static_cast<uint32_t>(results.objects.size());
+        const uint32_t wordCount = FrustumCulling::GetVisibilityWordCount(objectCount);
+
+        if (viewVisibility.size() < viewCount)
+        {
+            viewVisibility.resize(viewCount);
+            viewNodeVisibility.resize(viewCount);
+        }
+
+        // Each view tests the objects of the nodes it sees on its own job, into its own bitset
+        JobSystem::ParallelFor(viewCount, 1, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+            ZoneScopedN("CullView");
+
+            for (uint32_t view = begin; view < end; ++view)
+            {
+                std::vector<uint64_t>& visible = viewVisibility[view];
+                std::vector<uint64_t>& nodeVisible = viewNodeVisibility[view];
+                visible.assign(wordCount, 0);
+
+                for (uint32_t n = 0; n < viewNodes.size(); ++n)
+                {
+                    const ViewNode& viewNode = viewNodes[n];
+                    if (!(viewNode.activeViews & (1u << view)))
+                        continue;
+
+                    const OctreeNode<T>& node = nodes[viewNode.node];
+                    const uint32_t count = static_cast<uint32_t>(node.objects.size());
+                    const uint32_t planeMask = viewPlaneMasks[n * viewCount + view];
+
+                    // Completely inside the view, every object is visible
+                    if (planeMask == 0)
+                    {
+                        for (uint32_t i = viewNode.firstObject; i < viewNode.firstObject + count; ++i)
+                            visible[i / 64] |= 1ull << (i % 64);
+                        continue;
+                    }
+
+                    const uint32_t nodeWordCount = FrustumCulling::GetVisibilityWordCount(count);
+                    nodeVisible.resize(std::max<size_t>(nodeVisible.size(), nodeWordCount));
+                    FrustumCulling::CullBounds(frusta[view].GetPlanes(), planeMask, node.bounds, nodeVisible.data());
+
+                    for (uint32_t word = 0; word < nodeWordCount; ++word)
+                    {
+                        for (uint64_t bits = nodeVisible[word]; bits != 0; bits &= bits - 1)
+                        {
+                            uint32_t i = viewNode.firstObject + word * 64 + static_cast<uint32_t>(std::countr_zero(bits));
+                            visible[i / 64] |= 1ull << (i % 64);
+                        }
+                    }
+                }
+            }
+        });
+
+        // Merge the bitsets into one mask per object
+        results.viewMasks.assign(objectCount, 0);
+        for (uint32_t view = 0; view < viewCount; ++view)
+        {
+            const std::vector<uint64_t>& visible = viewVisibility[view];
+            for (uint32_t word = 0; word < wordCount; ++word)
+            {
+                for (uint64_t bits = visible[word]; bits != 0; bits &= bits - 1)
+                {
+                    results.viewMasks[word * 64 + std::countr_zero(bits)] |= 1u << view;
+                }
+            }
+        }
+
+        // Drop the objects no view sees, keeping the traversal order
+        uint32_t kept = 0;
+        for (uint32_t i = 0; i < objectCount; ++i)
+        {
+            if (results.viewMasks[i] == 0)
+                continue;
+
+            results.objects[kept] = results.objects[i];
+            results.viewMasks[kept] = results.viewMasks[i];
+            ++kept;
+        }
+        results.objects.resize(kept);
+        results.viewMasks.resize(kept);
     }
 
-} // namespace Coffee
\ No newline at end of file
+} // namespace Coffee
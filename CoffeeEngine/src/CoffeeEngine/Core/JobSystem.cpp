@@ -0,0 +1,177 @@
+#include "JobSystem.h"
+#include "CoffeeEngine/Core/Log.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <tracy/Tracy.hpp>
+#include <vector>
+
+namespace Coffee {
+
+    uint32_t JobSystem::s_WorkerCount = 0;
+
+    // The counter of a job lets the threads waiting on it find it in the queue
+    struct QueuedJob
+    {
+        JobSystem::Job job;
+        const JobCounter* counter = nullptr;
+    };
+
+    static std::vector<std::thread> s_Workers;
+    static std::deque<QueuedJob> s_JobQueue;
+    static std::mutex s_QueueMutex;
+    static std::condition_variable s_QueueCondition;
+    static bool s_Stopping = false;
+
+    static thread_local uint32_t s_ThreadIndex = 0;
+
+    void JobSystem::Init(uint32_t workerCount)
+    {
+        ZoneScoped;
+
+        if (workerCount == 0)
+        {
+            uint32_t hardwareThreads = std::thread::hardware_concurrency();
+            workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+        }
+
+        s_Stopping = false;
+        s_WorkerCount = workerCount;
+
+        s_Workers.reserve(workerCount);
+        for (uint32_t i = 0; i < workerCount; ++i)
+        {
+            s_Workers.emplace_back(&JobSystem::WorkerLoop, i + 1);
+        }
+
+        COFFEE_CORE_INFO("JobSystem initialized with {0} worker threads", workerCount);
+    }
+
+    void JobSystem::Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(s_QueueMutex);
+            s_Stopping = true;
+        }
+        s_QueueCondition.notify_all();
+
+        for (auto& worker : s_Workers)
+        {
+            worker.join();
+        }
+
+        s_Workers.clear();
+        s_WorkerCount = 0;
+    }
+
+    void JobSystem::Execute(JobCounter& counter, Job job)
+    {
+        counter.Pending.fetch_add(1, std::memory_order_relaxed);
+
+        Push([&counter, job = std::move(job)]() {
+            job();
+            counter.Pending.fetch_sub(1, std::memory_order_release);
+        }, &counter);
+    }
+
+    void JobSystem::Execute(Job job)
+    {
+        Push(std::move(job), nullptr);
+    }
+
+    void JobSystem::Push(Job job, const JobCounter* counter)
+    {
+        if (s_WorkerCount == 0)
+        {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_QueueMutex);
+            s_JobQueue.push_back({std::move(job), counter});
+        }
+        s_QueueCondition.notify_one();
+    }
+
+    void JobSystem::Wait(const JobCounter& counter)
+    {
+        while (!counter.IsDone())
+        {
+            if (!RunPendingJob(counter))
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void JobSystem::Wait(const JobCounter& counter, const std::function<void()>& onIdle)
+    {
+        while (!counter.IsDone())
+        {
+            if (!RunPendingJob(counter))
+            {
+                std::this_thread::yield();
+            }
+
+            onIdle();
+        }
+    }
+
+    uint32_t JobSystem::GetThreadIndex()
+    {
+        return s_ThreadIndex;
+    }
+
+    bool JobSystem::RunPendingJob(const JobCounter& counter)
+    {
+        Job job;
+        {
+            std::lock_guard<std::mutex> lock(s_QueueMutex);
+
+            // Searched from the back, where the jobs of a ParallelFor were just pushed
+            auto it = std::find_if(s_JobQueue.rbegin(), s_JobQueue.rend(),
+                                   [&counter](const QueuedJob& queued) { return queued.counter == &counter; });
+            if (it == s_JobQueue.rend())
+                return false;
+
+            job = std::move(it->job);
+            s_JobQueue.erase(std::next(it).base());
+        }
+
+        job();
+        return true;
+    }
+
+    void JobSystem::WorkerLoop(uint32_t threadIndex)
+    {
+        s_ThreadIndex = threadIndex;
+
+        std::string threadName = "Worker " + std::to_string(threadIndex);
+        tracy::SetThreadName(threadName.c_str());
+
+        while (true)
+        {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(s_QueueMutex);
+                s_QueueCondition.wait(lock, [] { return s_Stopping || !s_JobQueue.empty(); });
+
+                // Drain the queue before stopping so nobody waits forever on a counter
+                if (s_JobQueue.empty())
+                    return;
+
+                job = std::move(s_JobQueue.front().job);
+                s_JobQueue.pop_front();
+            }
+
+            ZoneScopedN("Job");
+            job();
+        }
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace Coffee {
+
+    /**
+     * @defgroup core Core
+     * @{
+     */
+
+    /**
+     * @brief Tracks how many jobs of a group are still pending.
+     */
+    struct JobCounter
+    {
+        std::atomic<uint32_t> Pending = 0; ///< Number of jobs not finished yet.
+
+        /**
+         * @brief Checks whether every job of the group has finished.
+         * @return True if no job is pending.
+         */
+        bool IsDone() const { return Pending.load(std::memory_order_acquire) == 0; }
+    };
+
+    /**
+     * @brief Small thread pool shared by the engine systems.
+     *
+     * Jobs are pushed into a single FIFO queue consumed by the worker threads. A thread waiting on a
+     * counter helps running the queued jobs of that counter instead of blocking, so waiting on a frame's
+     * ParallelFor never picks up a long background load. If the system has not been initialized, or was
+     * initialized without workers, every job runs inline on the calling thread.
+     */
+    class JobSystem
+    {
+    public:
+        using Job = std::function<void()>;
+
+        /**
+         * @brief Starts the worker threads.
+         * @param workerCount The number of workers. 0 uses the hardware concurrency minus the main thread.
+         */
+        static void Init(uint32_t workerCount = 0);
+
+        /**
+         * @brief Finishes the queued jobs and joins the worker threads.
+         */
+        static void Shutdown();
+
+        /**
+         * @brief Queues a job.
+         * @param counter The counter incremented now and decremented when the job finishes.
+         * @param job The job to run.
+         */
+        static void Execute(JobCounter& counter, Job job);
+
+        /**
+         * @brief Queues a job nobody waits for.
+         * @param job The job to run.
+         */
+        static void Execute(Job job);
+
+        /**
+         * @brief Waits until every job tracked by the counter has finished, running its queued jobs meanwhile.
+         * @param counter The counter to wait on.
+         */
+        static void Wait(const JobCounter& counter);
+
+        /**
+         * @brief Waits until every job tracked by the counter has finished, running its queued jobs meanwhile and
+         * calling a function between them, e.g. to report progress from the waiting thread.
+         * @param counter The counter to wait on.
+         * @param onIdle Called after each job run by the waiting thread, or when there was none to run.
+         */
+        static void Wait(const JobCounter& counter, const std::function<void()>& onIdle);
+
+        /**
+         * @brief Gets the number of threads that can run jobs, the calling thread included.
+         * @return The worker count plus one.
+         */
+        static uint32_t GetThreadCount() { return s_WorkerCount + 1; }
+
+        /**
+         * @brief Gets the index of the current thread, 0 for threads not owned by the job system.
+         * @return The index in the range [0, GetThreadCount()).
+         */
+        static uint32_t GetThreadIndex();
+
+        /**
+         * @brief Gets the number of chunks ParallelFor splits a range into.
+         * @param count The number of elements.
+         * @param minChunkSize The minimum number of elements per chunk.
+         * @return The chunk count, 0 for an empty range.
+         */
+        static uint32_t GetChunkCount(uint32_t count, uint32_t minChunkSize)
+        {
+            if (count == 0)
+                return 0;
+
+            uint32_t chunkSize = GetChunkSize(count, minChunkSize);
+            return (count + chunkSize - 1) / chunkSize;
+        }
+
+        /**
+         * @brief Runs a function over a range split in chunks and waits for all of them.
+         *
+         * The chunks are contiguous and in order, chunk i covering a lower range than chunk i + 1, so results
+         * written per chunk can be merged deterministically.
+         *
+         * @param count The number of elements.
+         * @param minChunkSize The minimum number of elements per chunk.
+         * @param func Called as func(begin, end, chunkIndex).
+         */
+        template <typename Func>
+        static void ParallelFor(uint32_t count, uint32_t minChunkSize, Func&& func)
+        {
+            uint32_t chunkCount = GetChunkCount(count, minChunkSize);
+            if (chunkCount == 0)
+                return;
+
+            uint32_t chunkSize = GetChunkSize(count, minChunkSize);
+
+            if (chunkCount == 1)
+            {
+                func(0u, count, 0u);
+                return;
+            }
+
+            JobCounter counter;
+            for (uint32_t chunk = 1; chunk < chunkCount; ++chunk)
+            {
+                uint32_t begin = chunk * chunkSize;
+                uint32_t end = std::min(begin + chunkSize, count);
+                Execute(counter, [&func, begin, end, chunk]() { func(begin, end, chunk); });
+            }
+
+            func(0u, std::min(chunkSize, count), 0u);
+
+            Wait(counter);
+        }
+
+    private:
+        static uint32_t GetChunkSize(uint32_t count, uint32_t minChunkSize)
+        {
+            minChunkSize = std::max(minChunkSize, 1u);
+            uint32_t chunkCount = std::min((count + minChunkSize - 1) / minChunkSize, GetThreadCount() * 4);
+            return (count + chunkCount - 1) / chunkCount;
+        }
+
+        static void WorkerLoop(uint32_t threadIndex);
+        static void Push(Job job, const JobCounter* counter);
+        static bool RunPendingJob(const JobCounter& counter);
+
+    private:
+        static uint32_t s_WorkerCount; ///< Number of worker threads.
+    };
+
+    /** @} */
+}
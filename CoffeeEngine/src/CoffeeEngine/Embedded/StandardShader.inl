@@ -10,6 +10,7 @@ layout (location = 1) in vec2 aTexCoord;
 layout (location = 2) in vec3 aNormals;
 layout (location = 3) in vec3 aTangent;
 layout (location = 4) in vec3 aBitangent;
+layout (location = 5) in vec4 aColor; // Only set by the billboard batches, meshes read the default of RendererAPI::Init
 
 layout (std140, binding = 0) uniform camera
 {
@@ -25,6 +26,7 @@ struct VertexData
     vec3 WorldPos;
     vec3 camPos;
     mat3 TBN;
+    vec4 Color;
 };
 
 layout (location = 2) out VertexData Output;
@@ -38,6 +40,7 @@ void main()
     Output.Normal = normalMatrix * aNormals;
     Output.camPos = cameraPos;
     Output.TexCoords = aTexCoord;
+    Output.Color = aColor;
 
     gl_Position = projection * view * vec4(Output.WorldPos, 1.0);
 
@@ -69,6 +72,7 @@ struct VertexData
     vec3 WorldPos;
     vec3 camPos;
     mat3 TBN;
+    vec4 Color;
 };
 
 layout (location = 2) in VertexData VertexInput;
@@ -101,8 +105,6 @@ struct Material
 
 uniform Material material;
 
-#define MAX_LIGHTS 32
-
 struct Light
 {
     vec3 color;
@@ -118,12 +120,37 @@ struct Light
     int type;
 };
 
+layout (std140, binding = 0) uniform camera
+{
+    mat4 projection;
+    mat4 view;
+    vec3 cameraPos;
+};
+
 layout (std140, binding = 1) uniform RenderData
 {
-    Light lights[MAX_LIGHTS];
+    uvec4 clusterGrid; // xyz: number of clusters, w: number of directional lights
+    vec4 clusterDepth; // x: near, y: far, z: slice scale, w: slice bias
     int lightCount;
 };
 
+// Directional lights first, then the point and spot lights referenced by the clusters
+layout (std430, binding = 2) readonly buffer LightBuffer
+{
+    Light lights[];
+};
+
+// Offset and count in lightIndices of the lights affecting each cluster
+layout (std430, binding = 3) readonly buffer ClusterBuffer
+{
+    uvec2 clusters[];
+};
+
+layout (std430, binding = 4) readonly buffer LightIndexBuffer
+{
+    uint lightIndices[];
+};
+
 uniform bool showNormals;
 
 const float PI = 3.14159265359;
@@ -169,9 +196,59 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
 }
 
 
+vec3 ComputeLight(Light light, vec3 N, vec3 V, vec3 albedo, float metallic, float roughness, vec3 F0)
+{
+    vec3 L = vec3(0.0);
+
+    vec3 radiance = vec3(0.0);
+
+    if(light.type == 0)
+    {
+        /*====Directional Light====*/
+
+        L = normalize(-light.direction);
+        radiance = light.color * light.intensity;
+    }
+    else if(light.type == 1)
+    {
+        /*====Point Light====*/
+
+        L = normalize(light.position - VertexInput.WorldPos);
+        float distance = length(light.position - VertexInput.WorldPos);
+        float attenuation = 1.0 / (distance * distance);
+        // Fade to zero at the range so the cut done by the light clusters is not visible
+        float falloff = clamp(1.0 - pow(distance / light.range, 4.0), 0.0, 1.0);
+        attenuation *= falloff * falloff;
+        radiance = light.color * attenuation * light.intensity;
+    }
+    else if(light.type == 2)
+    {
+        /*====Spot Light====*/
+
+    }
+
+    vec3 H = normalize(V + L);
+
+    float NDF = DistributionGGX(N, H, roughness);
+    float G = GeometrySmith(N, V, L, roughness);
+    vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
+
+    vec3 kS = F;
+    vec3 kD = vec3(1.0) - kS;
+    kD *= 1.0 - metallic;
+
+    vec3 numerator = NDF * G * F;
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+    vec3 specular = numerator / denominator;
+
+    float NdotL = max(dot(N, L), 0.0);
+    return (kD * albedo / PI + specular) * radiance * NdotL;
+}
+
 void main()
 {
     vec3 albedo = material.hasAlbedo * (texture(material.albedoMap, VertexInput.TexCoords).rgb * material.color.rgb) + (1 - material.hasAlbedo) * material.color.rgb;
+    albedo *= VertexInput.Color.rgb;
 
     // Revise this type of conditional assignment (the commented one) because i think can lead to some undefined behavior in the shader!!!!!
     vec3 normal/*  = material.hasNormal * (VertexInput.TBN * (texture(material.normalMap, VertexInput.TexCoords).rgb * 2.0 - 1.0)) + (1 - material.hasNormal) * VertexInput.Normal */;
@@ -192,56 +269,31 @@ void main()
     F0 = mix(F0, albedo, metallic);
 
     vec3 Lo = vec3(0.0);
-    for(int i = 0; i < lightCount; i++)
-    {
-        vec3 L = vec3(0.0);
-
-        vec3 radiance = vec3(0.0);
-
-        if(lights[i].type == 0)
-        {
-            /*====Directional Light====*/
-
-            L = normalize(-lights[i].direction);
-            radiance = lights[i].color * lights[i].intensity;
-        }
-        else if(lights[i].type == 1)
-        {
-            /*====Point Light====*/
-
-            L = normalize(lights[i].position - VertexInput.WorldPos);
-            float distance = length(lights[i].position - VertexInput.WorldPos);
-            float attenuation = 1.0 / (distance * distance);
-            radiance = lights[i].color * attenuation * lights[i].intensity;
-        }
-        else if(lights[i].type == 2)
-        {
-            /*====Spot Light====*/
-
-        }
 
-        vec3 H = normalize(V + L);
-
-        float NDF = DistributionGGX(N, H, roughness);
-        float G = GeometrySmith(N, V, L, roughness);
-        vec3 F = fresnelSchlick(max(dot(H, V), 0.0), F0);
-
-        vec3 kS = F;
-        vec3 kD = vec3(1.0) - kS;
-        kD *= 1.0 - metallic;
-
-        vec3 numerator = NDF * G * F;
-        float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
-        vec3 specular = numerator / denominator;
+    for(uint i = 0; i < clusterGrid.w; i++)
+    {
+        Lo += ComputeLight(lights[i], N, V, albedo, metallic, roughness, F0);
+    }
 
-        float NdotL = max(dot(N, L), 0.0);
-        Lo += (kD * albedo / PI + specular) * radiance * NdotL;
+    // Find the cluster of this fragment and shade only the lights assigned to it
+    vec4 viewPos = view * vec4(VertexInput.WorldPos, 1.0);
+    vec4 clipPos = projection * viewPos;
+    vec2 screenUV = clamp(clipPos.xy / clipPos.w * 0.5 + 0.5, 0.0, 0.9999);
+    float viewDepth = max(-viewPos.z, clusterDepth.x);
+    uint slice = uint(clamp(floor(log(viewDepth) * clusterDepth.z - clusterDepth.w), 0.0, float(clusterGrid.z - 1)));
+    uvec2 tile = uvec2(screenUV * vec2(clusterGrid.xy));
+    uint clusterIndex = tile.x + tile.y * clusterGrid.x + slice * clusterGrid.x * clusterGrid.y;
+
+    uvec2 cluster = clusters[clusterIndex];
+    for(uint i = 0; i < cluster.y; i++)
+    {
+        Lo += ComputeLight(lights[lightIndices[cluster.x + i]], N, V, albedo, metallic, roughness, F0);
     }
 
     vec3 ambient = vec3(0.03) * albedo * ao;
     vec3 color = ambient + Lo + emissive;
 
-    FragColor = vec4(vec3(color), 1.0);
+    FragColor = vec4(vec3(color), VertexInput.Color.a);
     EntityID = vec4(entityID, 1.0f); //set the alpha to 0
 
     //REMOVE: This is for the first release of the engine it should be handled differently
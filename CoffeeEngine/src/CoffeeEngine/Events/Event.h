@@ -21,7 +21,8 @@ namespace Coffee {
         WindowClose, WindowResize, WindowFocus, WindowLostFocus, WindowMoved, FileDrop,
         AppTick, AppUpdate, AppRender,
         KeyPressed, KeyReleased, KeyTyped,
-        MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseScrolled
+        MouseButtonPressed, MouseButtonReleased, MouseMoved, MouseScrolled,
+        ResourceLoaded
     };
 
     /**
@@ -34,7 +35,8 @@ namespace Coffee {
         EventCategoryInput          = BIT(1),
         EventCategoryKeyboard       = BIT(2),
         EventCategoryMouse          = BIT(3),
-        EventCategoryMouseButton    = BIT(4)
+        EventCategoryMouseButton    = BIT(4),
+        EventCategoryResource       = BIT(5)
     };
 
     /**
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "CoffeeEngine/Core/UUID.h"
+#include "CoffeeEngine/Events/Event.h"
+#include "CoffeeEngine/IO/Resource.h"
+
+#include <sstream>
+#include <string>
+
+namespace Coffee {
+
+    /**
+     * @defgroup events Events
+     * @{
+     */
+
+    /**
+     * @brief Event for an asynchronous resource load that finished, raised on the main thread once the resource
+     * is ready to be used.
+     */
+    class ResourceLoadedEvent : public Event
+    {
+    public:
+        ResourceLoadedEvent(UUID uuid, ResourceType resourceType, bool succeeded)
+            : m_UUID(uuid), m_ResourceType(resourceType), m_Succeeded(succeeded) {}
+
+        /**
+         * @brief Get the UUID of the loaded resource.
+         * @return The UUID of the resource, null if a load by path failed.
+         */
+        UUID GetUUID() const { return m_UUID; }
+
+        /**
+         * @brief Get the type of the loaded resource.
+         * @return The type of the resource.
+         */
+        ResourceType GetResourceType() const { return m_ResourceType; }
+
+        /**
+         * @brief Check whether the resource was loaded.
+         * @return True if the resource is ready, false if the load failed.
+         */
+        bool Succeeded() const { return m_Succeeded; }
+
+        /**
+         * @brief Convert the event to a string representation.
+         * @return A string representation of the event.
+         */
+        std::string ToString() const override
+        {
+            std::stringstream ss;
+            ss << "ResourceLoadedEvent: " << (uint64_t)m_UUID << (m_Succeeded ? " (Ready)" : " (Failed)");
+            return ss.str();
+        }
+
+        EVENT_CLASS_TYPE(ResourceLoaded)
+        EVENT_CLASS_CATEGORY(EventCategoryResource)
+    private:
+        UUID m_UUID;
+        ResourceType m_ResourceType;
+        bool m_Succeeded;
+    };
+
+    /** @} */
+}
@@ -0,0 +1,60 @@
+#include "CacheBuffer.h"
+
+namespace Coffee {
+
+    static thread_local CachePayloadWriter* s_ActiveWriter = nullptr;
+    static thread_local CachePayloadReader* s_ActiveReader = nullptr;
+
+    CachePayloadWriter::CachePayloadWriter() : m_Previous(s_ActiveWriter)
+    {
+        s_ActiveWriter = this;
+    }
+
+    CachePayloadWriter::~CachePayloadWriter()
+    {
+        s_ActiveWriter = m_Previous;
+    }
+
+    uint64_t CachePayloadWriter::Add(const void* data, size_t size)
+    {
+        uint64_t offset = (m_Size + Alignment - 1) & ~static_cast<uint64_t>(Alignment - 1);
+        m_Blobs.push_back({offset, data, size});
+        m_Size = offset + size;
+        return offset;
+    }
+
+    void CachePayloadWriter::WriteTo(std::ostream& stream) const
+    {
+        static const char padding[Alignment] = {};
+
+        uint64_t position = 0;
+        for (const Blob& blob : m_Blobs)
+        {
+            stream.write(padding, static_cast<std::streamsize>(blob.offset - position));
+            stream.write(static_cast<const char*>(blob.data), static_cast<std::streamsize>(blob.size));
+            position = blob.offset + blob.size;
+        }
+    }
+
+    CachePayloadWriter* CachePayloadWriter::GetActive()
+    {
+        return s_ActiveWriter;
+    }
+
+    CachePayloadReader::CachePayloadReader(Ref<MappedFile> file, size_t payloadOffset)
+        : m_File(std::move(file)), m_PayloadOffset(payloadOffset), m_Previous(s_ActiveReader)
+    {
+        s_ActiveReader = this;
+    }
+
+    CachePayloadReader::~CachePayloadReader()
+    {
+        s_ActiveReader = m_Previous;
+    }
+
+    CachePayloadReader* CachePayloadReader::GetActive()
+    {
+        return s_ActiveReader;
+    }
+
+}
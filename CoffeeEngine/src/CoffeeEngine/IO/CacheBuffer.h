@@ -0,0 +1,235 @@
+/**
+ * @defgroup io IO
+ * @brief IO components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/IO/MappedFile.h"
+
+#include <cereal/details/helpers.hpp>
+#include <cereal/types/vector.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @class CacheBuffer
+     * @brief Read-only array of plain data, either owned or pointing into a mapped cache file.
+     *
+     * Loading a resource from the cache makes its buffers point straight at the mapped pages, the data is
+     * neither copied nor parsed. The buffer keeps the mapping alive for as long as it refers to it.
+     * @tparam T The element type, it is copied as raw bytes.
+     */
+    template <typename T>
+    class CacheBuffer
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "CacheBuffer elements are stored as raw bytes");
+
+    public:
+        CacheBuffer() = default;
+
+        /**
+         * @brief Takes ownership of the elements of a vector.
+         * @param data The elements.
+         */
+        CacheBuffer(std::vector<T> data)
+        {
+            Ref<std::vector<T>> owner = CreateRef<std::vector<T>>(std::move(data));
+            m_Data = owner->data();
+            m_Size = owner->size();
+            m_Owner = std::move(owner);
+        }
+
+        /**
+         * @brief Refers to elements owned by another object.
+         * @param owner The object keeping the elements alive.
+         * @param data The first element.
+         * @param size The number of elements.
+         */
+        CacheBuffer(Ref<const void> owner, const T* data, size_t size)
+            : m_Owner(std::move(owner)), m_Data(data), m_Size(size) {}
+
+        const T* data() const { return m_Data; }
+        size_t size() const { return m_Size; }
+        bool empty() const { return m_Size == 0; }
+        const T& operator[](size_t index) const { return m_Data[index]; }
+        const T* begin() const { return m_Data; }
+        const T* end() const { return m_Data + m_Size; }
+
+        /**
+         * @brief Releases the elements.
+         */
+        void clear()
+        {
+            m_Owner.reset();
+            m_Data = nullptr;
+            m_Size = 0;
+        }
+
+        /**
+         * @brief Gets the elements as a span, valid while the buffer refers to them.
+         * @return A span over the elements.
+         */
+        std::span<const T> GetSpan() const { return {m_Data, m_Size}; }
+
+    private:
+        Ref<const void> m_Owner; ///< Keeps the vector or the mapped file alive.
+        const T* m_Data = nullptr; ///< The first element.
+        size_t m_Size = 0; ///< The number of elements.
+    };
+
+    /**
+     * @brief Collects the buffers of the resource being saved to the cache on this thread, so they are
+     * written as aligned blobs after the serialized data instead of inside it.
+     *
+     * Active on the calling thread from construction to destruction. The buffers are not copied, they have to
+     * outlive the writer.
+     */
+    class CachePayloadWriter
+    {
+    public:
+        static constexpr size_t Alignment = 64; ///< Alignment of every blob, relative to the start of the file.
+
+        CachePayloadWriter();
+        ~CachePayloadWriter();
+
+        CachePayloadWriter(const CachePayloadWriter&) = delete;
+        CachePayloadWriter& operator=(const CachePayloadWriter&) = delete;
+
+        /**
+         * @brief Adds a blob to the payload.
+         * @param data The bytes of the blob.
+         * @param size The number of bytes.
+         * @return The offset of the blob from the start of the payload.
+         */
+        uint64_t Add(const void* data, size_t size);
+
+        /**
+         * @brief Writes the payload. The stream has to be at an aligned position.
+         * @param stream The stream to write to.
+         */
+        void WriteTo(std::ostream& stream) const;
+
+        /**
+         * @brief Gets the writer active on the calling thread.
+         * @return The innermost active writer, nullptr if there is none.
+         */
+        static CachePayloadWriter* GetActive();
+
+    private:
+        struct Blob
+        {
+            uint64_t offset;
+            const void* data;
+            size_t size;
+        };
+
+        std::vector<Blob> m_Blobs; ///< The blobs in payload order.
+        uint64_t m_Size = 0; ///< The size of the payload.
+        CachePayloadWriter* m_Previous; ///< The writer active before this one.
+    };
+
+    /**
+     * @brief Resolves the buffers of the resource being loaded from a mapped cache file on this thread.
+     *
+     * Active on the calling thread from construction to destruction. Nested loads, a mesh loading its
+     * material for instance, activate their own reader.
+     */
+    class CachePayloadReader
+    {
+    public:
+        /**
+         * @brief Activates a reader.
+         * @param file The mapped cache file.
+         * @param payloadOffset The offset of the payload from the start of the file.
+         */
+        CachePayloadReader(Ref<MappedFile> file, size_t payloadOffset);
+        ~CachePayloadReader();
+
+        CachePayloadReader(const CachePayloadReader&) = delete;
+        CachePayloadReader& operator=(const CachePayloadReader&) = delete;
+
+        /**
+         * @brief Gets a buffer pointing into the payload.
+         * @param offset The offset of the blob from the start of the payload.
+         * @param count The number of elements.
+         * @return The buffer, keeping the file mapped.
+         * @throws cereal::Exception If the blob is out of the file or misaligned.
+         */
+        template <typename T>
+        CacheBuffer<T> Get(uint64_t offset, uint64_t count) const
+        {
+            const uint64_t available = m_File->GetSize() - m_PayloadOffset;
+            if (offset > available || count > (available - offset) / sizeof(T))
+                throw cereal::Exception("Cache payload out of bounds");
+
+            const uint8_t* data = m_File->GetData() + m_PayloadOffset + offset;
+            if (reinterpret_cast<uintptr_t>(data) % alignof(T) != 0)
+                throw cereal::Exception("Cache payload misaligned");
+
+            return CacheBuffer<T>(m_File, reinterpret_cast<const T*>(data), count);
+        }
+
+        /**
+         * @brief Gets the reader active on the calling thread.
+         * @return The innermost active reader, nullptr if there is none.
+         */
+        static CachePayloadReader* GetActive();
+
+    private:
+        Ref<MappedFile> m_File; ///< The mapped cache file.
+        size_t m_PayloadOffset; ///< The offset of the payload from the start of the file.
+        CachePayloadReader* m_Previous; ///< The reader active before this one.
+    };
+
+    /**
+     * @brief Serializes a buffer, as a reference into the payload when a CachePayloadWriter is active and as
+     * a vector otherwise.
+     */
+    template <class Archive, typename T>
+    void save(Archive& archive, const CacheBuffer<T>& buffer)
+    {
+        if (CachePayloadWriter* writer = CachePayloadWriter::GetActive())
+        {
+            uint64_t offset = writer->Add(buffer.data(), buffer.size() * sizeof(T));
+            uint64_t count = buffer.size();
+            archive(offset, count);
+        }
+        else
+        {
+            archive(std::vector<T>(buffer.begin(), buffer.end()));
+        }
+    }
+
+    /**
+     * @brief Deserializes a buffer, pointing into the mapped payload when a CachePayloadReader is active and
+     * reading a vector otherwise.
+     */
+    template <class Archive, typename T>
+    void load(Archive& archive, CacheBuffer<T>& buffer)
+    {
+        if (CachePayloadReader* reader = CachePayloadReader::GetActive())
+        {
+            uint64_t offset, count;
+            archive(offset, count);
+            buffer = reader->Get<T>(offset, count);
+        }
+        else
+        {
+            std::vector<T> data;
+            archive(data);
+            buffer = std::move(data);
+        }
+    }
+
+}
+
+/** @} */
@@ -1,5 +1,132 @@
 #include "CacheManager.h"
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/IO/ImportIndex.h"
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
+#include <fstream>
+#include <string>
+#include <tracy/Tracy.hpp>
 
 namespace Coffee {
     std::filesystem::path CacheManager::m_cachePath = ".CoffeeEngine/Cache";
+
+    std::filesystem::path CacheManager::GetCachedFilePath(UUID uuid)
+    {
+        ImportEntry entry;
+        if (ImportIndex::Find(uuid, entry) && !entry.cachePath.empty())
+        {
+            return m_cachePath / entry.cachePath;
+        }
+
+        return m_cachePath / (std::to_string(uuid) + ".res");
+    }
+
+    bool CacheManager::ReadHeader(const std::filesystem::path& path, CacheHeader& header)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+
+        try
+        {
+            cereal::BinaryInputArchive archive(file);
+
+            uint32_t magic = 0;
+            archive(magic);
+            if (magic != CacheHeader::Magic && magic != CacheHeader::MappedMagic)
+                return false;
+
+            archive(header);
+        }
+        catch (const std::exception&)
+        {
+            return false;
+        }
+
+        return true;
+    }
+
+    bool CacheManager::IsStale(const CacheHeader& header)
+    {
+        if (header.importerVersion != ImporterVersion)
+            return true;
+
+        // Entries of a source the index does not know cannot be checked, they are kept
+        ImportEntry entry;
+        return ImportIndex::Find(header.source, entry) && entry.sourceHash != header.sourceHash;
+    }
+
+    void CacheManager::RemoveEntry(const std::filesystem::path& path)
+    {
+        CacheHeader header;
+        if (ReadHeader(path, header) && header.source != UUID::null)
+        {
+            for (UUID dependency : header.dependencies)
+            {
+                std::filesystem::path dependencyPath = GetCachedFilePath(dependency);
+
+                CacheHeader dependencyHeader;
+                if (dependencyPath != path && ReadHeader(dependencyPath, dependencyHeader) &&
+                    dependencyHeader.source == header.source)
+                {
+                    RemoveEntry(dependencyPath);
+                }
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+
+    uint32_t CacheManager::CollectGarbage()
+    {
+        ZoneScoped;
+
+        if (!std::filesystem::exists(m_cachePath))
+            return 0;
+
+        // Sources deleted from disk take their index entries with them, their cache files are orphans below
+        for (UUID uuid : ImportIndex::GetUUIDs())
+        {
+            ImportEntry entry;
+            if (ImportIndex::Find(uuid, entry) && !std::filesystem::exists(ImportIndex::GetProjectDirectory() / entry.sourcePath))
+            {
+                ImportIndex::Remove(uuid);
+            }
+        }
+
+        std::vector<std::filesystem::path> orphans;
+        for (const auto& file : std::filesystem::directory_iterator(m_cachePath))
+        {
+            if (!file.is_regular_file() || file.path().extension() != ".res")
+                continue;
+
+            // Meshes and materials of older projects have no header until loaded, they would be lost
+            CacheHeader header;
+            if (!ReadHeader(file.path(), header))
+                continue;
+
+            ImportEntry entry;
+            if (IsStale(header) || (header.source != UUID::null && !ImportIndex::Find(header.source, entry)))
+            {
+                orphans.push_back(file.path());
+            }
+        }
+
+        uint32_t removed = 0;
+        for (const std::filesystem::path& orphan : orphans)
+        {
+            std::error_code error;
+            if (std::filesystem::remove(orphan, error))
+                ++removed;
+        }
+
+        if (removed > 0)
+        {
+            COFFEE_CORE_INFO("CacheManager::CollectGarbage: Removed {0} cache files", removed);
+        }
+
+        return removed;
+    }
 }
@@ -6,10 +6,35 @@
 
 #pragma once
 
+#include "CoffeeEngine/Core/UUID.h"
+
+#include <cstdint>
 #include <filesystem>
+#include <vector>
 
 namespace Coffee {
 
+    /**
+     * @brief Header written before every resource in a cache file, used to know whether the cached
+     * resource is still up to date.
+     */
+    struct CacheHeader
+    {
+        static constexpr uint32_t Magic = 0x53455243; ///< "CRES", the resource follows the header.
+        static constexpr uint32_t MappedMagic = 0x50414D43; ///< "CMAP", the resource is followed by its mappable buffers.
+
+        uint32_t importerVersion = 0; ///< The importer version that wrote the entry.
+        UUID source = UUID::null; ///< The resource whose source file the entry was generated from.
+        uint64_t sourceHash = 0; ///< Content hash of that source file when the entry was generated.
+        std::vector<UUID> dependencies; ///< The resources the entry references.
+
+        template <class Archive>
+        void serialize(Archive& archive)
+        {
+            archive(importerVersion, source, sourceHash, dependencies);
+        }
+    };
+
     /**
      * @class CacheManager
      * @brief Manages cache-related operations for the CoffeeEngine.
@@ -62,6 +87,47 @@ namespace Coffee {
             return m_cachePath / (filename + ".res");
         }
 
+        /**
+         * @brief Gets the cache file of a resource.
+         * @param uuid The UUID of the resource.
+         * @return The indexed cache file of the resource, or the one named after its UUID.
+         */
+        static std::filesystem::path GetCachedFilePath(UUID uuid);
+
+        /**
+         * @brief Reads the header of a cache file.
+         * @param path The cache file.
+         * @param header Receives the header.
+         * @return False if the file does not exist or was written before cache files had a header.
+         */
+        static bool ReadHeader(const std::filesystem::path& path, CacheHeader& header);
+
+        /**
+         * @brief Checks whether a cache entry was written by another importer version, or generated from a
+         * source file that changed since.
+         * @param header The header of the entry.
+         * @return True if the entry has to be imported again.
+         */
+        static bool IsStale(const CacheHeader& header);
+
+        /**
+         * @brief Removes a cache file and, transitively, the entries it depends on that were generated from
+         * the same source, like the meshes and materials of a model.
+         * @param path The cache file.
+         */
+        static void RemoveEntry(const std::filesystem::path& path);
+
+        /**
+         * @brief Removes the cache files that are stale or whose source is no longer in the project. Entries
+         * without a source, like materials created in the editor, are kept. So are the files without a header,
+         * written before the headers, until loading them migrates them.
+         * @return The number of removed files.
+         */
+        static uint32_t CollectGarbage();
+
+    public:
+        static constexpr uint32_t ImporterVersion = 1; ///< Bump when a change makes the cached resources outdated.
+
     private:
         static std::filesystem::path m_cachePath; ///< The path to the cache directory.
     };
@@ -0,0 +1,231 @@
+#include "ImportIndex.h"
+#include "CoffeeEngine/Core/Log.h"
+
+#include <array>
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
+#include <fstream>
+#include <mutex>
+#include <tracy/Tracy.hpp>
+#include <vector>
+
+namespace Coffee {
+
+    std::unordered_map<UUID, ImportEntry> ImportIndex::s_Entries;
+    std::unordered_map<std::string, UUID> ImportIndex::s_PathToUUID;
+    std::filesystem::path ImportIndex::s_IndexPath;
+    std::filesystem::path ImportIndex::s_ProjectDirectory;
+    bool ImportIndex::s_Dirty = false;
+    std::shared_mutex ImportIndex::s_Mutex;
+
+    static constexpr uint32_t ImportIndexMagic = 0x58444E49; // "INDX"
+    static constexpr uint32_t ImportIndexVersion = 2;
+
+    bool ImportIndex::Load(const std::filesystem::path& indexPath, const std::filesystem::path& projectDirectory)
+    {
+        ZoneScoped;
+
+        std::unique_lock lock(s_Mutex);
+
+        s_Entries.clear();
+        s_PathToUUID.clear();
+        s_IndexPath = indexPath;
+        s_ProjectDirectory = projectDirectory;
+        s_Dirty = false;
+
+        std::ifstream file(indexPath, std::ios::binary);
+        if (!file)
+            return false;
+
+        std::vector<ImportEntry> entries;
+        try
+        {
+            cereal::BinaryInputArchive archive(file);
+
+            uint32_t magic = 0, version = 0;
+            archive(magic, version);
+            if (magic != ImportIndexMagic || version != ImportIndexVersion)
+            {
+                COFFEE_CORE_WARN("ImportIndex::Load: {0} is outdated, the index will be rebuilt", indexPath.string());
+                return false;
+            }
+
+            archive(entries);
+        }
+        catch (const std::exception& e)
+        {
+            COFFEE_CORE_ERROR("ImportIndex::Load: Failed to read {0} ({1})", indexPath.string(), e.what());
+            return false;
+        }
+
+        s_Entries.reserve(entries.size());
+        s_PathToUUID.reserve(entries.size());
+        for (ImportEntry& entry : entries)
+        {
+            s_PathToUUID[MakeKey(s_ProjectDirectory / entry.importPath)] = entry.uuid;
+            s_Entries[entry.uuid] = std::move(entry);
+        }
+
+        return true;
+    }
+
+    void ImportIndex::Save()
+    {
+        ZoneScoped;
+
+        std::unique_lock lock(s_Mutex);
+
+        if (!s_Dirty || s_IndexPath.empty())
+            return;
+
+        std::vector<ImportEntry> entries;
+        entries.reserve(s_Entries.size());
+        for (const auto& [uuid, entry] : s_Entries)
+        {
+            entries.push_back(entry);
+        }
+
+        // Written next to the index and renamed over it, so a crash never leaves half an index behind
+        std::filesystem::create_directories(s_IndexPath.parent_path());
+        std::filesystem::path tempPath = s_IndexPath;
+        tempPath += ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            cereal::BinaryOutputArchive archive(file);
+            archive(ImportIndexMagic, ImportIndexVersion, entries);
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, s_IndexPath, error);
+        if (error)
+        {
+            COFFEE_CORE_ERROR("ImportIndex::Save: Failed to write {0} ({1})", s_IndexPath.string(), error.message());
+            return;
+        }
+
+        s_Dirty = false;
+    }
+
+    void ImportIndex::Clear()
+    {
+        std::unique_lock lock(s_Mutex);
+
+        s_Entries.clear();
+        s_PathToUUID.clear();
+        s_Dirty = true;
+    }
+
+    void ImportIndex::Add(const ImportEntry& entry)
+    {
+        std::string key = MakeKey(s_ProjectDirectory / entry.importPath);
+
+        std::unique_lock lock(s_Mutex);
+
+        // A regenerated .import file gives the same file a new UUID
+        auto it = s_PathToUUID.find(key);
+        if (it != s_PathToUUID.end() && it->second != entry.uuid)
+        {
+            s_Entries.erase(it->second);
+        }
+
+        s_PathToUUID[key] = entry.uuid;
+        s_Entries[entry.uuid] = entry;
+        s_Dirty = true;
+    }
+
+    void ImportIndex::Remove(UUID uuid)
+    {
+        std::unique_lock lock(s_Mutex);
+
+        auto it = s_Entries.find(uuid);
+        if (it == s_Entries.end())
+            return;
+
+        s_PathToUUID.erase(MakeKey(s_ProjectDirectory / it->second.importPath));
+        s_Entries.erase(it);
+        s_Dirty = true;
+    }
+
+    bool ImportIndex::Find(const std::filesystem::path& path, ImportEntry& entry)
+    {
+        std::string key = MakeKey(path);
+
+        std::shared_lock lock(s_Mutex);
+
+        auto it = s_PathToUUID.find(key);
+        if (it == s_PathToUUID.end())
+            return false;
+
+        entry = s_Entries.at(it->second);
+        return true;
+    }
+
+    bool ImportIndex::Find(UUID uuid, ImportEntry& entry)
+    {
+        std::shared_lock lock(s_Mutex);
+
+        auto it = s_Entries.find(uuid);
+        if (it == s_Entries.end())
+            return false;
+
+        entry = it->second;
+        return true;
+    }
+
+    std::vector<UUID> ImportIndex::GetUUIDs()
+    {
+        std::shared_lock lock(s_Mutex);
+
+        std::vector<UUID> uuids;
+        uuids.reserve(s_Entries.size());
+        for (const auto& [uuid, entry] : s_Entries)
+        {
+            uuids.push_back(uuid);
+        }
+        return uuids;
+    }
+
+    uint32_t ImportIndex::GetCount()
+    {
+        std::shared_lock lock(s_Mutex);
+        return static_cast<uint32_t>(s_Entries.size());
+    }
+
+    uint64_t ImportIndex::HashFile(const std::filesystem::path& path)
+    {
+        ZoneScoped;
+
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return 0;
+
+        uint64_t hash = 14695981039346656037ull;
+        std::array<char, 64 * 1024> buffer;
+        while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+        {
+            for (std::streamsize i = 0; i < file.gcount(); ++i)
+            {
+                hash ^= static_cast<uint8_t>(buffer[i]);
+                hash *= 1099511628211ull;
+            }
+        }
+
+        return hash;
+    }
+
+    int64_t ImportIndex::GetWriteTime(const std::filesystem::path& path)
+    {
+        std::error_code error;
+        std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+        return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+    }
+
+    // A resource and its .import file share the key, so either path finds the entry
+    std::string ImportIndex::MakeKey(const std::filesystem::path& path)
+    {
+        std::filesystem::path importPath = path;
+        importPath.replace_extension(".import");
+        return std::filesystem::absolute(importPath).lexically_normal().generic_string();
+    }
+
+}
@@ -0,0 +1,155 @@
+/**
+ * @defgroup io IO
+ * @brief IO components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include "CoffeeEngine/Core/UUID.h"
+#include "CoffeeEngine/IO/Resource.h"
+#include "CoffeeEngine/IO/Serialization/FilesystemPathSerialization.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @brief What the index knows about an imported resource.
+     */
+    struct ImportEntry
+    {
+        UUID uuid = UUID::null; ///< The UUID of the resource.
+        ResourceType type = ResourceType::Unknown; ///< The type of the resource.
+        std::filesystem::path sourcePath; ///< The source file, relative to the project directory.
+        std::filesystem::path importPath; ///< The .import file, relative to the project directory.
+        std::filesystem::path cachePath; ///< The cache file, relative to the cache directory. Empty if not cached.
+        uint64_t sourceHash = 0; ///< Content hash of the source file when it was indexed.
+        int64_t sourceTime = 0; ///< Last write time of the source file when it was hashed.
+        int64_t importTime = 0; ///< Last write time of the .import file when it was indexed.
+
+        template <class Archive>
+        void save(Archive& archive) const
+        {
+            int typeInt = static_cast<int>(type);
+            archive(uuid, typeInt, sourcePath, importPath, cachePath, sourceHash, sourceTime, importTime);
+        }
+
+        template <class Archive>
+        void load(Archive& archive)
+        {
+            int typeInt;
+            archive(uuid, typeInt, sourcePath, importPath, cachePath, sourceHash, sourceTime, importTime);
+            type = static_cast<ResourceType>(typeInt);
+        }
+    };
+
+    /**
+     * @class ImportIndex
+     * @brief Project-wide index of the .import files, so resolving a resource path or UUID does not touch
+     * the filesystem.
+     *
+     * The index is read once when a project is opened, kept up to date as resources are imported, and saved
+     * as a single binary file in the cache directory. Thread safe.
+     */
+    class ImportIndex
+    {
+    public:
+        /**
+         * @brief Replaces the index with the one saved in a file.
+         * @param indexPath The index file. It is also where Save writes.
+         * @param projectDirectory The directory the entry paths are relative to.
+         * @return True if the file was read, false if the index starts empty.
+         */
+        static bool Load(const std::filesystem::path& indexPath, const std::filesystem::path& projectDirectory);
+
+        /**
+         * @brief Writes the index to its file if it changed since it was loaded or saved.
+         */
+        static void Save();
+
+        /**
+         * @brief Removes every entry.
+         */
+        static void Clear();
+
+        /**
+         * @brief Adds an entry, or replaces the one with the same .import file.
+         * @param entry The entry to add.
+         */
+        static void Add(const ImportEntry& entry);
+
+        /**
+         * @brief Removes the entry of a resource.
+         * @param uuid The UUID of the resource.
+         */
+        static void Remove(UUID uuid);
+
+        /**
+         * @brief Finds the entry of a resource file or of its .import file.
+         * @param path The path of the resource or of its .import file.
+         * @param entry Receives the entry when found.
+         * @return True if the path is indexed.
+         */
+        static bool Find(const std::filesystem::path& path, ImportEntry& entry);
+
+        /**
+         * @brief Finds the entry of a resource.
+         * @param uuid The UUID of the resource.
+         * @param entry Receives the entry when found.
+         * @return True if the UUID is indexed.
+         */
+        static bool Find(UUID uuid, ImportEntry& entry);
+
+        /**
+         * @brief Gets the UUIDs of every indexed resource.
+         * @return A copy of the indexed UUIDs.
+         */
+        static std::vector<UUID> GetUUIDs();
+
+        /**
+         * @brief Gets the number of indexed resources.
+         * @return The entry count.
+         */
+        static uint32_t GetCount();
+
+        /**
+         * @brief Gets the directory the entry paths are relative to.
+         * @return The project directory.
+         */
+        static const std::filesystem::path& GetProjectDirectory() { return s_ProjectDirectory; }
+
+        /**
+         * @brief Hashes the content of a file.
+         * @param path The file to hash.
+         * @return A 64-bit FNV-1a hash of the content, 0 if the file cannot be read.
+         */
+        static uint64_t HashFile(const std::filesystem::path& path);
+
+        /**
+         * @brief Gets a file write time in a form that can be stored in an entry.
+         * @param path The file.
+         * @return The write time as a tick count, 0 if the file does not exist.
+         */
+        static int64_t GetWriteTime(const std::filesystem::path& path);
+
+    private:
+        static std::string MakeKey(const std::filesystem::path& path);
+
+    private:
+        static std::unordered_map<UUID, ImportEntry> s_Entries; ///< The entries by UUID.
+        static std::unordered_map<std::string, UUID> s_PathToUUID; ///< The UUIDs by absolute .import path.
+        static std::filesystem::path s_IndexPath; ///< The file the index is saved to.
+        static std::filesystem::path s_ProjectDirectory; ///< The directory the entry paths are relative to.
+        static bool s_Dirty; ///< Whether the index changed since it was loaded or saved.
+        static std::shared_mutex s_Mutex; ///< Guards the index, lookups share it.
+    };
+
+}
+
+/** @} */
@@ -0,0 +1,80 @@
+/**
+ * @defgroup io IO
+ * @brief IO components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <streambuf>
+
+namespace Coffee {
+
+    /**
+     * @class MappedFile
+     * @brief Read-only memory mapping of a file.
+     *
+     * The pages are only read from disk when they are touched, so reading a part of a large file only costs
+     * that part. The implementation lives in the platform layer.
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path& path) { Open(path); }
+        ~MappedFile() { Close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /**
+         * @brief Maps a file, closing the previous one.
+         * @param path The path to the file.
+         * @return True if the file was mapped. Empty files can not be mapped.
+         */
+        bool Open(const std::filesystem::path& path);
+
+        /**
+         * @brief Unmaps the file.
+         */
+        void Close();
+
+        bool IsOpen() const { return m_Data != nullptr; }
+        const uint8_t* GetData() const { return m_Data; }
+        size_t GetSize() const { return m_Size; }
+
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+
+        void* m_FileHandle = nullptr;    ///< Platform file handle, only used on Windows.
+        void* m_MappingHandle = nullptr; ///< Platform mapping handle, only used on Windows.
+    };
+
+    /**
+     * @class MemoryStreamBuffer
+     * @brief Stream buffer reading from a range of memory without copying it, used to read archives from a
+     * mapped file with a std::istream.
+     */
+    class MemoryStreamBuffer : public std::streambuf
+    {
+    public:
+        MemoryStreamBuffer(const uint8_t* data, size_t size)
+        {
+            char* begin = const_cast<char*>(reinterpret_cast<const char*>(data));
+            setg(begin, begin, begin + size);
+        }
+
+        /**
+         * @brief Gets the number of bytes read so far.
+         * @return The offset of the read position from the start of the range.
+         */
+        size_t GetPosition() const { return gptr() - eback(); }
+    };
+
+}
+
+/** @} */
@@ -0,0 +1,38 @@
+#include "Resource.h"
+
+#include <atomic>
+
+namespace Coffee {
+
+    static std::atomic<uint64_t> s_TotalCPUMemoryUsage = 0;
+    static std::atomic<uint64_t> s_TotalGPUMemoryUsage = 0;
+
+    Resource::~Resource()
+    {
+        SetCPUMemoryUsage(0);
+        SetGPUMemoryUsage(0);
+    }
+
+    uint64_t Resource::GetTotalCPUMemoryUsage()
+    {
+        return s_TotalCPUMemoryUsage.load(std::memory_order_relaxed);
+    }
+
+    uint64_t Resource::GetTotalGPUMemoryUsage()
+    {
+        return s_TotalGPUMemoryUsage.load(std::memory_order_relaxed);
+    }
+
+    void Resource::SetCPUMemoryUsage(uint64_t bytes) const
+    {
+        s_TotalCPUMemoryUsage.fetch_add(bytes - m_CPUMemoryUsage, std::memory_order_relaxed);
+        m_CPUMemoryUsage = bytes;
+    }
+
+    void Resource::SetGPUMemoryUsage(uint64_t bytes) const
+    {
+        s_TotalGPUMemoryUsage.fetch_add(bytes - m_GPUMemoryUsage, std::memory_order_relaxed);
+        m_GPUMemoryUsage = bytes;
+    }
+
+}
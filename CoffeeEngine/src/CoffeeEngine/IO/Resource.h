@@ -12,6 +12,7 @@
 #include "CoffeeEngine/Core/UUID.h"
 #include "CoffeeEngine/IO/Serialization/FilesystemPathSerialization.h"
 #include <cereal/types/polymorphic.hpp>
+#include <cstdint>
 
 namespace Coffee {
 
@@ -31,6 +32,17 @@ namespace Coffee {
         Material, ///< Material resource type
     };
 
+    /**
+     * @enum ResourceResidency
+     * @brief Which copies of its data a resource keeps once it is loaded.
+     */
+    enum class ResourceResidency
+    {
+        CPUAndGPU, ///< Keeps the CPU data and the GPU objects
+        GPUOnly,   ///< Releases the CPU data once uploaded, it is reloaded from the cache when needed
+        CPUOnly,   ///< Keeps the CPU data and creates no GPU objects, the resource can not be rendered
+    };
+
     /**
      * @class Resource
      * @brief Base class for different types of resources in the CoffeeEngine.
@@ -48,7 +60,7 @@ namespace Coffee {
         /**
          * @brief Virtual destructor.
          */
-        virtual ~Resource() = default;
+        virtual ~Resource();
 
         /**
          * @brief Gets the name of the resource.
@@ -86,6 +98,68 @@ namespace Coffee {
          */
         UUID GetUUID() const { return m_UUID; }
 
+        /**
+         * @brief Creates the GPU objects of a resource decoded outside of the main thread, and the ones of the
+         * resources it references. Does nothing if they already exist. Main thread only.
+         */
+        virtual void Upload() {}
+
+        /**
+         * @brief Sets which copies of its data the resource keeps. Takes effect on the next ApplyResidency.
+         * @param residency The residency of the resource.
+         */
+        void SetResidency(ResourceResidency residency) { m_Residency = residency; }
+
+        /**
+         * @brief Gets which copies of its data the resource keeps.
+         * @return The residency of the resource.
+         */
+        ResourceResidency GetResidency() const { return m_Residency; }
+
+        /**
+         * @brief Creates or releases the CPU data and the GPU objects of the resource to match its residency.
+         * CPU data is only released when it can be reloaded from the cache. Spans over the CPU data obtained
+         * before the call may be invalidated. Main thread only.
+         */
+        virtual void ApplyResidency() { Upload(); }
+
+        /**
+         * @brief Gets the memory used by the CPU data of the resource.
+         * @return The size in bytes.
+         */
+        uint64_t GetCPUMemoryUsage() const { return m_CPUMemoryUsage; }
+
+        /**
+         * @brief Gets the memory used by the GPU objects of the resource.
+         * @return The estimated size in bytes.
+         */
+        uint64_t GetGPUMemoryUsage() const { return m_GPUMemoryUsage; }
+
+        /**
+         * @brief Gets the memory used by the CPU data of every live resource.
+         * @return The size in bytes.
+         */
+        static uint64_t GetTotalCPUMemoryUsage();
+
+        /**
+         * @brief Gets the memory used by the GPU objects of every live resource.
+         * @return The estimated size in bytes.
+         */
+        static uint64_t GetTotalGPUMemoryUsage();
+
+    protected:
+        /**
+         * @brief Records the memory used by the CPU data of the resource.
+         * @param bytes The size in bytes.
+         */
+        void SetCPUMemoryUsage(uint64_t bytes) const;
+
+        /**
+         * @brief Records the memory used by the GPU objects of the resource.
+         * @param bytes The estimated size in bytes.
+         */
+        void SetGPUMemoryUsage(uint64_t bytes) const;
+
     private:
         friend class cereal::access;
 
@@ -119,6 +193,11 @@ namespace Coffee {
         std::filesystem::path m_FilePath; ///< The file path of the resource.
         ResourceType m_Type; ///< The type of the resource.
         UUID m_UUID; ///< The UUID of the resource.
+        ResourceResidency m_Residency = ResourceResidency::CPUAndGPU; ///< Which copies of its data the resource keeps.
+
+    private:
+        mutable uint64_t m_CPUMemoryUsage = 0; ///< Bytes of CPU data.
+        mutable uint64_t m_GPUMemoryUsage = 0; ///< Estimated bytes of GPU objects.
     };
 
 }
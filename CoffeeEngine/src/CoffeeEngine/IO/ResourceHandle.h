@@ -0,0 +1,127 @@
+/**
+ * @defgroup io IO
+ * @brief IO components of the CoffeeEngine.
+ * @{
+ */
+
+#pragma once
+
+#include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/UUID.h"
+#include "CoffeeEngine/IO/Resource.h"
+
+#include <atomic>
+
+namespace Coffee {
+
+    /**
+     * @enum ResourceState
+     * @brief State of an asynchronous resource load.
+     */
+    enum class ResourceState
+    {
+        Loading, ///< The resource is being decoded or waits for its upload
+        Ready,   ///< The resource and its GPU objects can be used
+        Failed,  ///< The resource could not be loaded
+    };
+
+    /**
+     * @brief Shared state of an asynchronous resource load, see ResourceLoader::LoadAsync.
+     */
+    struct ResourceLoadState
+    {
+        std::atomic<UUID> uuid = UUID::null; ///< The UUID of the resource, known once loaded when the load started from a path. Read from any thread.
+        ResourceType type = ResourceType::Unknown; ///< The type of the resource.
+        JobCounter counter; ///< Counter of the job decoding the resource.
+        Ref<Resource> resource; ///< The loaded resource, written by the job.
+        Ref<Resource> placeholder; ///< The resource to use until the load is ready.
+        std::atomic<ResourceState> state = ResourceState::Loading; ///< The state of the load.
+
+        /**
+         * @brief Blocks until the job finished, running other jobs meanwhile. On the main thread it also
+         * uploads the resource and completes the load.
+         */
+        void Wait();
+
+        /**
+         * @brief Uploads the resource and marks the load as ready or failed, then raises a ResourceLoadedEvent.
+         * Runs once per load. Main thread only.
+         */
+        void Complete();
+    };
+
+    /**
+     * @class ResourceHandle
+     * @brief Handle to a resource loading in the background. Copies share the same load.
+     * @tparam T The type of the resource.
+     */
+    template <typename T>
+    class ResourceHandle
+    {
+    public:
+        ResourceHandle() = default;
+        explicit ResourceHandle(const Ref<ResourceLoadState>& state) : m_State(state) {}
+
+        /**
+         * @brief Checks whether the handle refers to a load.
+         * @return True if a load was started.
+         */
+        bool IsValid() const { return m_State != nullptr; }
+
+        /**
+         * @brief Gets the state of the load.
+         * @return The state of the load, Failed for an invalid handle.
+         */
+        ResourceState GetState() const { return m_State ? m_State->state.load() : ResourceState::Failed; }
+
+        /**
+         * @brief Checks whether the resource is ready to be used.
+         * @return True if the resource is loaded and uploaded.
+         */
+        bool IsReady() const { return GetState() == ResourceState::Ready; }
+
+        /**
+         * @brief Checks whether the load failed.
+         * @return True if the resource could not be loaded.
+         */
+        bool IsFailed() const { return GetState() == ResourceState::Failed; }
+
+        /**
+         * @brief Gets the UUID of the resource.
+         * @return The UUID, null until loaded when the load started from a path.
+         */
+        UUID GetUUID() const { return m_State ? m_State->uuid.load(std::memory_order_acquire) : UUID::null; }
+
+        /**
+         * @brief Gets the resource if it is ready, the placeholder otherwise. Never blocks.
+         * @return A reference to the resource or to its placeholder.
+         */
+        Ref<T> Get() const
+        {
+            if (!m_State)
+                return nullptr;
+
+            return std::static_pointer_cast<T>(IsReady() ? m_State->resource : m_State->placeholder);
+        }
+
+        /**
+         * @brief Blocks until the resource is loaded.
+         * @return A reference to the resource, nullptr if the load failed.
+         */
+        Ref<T> Wait() const
+        {
+            if (!m_State)
+                return nullptr;
+
+            m_State->Wait();
+            return std::static_pointer_cast<T>(m_State->resource);
+        }
+
+    private:
+        Ref<ResourceLoadState> m_State; ///< The shared state of the load.
+    };
+
+}
+
+/** @} */
@@ -2,18 +2,108 @@
 #include "CoffeeEngine/Renderer/Material.h"
 #include "CoffeeEngine/Renderer/Texture.h"
 #include "ResourceSaver.h"
+#include "CoffeeEngine/IO/CacheBuffer.h"
 #include "CoffeeEngine/IO/CacheManager.h"
+#include "CoffeeEngine/IO/ImportIndex.h"
+#include "CoffeeEngine/IO/MappedFile.h"
+#include "CoffeeEngine/IO/ResourceRegistry.h"
 #include "CoffeeEngine/Renderer/Model.h"
 #include "CoffeeEngine/Renderer/Mesh.h"
 #include "CoffeeEngine/Renderer/Material.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
 
 #include <cstdint>
 #include <filesystem>
 #include <fstream>
 #include <string>
+#include <vector>
 
 namespace Coffee {
 
+    // The model being imported on this thread, its meshes and materials are generated from its source file
+    static thread_local UUID s_ImportSource = UUID::null;
+
+    /**
+     * @brief Marks the resources imported on this thread, until the end of the scope, as generated from the
+     * source file of another resource.
+     */
+    class ImportSourceScope
+    {
+    public:
+        ImportSourceScope(UUID source) : m_Previous(s_ImportSource) { s_ImportSource = source; }
+        ~ImportSourceScope() { s_ImportSource = m_Previous; }
+
+    private:
+        UUID m_Previous;
+    };
+
+    static void CollectModelDependencies(const Model& model, std::vector<UUID>& dependencies)
+    {
+        for (const Ref<Mesh>& mesh : model.GetMeshes())
+        {
+            if (mesh)
+                dependencies.push_back(mesh->GetUUID());
+        }
+
+        for (const Ref<Model>& child : model.GetChildren())
+        {
+            CollectModelDependencies(*child, dependencies);
+        }
+    }
+
+    // The resources a cached resource references by UUID
+    static std::vector<UUID> GetDependencies(const Ref<Resource>& resource)
+    {
+        std::vector<UUID> dependencies;
+
+        switch (resource->GetType())
+        {
+            case ResourceType::Model:
+            {
+                CollectModelDependencies(static_cast<const Model&>(*resource), dependencies);
+                break;
+            }
+            case ResourceType::Mesh:
+            {
+                const Ref<Material>& material = static_cast<const Mesh&>(*resource).GetMaterial();
+                if (material)
+                    dependencies.push_back(material->GetUUID());
+                break;
+            }
+            case ResourceType::Material:
+            {
+                const MaterialTextures& textures = static_cast<Material&>(*resource).GetMaterialTextures();
+                for (const Ref<Texture2D>& texture : {textures.albedo, textures.normal, textures.metallic,
+                                                      textures.roughness, textures.ao, textures.emissive})
+                {
+                    if (texture)
+                        dependencies.push_back(texture->GetUUID());
+                }
+                break;
+            }
+            default:
+                break;
+        }
+
+        return dependencies;
+    }
+
+    static CacheHeader MakeCacheHeader(UUID source, const Ref<Resource>& resource)
+    {
+        CacheHeader header;
+        header.importerVersion = CacheManager::ImporterVersion;
+        header.source = source;
+        header.dependencies = GetDependencies(resource);
+
+        ImportEntry entry;
+        if (source != UUID::null && ImportIndex::Find(source, entry))
+        {
+            header.sourceHash = entry.sourceHash;
+        }
+
+        return header;
+    }
+
     Ref<Texture2D> ResourceImporter::ImportTexture2D(const std::filesystem::path& path, const UUID& uuid, bool srgb, bool cache)
     {
         if (!cache)
@@ -26,15 +116,20 @@ namespace Coffee {
         if (std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Texture2D>(resource);
+            if (resource)
+                return std::static_pointer_cast<Texture2D>(resource);
+
+            COFFEE_INFO("ResourceImporter::ImportTexture2D: Texture2D {0} changed. Importing it again.", path.string());
         }
         else
         {
             COFFEE_WARN("ResourceImporter::ImportTexture2D: Texture2D {0} not found in cache. Creating new texture.", path.string());
-            Ref<Texture2D> texture = CreateRef<Texture2D>(path, srgb);
-            ResourceSaver::SaveToCache(std::to_string(uuid), texture); //TODO: Add the UUID to the cache filename
-            return texture;
         }
+
+        Ref<Texture2D> texture = CreateRef<Texture2D>(path, srgb);
+        texture->SetUUID(uuid);
+        ResourceSaver::SaveToCache(std::to_string(uuid), texture, MakeCacheHeader(uuid, texture));
+        return texture;
     }
 
     Ref<Texture2D> ResourceImporter::ImportTexture2D(const UUID& uuid)
@@ -46,13 +141,17 @@ namespace Coffee {
         if(std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Texture2D>(resource);
-        }
-        else
-        {
-            COFFEE_WARN("ResourceImporter::ImportTexture2D: Texture2D {0} not found in cache.", (uint64_t)uuid);
-            return nullptr;
+            if (resource)
+                return std::static_pointer_cast<Texture2D>(resource);
+
+            // Outdated, imported again from the source the index knows
+            ImportEntry entry;
+            if (ImportIndex::Find(uuid, entry) && entry.type == ResourceType::Texture2D)
+                return ImportTexture2D(ImportIndex::GetProjectDirectory() / entry.sourcePath, uuid, true, true);
         }
+
+        COFFEE_WARN("ResourceImporter::ImportTexture2D: Texture2D {0} not found in cache.", (uint64_t)uuid);
+        return nullptr;
     }
 
     Ref<Cubemap> ResourceImporter::ImportCubemap(const std::filesystem::path& path, const UUID& uuid)
@@ -62,16 +161,22 @@ namespace Coffee {
         if (std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Cubemap>(resource);
+            if (resource)
+                return std::static_pointer_cast<Cubemap>(resource);
+
+            COFFEE_INFO("ResourceImporter::ImportCubemap: Cubemap {0} changed. Importing it again.", path.string());
         }
         else
         {
             COFFEE_WARN("ResourceImporter::ImportCubemap: Cubemap {0} not found in cache. Creating new cubemap.", path.string());
-            Ref<Cubemap> cubemap = CreateRef<Cubemap>(path);
-            ResourceSaver::SaveToCache(std::to_string(uuid), cubemap);
-            return cubemap;
         }
+
+        Ref<Cubemap> cubemap = CreateRef<Cubemap>(path);
+        cubemap->SetUUID(uuid);
+        ResourceSaver::SaveToCache(std::to_string(uuid), cubemap, MakeCacheHeader(uuid, cubemap));
+        return cubemap;
     }
+
     Ref<Cubemap> ResourceImporter::ImportCubemap(const UUID& uuid)
     {
         std::string uuidString = std::to_string(uuid);
@@ -81,16 +186,20 @@ namespace Coffee {
         if(std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Cubemap>(resource);
-        }
-        else
-        {
-            COFFEE_WARN("ResourceImporter::ImportCubemap: Cubemap {0} not found in cache.", (uint64_t)uuid);
-            return nullptr;
+            if (resource)
+                return std::static_pointer_cast<Cubemap>(resource);
+
+            // Outdated, imported again from the source the index knows
+            ImportEntry entry;
+            if (ImportIndex::Find(uuid, entry) && entry.type == ResourceType::Cubemap)
+                return ImportCubemap(ImportIndex::GetProjectDirectory() / entry.sourcePath, uuid);
         }
+
+        COFFEE_WARN("ResourceImporter::ImportCubemap: Cubemap {0} not found in cache.", (uint64_t)uuid);
+        return nullptr;
     }
 
-    Ref<Model> ResourceImporter::ImportModel(const std::filesystem::path& path, bool cache)
+    Ref<Model> ResourceImporter::ImportModel(const std::filesystem::path& path, const UUID& uuid, bool cache)
     {
         if (!cache)
         {
@@ -102,15 +211,26 @@ namespace Coffee {
         if (std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Model>(resource);
+            if (resource)
+                return std::static_pointer_cast<Model>(resource);
+
+            // The meshes and materials generated from the old file go with it
+            COFFEE_INFO("ResourceImporter::ImportModel: Model {0} changed. Importing it again.", path.string());
+            CacheManager::RemoveEntry(cachedFilePath);
         }
         else
         {
             COFFEE_WARN("ResourceImporter::ImportModel: Model {0} not found in cache. Creating new model.", path.string());
-            Ref<Model> model = CreateRef<Model>(path);
-            ResourceSaver::SaveToCache(model->GetName(), model);
-            return model;
         }
+
+        Ref<Model> model;
+        {
+            ImportSourceScope scope(uuid);
+            model = CreateRef<Model>(path);
+        }
+        model->SetUUID(uuid);
+        ResourceSaver::SaveToCache(model->GetName(), model, MakeCacheHeader(uuid, model));
+        return model;
     }
 
     Ref<Mesh> ResourceImporter::ImportMesh(const std::string& name, const UUID& uuid, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Ref<Material>& material, const AABB& aabb)
@@ -124,19 +244,21 @@ namespace Coffee {
         if(std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Mesh>(resource);
+            if (resource)
+                return std::static_pointer_cast<Mesh>(resource);
         }
         else
         {
             COFFEE_WARN("ResourceImporter::ImportMesh: Mesh {0} not found in cache. Creating new mesh.", (uint64_t)uuid);
-            Ref<Mesh> mesh = CreateRef<Mesh>(vertices, indices);
-            mesh->SetUUID(uuid);
-            mesh->SetName(name);
-            mesh->SetMaterial(material);
-            mesh->SetAABB(aabb);
-            ResourceSaver::SaveToCache(uuidString, mesh);
-            return mesh;
         }
+
+        Ref<Mesh> mesh = CreateRef<Mesh>(vertices, indices);
+        mesh->SetUUID(uuid);
+        mesh->SetName(name);
+        mesh->SetMaterial(material);
+        mesh->SetAABB(aabb);
+        ResourceSaver::SaveToCache(uuidString, mesh, MakeCacheHeader(s_ImportSource, mesh));
+        return mesh;
     }
 
     Ref<Mesh> ResourceImporter::ImportMesh(const UUID& uuid)
@@ -148,13 +270,15 @@ namespace Coffee {
         if(std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Mesh>(resource);
-        }
-        else
-        {
-            COFFEE_WARN("ResourceImporter::ImportMesh: Mesh {0} not found in cache.", (uint64_t)uuid);
-            return nullptr;
+            if (resource)
+                return std::static_pointer_cast<Mesh>(resource);
+
+            COFFEE_INFO("ResourceImporter::ImportMesh: Mesh {0} is outdated. Importing its model again.", (uint64_t)uuid);
+            return std::static_pointer_cast<Mesh>(ImportFromSourceModel(cachedFilePath, uuid));
         }
+
+        COFFEE_WARN("ResourceImporter::ImportMesh: Mesh {0} not found in cache.", (uint64_t)uuid);
+        return nullptr;
     }
 
     Ref<Material> ResourceImporter::ImportMaterial(const std::string& name, const UUID& uuid)
@@ -166,17 +290,19 @@ namespace Coffee {
         if(std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Material>(resource);
+            if (resource)
+                return std::static_pointer_cast<Material>(resource);
         }
         else
         {
             COFFEE_WARN("ResourceImporter::ImportMaterial: Material {0} not found in cache. Creating new material.", (uint64_t)uuid);
-            Ref<Material> material = CreateRef<Material>(name);
-            material->SetUUID(uuid);
-            material->SetName(name);
-            ResourceSaver::SaveToCache(uuidString, material);
-            return material;
         }
+
+        Ref<Material> material = CreateRef<Material>(name);
+        material->SetUUID(uuid);
+        material->SetName(name);
+        ResourceSaver::SaveToCache(uuidString, material, MakeCacheHeader(s_ImportSource, material));
+        return material;
     }
 
     Ref<Material> ResourceImporter::ImportMaterial(const std::string& name, const UUID& uuid, MaterialTextures& materialTextures)
@@ -188,17 +314,19 @@ namespace Coffee {
         if(std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Material>(resource);
+            if (resource)
+                return std::static_pointer_cast<Material>(resource);
         }
         else
         {
             COFFEE_WARN("ResourceImporter::ImportMaterial: Material {0} not found in cache. Creating new material.", (uint64_t)uuid);
-            Ref<Material> material = CreateRef<Material>(name, materialTextures);
-            material->SetUUID(uuid);
-            material->SetName(name);
-            ResourceSaver::SaveToCache(uuidString, material);
-            return material;
         }
+
+        Ref<Material> material = CreateRef<Material>(name, materialTextures);
+        material->SetUUID(uuid);
+        material->SetName(name);
+        ResourceSaver::SaveToCache(uuidString, material, MakeCacheHeader(s_ImportSource, material));
+        return material;
     }
 
     Ref<Material> ResourceImporter::ImportMaterial(const UUID& uuid)
@@ -210,13 +338,67 @@ namespace Coffee {
         if(std::filesystem::exists(cachedFilePath))
         {
             const Ref<Resource>& resource = LoadFromCache(cachedFilePath, ResourceFormat::Binary);
-            return std::static_pointer_cast<Material>(resource);
+            if (resource)
+                return std::static_pointer_cast<Material>(resource);
+
+            COFFEE_INFO("ResourceImporter::ImportMaterial: Material {0} is outdated. Importing its model again.", (uint64_t)uuid);
+            return std::static_pointer_cast<Material>(ImportFromSourceModel(cachedFilePath, uuid));
         }
-        else
-        {
-            COFFEE_WARN("ResourceImporter::ImportMaterial: Material {0} not found in cache.", (uint64_t)uuid);
+
+        COFFEE_WARN("ResourceImporter::ImportMaterial: Material {0} not found in cache.", (uint64_t)uuid);
+        return nullptr;
+    }
+
+    Ref<Resource> ResourceImporter::ImportFromSourceModel(const std::filesystem::path& cachedFilePath, const UUID& uuid)
+    {
+        CacheHeader header;
+        ImportEntry entry;
+        if (!CacheManager::ReadHeader(cachedFilePath, header) || !ImportIndex::Find(header.source, entry) ||
+            entry.type != ResourceType::Model)
+            return nullptr;
+
+        // The cached model goes first, or it would load the outdated resource again instead of the source
+        const std::filesystem::path sourcePath = ImportIndex::GetProjectDirectory() / entry.sourcePath;
+        CacheManager::RemoveEntry(CacheManager::GetCachedFilePath(sourcePath.filename().string()));
+        CacheManager::RemoveEntry(cachedFilePath);
+
+        if (!ImportModel(sourcePath, header.source, true))
             return nullptr;
+
+        // Generated again with the same UUIDs, and registered as the model created them
+        return ResourceRegistry::TryGetResource(uuid);
+    }
+
+    UUID ResourceImporter::GetGeneratedUUID(const std::string& name) const
+    {
+        if (s_ImportSource == UUID::null)
+            return UUID();
+
+        // FNV-1a of the name seeded with the source UUID, then mixed so similar names spread over the range
+        uint64_t hash = 14695981039346656037ull ^ static_cast<uint64_t>(s_ImportSource);
+        for (char c : name)
+        {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 1099511628211ull;
         }
+
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdull;
+        hash ^= hash >> 33;
+
+        return hash != 0 ? UUID(hash) : UUID(1);
+    }
+
+    Ref<Resource> ResourceImporter::ImportCPUData(const UUID& uuid)
+    {
+        std::filesystem::path cachedFilePath = CacheManager::GetCachedFilePath(uuid);
+
+        if (!std::filesystem::exists(cachedFilePath))
+            return nullptr;
+
+        // Only the data of this instance is used, it needs no GPU objects
+        UploadQueue::DeferScope deferUploads;
+        return LoadFromCache(cachedFilePath, ResourceFormat::Binary);
     }
 
     Ref<Resource> ResourceImporter::LoadFromCache(const std::filesystem::path& path, ResourceFormat format)
@@ -233,15 +415,100 @@ namespace Coffee {
             }
         }
 
-    Ref<Resource> ResourceImporter::BinaryDeserialization(const std::filesystem::path& path)
+    // Entries written before the cache headers are a bare archive of the resource. Meshes and materials have no
+    // source file to import them again from, they are read as they are. Other types are imported again.
+    static Ref<Resource> ReadLegacyEntry(const MappedFile& file)
     {
-        std::ifstream file(path, std::ios::binary);
-        cereal::BinaryInputArchive archive(file);
         Ref<Resource> resource;
-        archive(resource);
+        try
+        {
+            MemoryStreamBuffer buffer(file.GetData(), file.GetSize());
+            std::istream stream(&buffer);
+            cereal::BinaryInputArchive archive(stream);
+            archive(resource);
+        }
+        catch (const std::exception&)
+        {
+            return nullptr;
+        }
+
+        if (!resource || (resource->GetType() != ResourceType::Mesh && resource->GetType() != ResourceType::Material))
+            return nullptr;
+
         return resource;
     }
 
+    Ref<Resource> ResourceImporter::BinaryDeserialization(const std::filesystem::path& path)
+    {
+        // The buffers of the resource point into the mapping, which stays open while they are used
+        Ref<MappedFile> file = CreateRef<MappedFile>(path);
+        if (!file->IsOpen())
+            return nullptr;
+
+        MemoryStreamBuffer buffer(file->GetData(), file->GetSize());
+        std::istream stream(&buffer);
+        cereal::BinaryInputArchive archive(stream);
+
+        uint32_t magic = 0;
+        CacheHeader header;
+        uint64_t metadataSize = 0;
+        try
+        {
+            archive(magic);
+            if (magic != CacheHeader::Magic && magic != CacheHeader::MappedMagic)
+            {
+                // Entries without a header predate the validation. The ones still readable are written again with
+                // a header without source, so they keep their UUID and the garbage collection keeps them
+                Ref<Resource> resource = ReadLegacyEntry(*file);
+                file.reset();
+
+                if (resource)
+                {
+                    COFFEE_INFO("ResourceImporter::BinaryDeserialization: Migrating cache entry {0}", path.string());
+                    ResourceSaver::SaveToCache(path.stem().string(), resource, MakeCacheHeader(UUID::null, resource));
+                }
+                return resource;
+            }
+
+            archive(header);
+        }
+        catch (const std::exception&)
+        {
+            return nullptr;
+        }
+
+        if (CacheManager::IsStale(header))
+            return nullptr;
+
+        try
+        {
+            // Entries written before the buffers were mapped are still valid, their buffers are read as copies
+            if (magic == CacheHeader::Magic)
+            {
+                Ref<Resource> resource;
+                archive(resource);
+                return resource;
+            }
+
+            archive(metadataSize);
+
+            const uint64_t metadataEnd = buffer.GetPosition() + metadataSize;
+            const uint64_t payloadOffset = (metadataEnd + CachePayloadWriter::Alignment - 1) & ~static_cast<uint64_t>(CachePayloadWriter::Alignment - 1);
+            if (metadataEnd > file->GetSize() || payloadOffset > file->GetSize())
+                return nullptr;
+
+            CachePayloadReader payload(file, payloadOffset);
+            Ref<Resource> resource;
+            archive(resource);
+            return resource;
+        }
+        catch (const std::exception& e)
+        {
+            COFFEE_ERROR("ResourceImporter::BinaryDeserialization: Corrupted cache entry {0} ({1})", path.string(), e.what());
+            return nullptr;
+        }
+    }
+
     Ref<Resource> ResourceImporter::JSONDeserialization(const std::filesystem::path& path)
     {
         std::ifstream file(path);
@@ -250,4 +517,4 @@ namespace Coffee {
         archive(resource);
         return resource;
     }
-}
\ No newline at end of file
+}
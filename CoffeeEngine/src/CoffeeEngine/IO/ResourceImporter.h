@@ -44,13 +44,30 @@ namespace Coffee {
         Ref<Texture2D> ImportTexture2D(const UUID& uuid);
         Ref<Cubemap> ImportCubemap(const std::filesystem::path& path, const UUID& uuid);
         Ref<Cubemap> ImportCubemap(const UUID& uuid);
-        Ref<Model> ImportModel(const std::filesystem::path& path, bool cache);
+        Ref<Model> ImportModel(const std::filesystem::path& path, const UUID& uuid, bool cache);
         Ref<Mesh> ImportMesh(const std::string& name, const UUID& uuid, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Ref<Material>& material, const AABB& aabb);
         Ref<Mesh> ImportMesh(const UUID& uuid);
 
         Ref<Material> ImportMaterial(const std::string& name, const UUID& uuid);
         Ref<Material> ImportMaterial(const std::string& name, const UUID& uuid, MaterialTextures& materialTextures);
         Ref<Material> ImportMaterial(const UUID& uuid);
+
+        /**
+         * @brief Reads a resource from the cache without creating its GPU objects.
+         * @param uuid The UUID of the resource.
+         * @return A reference to the resource, nullptr if it is not cached or outdated.
+         */
+        Ref<Resource> ImportCPUData(const UUID& uuid);
+
+        /**
+         * @brief Gets the UUID of a resource generated while importing another one, e.g. a mesh of a model.
+         *
+         * Derived from the UUID of the resource being imported on this thread and the name of the generated one,
+         * so importing the source again reuses the UUIDs the scenes reference. Random outside of an import.
+         * @param name The name of the generated resource, unique within its source.
+         * @return The UUID of the generated resource.
+         */
+        UUID GetGeneratedUUID(const std::string& name) const;
     private:
         /**
          * @brief Loads a resource from the cache.
@@ -67,6 +84,14 @@ namespace Coffee {
          */
         Ref<Resource> BinaryDeserialization(const std::filesystem::path& path);
 
+        /**
+         * @brief Imports again the model an outdated mesh or material was generated from.
+         * @param cachedFilePath The outdated cache file of the mesh or material.
+         * @param uuid The UUID of the mesh or material.
+         * @return The mesh or material generated again, nullptr if its model is unknown or fails to import.
+         */
+        Ref<Resource> ImportFromSourceModel(const std::filesystem::path& cachedFilePath, const UUID& uuid);
+
         /**
          * @brief Deserializes a resource from a JSON file.
          * @param path The file path of the JSON file.
@@ -1,7 +1,11 @@
 #include "ResourceLoader.h"
 #include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Core/JobSystem.h"
 #include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/Core/Stopwatch.h"
+#include "CoffeeEngine/Events/ResourceEvent.h"
 #include "CoffeeEngine/IO/CacheManager.h"
+#include "CoffeeEngine/IO/ImportIndex.h"
 #include "CoffeeEngine/IO/Resource.h"
 #include "CoffeeEngine/Renderer/Material.h"
 #include "CoffeeEngine/Renderer/Model.h"
@@ -10,14 +14,115 @@
 #include "CoffeeEngine/IO/ResourceRegistry.h"
 #include "CoffeeEngine/IO/ResourceImporter.h"
 #include "CoffeeEngine/IO/ResourceUtils.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
+#include <atomic>
+#include <chrono>
 #include <filesystem>
 #include <fstream>
+#include <future>
+#include <mutex>
 #include <string>
+#include <tracy/Tracy.hpp>
+#include <type_traits>
+#include <unordered_map>
 
 namespace Coffee {
 
     std::filesystem::path ResourceLoader::s_WorkingDirectory = std::filesystem::current_path();
     ResourceImporter ResourceLoader::s_Importer = ResourceImporter();
+    ResourceLoader::EventCallbackFn ResourceLoader::s_EventCallback;
+    uint64_t ResourceLoader::s_CPUMemoryBudget = 0;
+    uint64_t ResourceLoader::s_GPUMemoryBudget = 0;
+
+    // Resources being imported by some thread, the other threads asking for them wait for the same result
+    static std::mutex s_LoadingMutex;
+    static std::unordered_map<UUID, std::shared_future<Ref<Resource>>> s_Loading;
+
+    // Types whose CPU data is released once uploaded, the rest keep both copies
+    static std::unordered_map<ResourceType, ResourceResidency> s_DefaultResidency = {
+        {ResourceType::Texture2D, ResourceResidency::GPUOnly},
+        {ResourceType::Cubemap, ResourceResidency::GPUOnly},
+        {ResourceType::Mesh, ResourceResidency::GPUOnly},
+    };
+
+    // Resources created on job threads get their GPU objects from the main thread, which then drops the CPU
+    // data their residency does not keep
+    static void MakeResident(const Ref<Resource>& resource)
+    {
+        if (!resource)
+            return;
+
+        resource->SetResidency(ResourceLoader::GetDefaultResidency(resource->GetType()));
+        UploadQueue::Submit([resource]() { resource->ApplyResidency(); });
+    }
+
+    // The main thread can get a resource a job thread decoded before its upload ran, it uploads it itself
+    template <typename T>
+    static Ref<T> GetLoaded(const Ref<Resource>& resource)
+    {
+        if (resource && UploadQueue::IsMainThread())
+        {
+            resource->Upload();
+        }
+
+        return std::static_pointer_cast<T>(resource);
+    }
+
+    /**
+     * @brief Imports a resource once even when several threads ask for it at the same time, and adds it to the
+     * registry.
+     */
+    template <typename T, typename ImportFunc>
+    static Ref<T> LoadOnce(UUID uuid, ImportFunc&& import)
+    {
+        std::promise<Ref<Resource>> promise;
+        std::shared_future<Ref<Resource>> loading;
+        Ref<Resource> loaded;
+        {
+            std::lock_guard<std::mutex> lock(s_LoadingMutex);
+
+            // Evicted resources are not loaded, they are imported again from the cache
+            loaded = ResourceRegistry::TryGet<Resource>(uuid);
+            if (!loaded)
+            {
+                auto it = s_Loading.find(uuid);
+                if (it != s_Loading.end())
+                    loading = it->second;
+                else
+                    s_Loading.emplace(uuid, promise.get_future().share());
+            }
+        }
+
+        if (loaded)
+            return GetLoaded<T>(loaded);
+
+        if (loading.valid())
+            return GetLoaded<T>(loading.get());
+
+        Ref<T> resource;
+        try
+        {
+            resource = import();
+        }
+        catch (const std::exception& e)
+        {
+            COFFEE_CORE_ERROR("ResourceLoader: Failed to import resource {0} ({1})", (uint64_t)uuid, e.what());
+        }
+
+        if (resource)
+        {
+            ResourceRegistry::Add(uuid, resource);
+            MakeResident(resource);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(s_LoadingMutex);
+            s_Loading.erase(uuid);
+        }
+        promise.set_value(resource);
+
+        return resource;
+    }
 
     void ResourceLoader::LoadFile(const std::filesystem::path& path)
     {
@@ -44,13 +149,7 @@ namespace Coffee {
         }
         else
         {
-            std::filesystem::path importFilePath = resourcePath;
-            importFilePath.replace_extension(".import");
-            if(!std::filesystem::exists(importFilePath))
-            {
-                COFFEE_CORE_INFO("ResourceLoader::LoadDirectory: Generating import file for {0}", resourcePath.string());
-                GenerateImportFile(resourcePath);
-            }
+            UpdateImportIndex(resourcePath);
         }
 
         switch (type)
@@ -78,24 +177,122 @@ namespace Coffee {
         }
     }
 
-    void ResourceLoader::LoadDirectory(const std::filesystem::path& directory)
+    // Imports one resource of a directory, a broken file is logged and skipped instead of stopping the import
+    template <typename ImportFunc>
+    static void ImportDirectoryEntry(const std::filesystem::path& path, ImportFunc&& import)
     {
-        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+        try
         {
-            // This two if statements are duplicated in LoadFile but are necessary to suppress errors
+            import();
+        }
+        catch (const std::exception& e)
+        {
+            COFFEE_CORE_ERROR("ResourceLoader::LoadDirectory: Failed to load {0} ({1})", path.string(), e.what());
+        }
+    }
 
+    void ResourceLoader::LoadDirectory(const std::filesystem::path& directory, const ProgressCallbackFn& progress)
+    {
+        ZoneScoped;
+
+        Stopwatch stopwatch;
+        stopwatch.Start();
+
+        // Scan first so the resources can be loaded by type, in dependency order
+        std::vector<std::filesystem::path> resources;
+        std::vector<std::filesystem::path> textures;
+        std::vector<std::filesystem::path> models;
+        std::vector<std::filesystem::path> mainThreadResources;
+
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+        {
             if (!entry.is_regular_file())
             {
                 continue;
             }
 
-            if(GetResourceTypeFromExtension(entry.path()) == ResourceType::Unknown and entry.path().extension() != ".import")
+            // The .import files are read through the resources they describe
+            const ResourceType type = GetResourceTypeFromExtension(entry.path());
+            if (type == ResourceType::Unknown)
             {
                 continue;
             }
 
-            LoadFile(entry.path());
+            resources.push_back(entry.path());
+
+            switch (type)
+            {
+                case ResourceType::Texture2D: textures.push_back(entry.path()); break;
+                case ResourceType::Model: models.push_back(entry.path()); break;
+                default: mainThreadResources.push_back(entry.path()); break;
+            }
+        }
+
+        // Only new or changed .import files are read and their sources hashed, the rest is already indexed
+        JobSystem::ParallelFor(static_cast<uint32_t>(resources.size()), 16, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                ImportDirectoryEntry(resources[i], [&]() { UpdateImportIndex(resources[i]); });
+            }
+        });
+
+        const uint32_t total = static_cast<uint32_t>(textures.size() + models.size() + mainThreadResources.size());
+        std::atomic<uint32_t> loaded = 0;
+        uint32_t reported = 0;
+
+        auto reportProgress = [&]() {
+            uint32_t current = loaded.load(std::memory_order_relaxed);
+            if (progress && current != reported)
+            {
+                reported = current;
+                progress(current, total);
+            }
+        };
+
+        // The textures decode on the job threads while this thread creates the resources that need the
+        // graphics context
+        JobCounter textureCounter;
+        for (const std::filesystem::path& path : textures)
+        {
+            JobSystem::Execute(textureCounter, [&loaded, path]() {
+                ImportDirectoryEntry(path, [&]() { LoadTexture2D(path); });
+                loaded.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+
+        for (const std::filesystem::path& path : mainThreadResources)
+        {
+            ImportDirectoryEntry(path, [&]() {
+                if (GetResourceTypeFromExtension(path) == ResourceType::Cubemap)
+                    LoadCubemap(path);
+                else
+                    LoadShader(path);
+            });
+            loaded.fetch_add(1, std::memory_order_relaxed);
+            reportProgress();
         }
+
+        JobSystem::Wait(textureCounter, reportProgress);
+
+        // The models find the textures they reference in the registry instead of decoding them again
+        JobCounter modelCounter;
+        for (const std::filesystem::path& path : models)
+        {
+            JobSystem::Execute(modelCounter, [&loaded, path]() {
+                ImportDirectoryEntry(path, [&]() { LoadModel(path); });
+                loaded.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+
+        JobSystem::Wait(modelCounter, reportProgress);
+
+        UploadQueue::Flush();
+        reportProgress();
+
+        ImportIndex::Save();
+
+        COFFEE_CORE_INFO("ResourceLoader::LoadDirectory: Loaded {0} resources from {1} in {2:.2f}s on {3} threads", total,
+                         directory.string(), stopwatch.GetPreciseElapsedTime(), JobSystem::GetThreadCount());
     }
 
     Ref<Texture2D> ResourceLoader::LoadTexture2D(const std::filesystem::path& path, bool srgb, bool cache)
@@ -108,16 +305,12 @@ namespace Coffee {
 
         UUID uuid = GetUUIDFromImportFile(path);
 
-        if(ResourceRegistry::Exists(uuid))
-        {
-            return ResourceRegistry::Get<Texture2D>(uuid);
-        }
-
-        const Ref<Texture2D>& texture = s_Importer.ImportTexture2D(path, uuid, srgb, cache);
-        texture->SetUUID(uuid);
-
-        ResourceRegistry::Add(uuid, texture);
-        return texture;
+        return LoadOnce<Texture2D>(uuid, [&]() {
+            Ref<Texture2D> texture = s_Importer.ImportTexture2D(path, uuid, srgb, cache);
+            if (texture)
+                texture->SetUUID(uuid);
+            return texture;
+        });
     }
 
     Ref<Texture2D> ResourceLoader::LoadTexture2D(UUID uuid)
@@ -125,15 +318,7 @@ namespace Coffee {
         if(uuid == UUID::null)
             return nullptr;
 
-        if(ResourceRegistry::Exists(uuid))
-        {
-            return ResourceRegistry::Get<Texture2D>(uuid);
-        }
-
-        const Ref<Texture2D>& texture = s_Importer.ImportTexture2D(uuid);
-
-        ResourceRegistry::Add(uuid, texture);
-        return texture;
+        return LoadOnce<Texture2D>(uuid, [&]() { return s_Importer.ImportTexture2D(uuid); });
     }
 
     Ref<Cubemap> ResourceLoader::LoadCubemap(const std::filesystem::path& path)
@@ -146,17 +331,15 @@ namespace Coffee {
 
         UUID uuid = GetUUIDFromImportFile(path);
 
-        if(ResourceRegistry::Exists(uuid))
-        {
-            return ResourceRegistry::Get<Cubemap>(uuid);
-        }
-
-        const Ref<Cubemap>& cubemap = s_Importer.ImportCubemap(path, uuid);
-        cubemap->SetUUID(uuid);
-        cubemap->SetName(path.filename().string());
-
-        ResourceRegistry::Add(uuid, cubemap);
-        return cubemap;
+        return LoadOnce<Cubemap>(uuid, [&]() {
+            Ref<Cubemap> cubemap = s_Importer.ImportCubemap(path, uuid);
+            if (cubemap)
+            {
+                cubemap->SetUUID(uuid);
+                cubemap->SetName(path.filename().string());
+            }
+            return cubemap;
+        });
     }
     Ref<Cubemap> ResourceLoader::LoadCubemap(UUID uuid)
     {
@@ -173,16 +356,12 @@ namespace Coffee {
 
         UUID uuid = GetUUIDFromImportFile(path);
 
-        if(ResourceRegistry::Exists(uuid))
-        {
-            return ResourceRegistry::Get<Model>(uuid);
-        }
-
-        const Ref<Model>& model = s_Importer.ImportModel(path, cache);
-        model->SetUUID(uuid);
-
-        ResourceRegistry::Add(uuid, model);
-        return model;
+        return LoadOnce<Model>(uuid, [&]() {
+            Ref<Model> model = s_Importer.ImportModel(path, uuid, cache);
+            if (model)
+                model->SetUUID(uuid);
+            return model;
+        });
     }
 
     Ref<Mesh> ResourceLoader::LoadMesh(const std::string& name, const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, Ref<Material>& material, const AABB& aabb)
@@ -191,27 +370,25 @@ namespace Coffee {
         {
             return ResourceRegistry::Get<Mesh>(name);
         }
-        
-        UUID uuid = ResourceRegistry::GetUUIDByName(name);
 
-        const Ref<Mesh>& mesh = s_Importer.ImportMesh(name, uuid, vertices, indices, material, aabb);
-        mesh->SetName(name);
+        // Stable across imports of the model, so the scenes keep finding its meshes. Models imported in
+        // parallel that share a mesh import it once
+        UUID uuid = s_Importer.GetGeneratedUUID(name);
 
-        ResourceRegistry::Add(uuid, mesh);
-        return mesh;
+        return LoadOnce<Mesh>(uuid, [&]() {
+            Ref<Mesh> mesh = s_Importer.ImportMesh(name, uuid, vertices, indices, material, aabb);
+            if (mesh)
+                mesh->SetName(name);
+            return mesh;
+        });
     }
 
     Ref<Mesh> ResourceLoader::LoadMesh(UUID uuid)
     {
-        if(ResourceRegistry::Exists(uuid))
-        {
-            return ResourceRegistry::Get<Mesh>(uuid);
-        }
-
-        const Ref<Mesh>& mesh = s_Importer.ImportMesh(uuid);
+        if(uuid == UUID::null)
+            return nullptr;
 
-        ResourceRegistry::Add(uuid, mesh);
-        return mesh;
+        return LoadOnce<Mesh>(uuid, [&]() { return s_Importer.ImportMesh(uuid); });
     }
 
     Ref<Shader> ResourceLoader::LoadShader(const std::filesystem::path& shaderPath)
@@ -224,24 +401,18 @@ namespace Coffee {
 
         UUID uuid = GetUUIDFromImportFile(shaderPath);
 
-        if(ResourceRegistry::Exists(uuid))
-        {
-            return ResourceRegistry::Get<Shader>(uuid);
-        }
-
-        const Ref<Shader>& shader = CreateRef<Shader>(shaderPath);
-        shader->SetUUID(uuid);
-
-        ResourceRegistry::Add(uuid, shader);
-
-        return shader;
+        return LoadOnce<Shader>(uuid, [&]() {
+            Ref<Shader> shader = CreateRef<Shader>(shaderPath);
+            shader->SetUUID(uuid);
+            return shader;
+        });
     }
 
     Ref<Material> ResourceLoader::LoadMaterial(const std::string& name)
     {
         std::string materialName = name;
 
-        UUID uuid;
+        UUID uuid = s_Importer.GetGeneratedUUID(materialName);
 
         if(materialName.empty())
         {
@@ -253,18 +424,19 @@ namespace Coffee {
             return ResourceRegistry::Get<Material>(materialName);
         }
 
-        Ref<Material> material = s_Importer.ImportMaterial(materialName, uuid);
-        material->SetUUID(uuid);
-        ResourceRegistry::Add(uuid, material);
-        return material;
-
+        return LoadOnce<Material>(uuid, [&]() {
+            Ref<Material> material = s_Importer.ImportMaterial(materialName, uuid);
+            if (material)
+                material->SetUUID(uuid);
+            return material;
+        });
     }
 
     Ref<Material> ResourceLoader::LoadMaterial(const std::string& name, MaterialTextures& materialTextures)
     {
         std::string materialName = name;
 
-        UUID uuid;
+        UUID uuid = s_Importer.GetGeneratedUUID(materialName);
 
         if(materialName.empty())
         {
@@ -276,42 +448,303 @@ namespace Coffee {
             return ResourceRegistry::Get<Material>(materialName);
         }
 
-        Ref<Material> material = s_Importer.ImportMaterial(materialName, uuid, materialTextures);
-        material->SetUUID(uuid);
-        ResourceRegistry::Add(uuid, material);
-        return material;
+        return LoadOnce<Material>(uuid, [&]() {
+            Ref<Material> material = s_Importer.ImportMaterial(materialName, uuid, materialTextures);
+            if (material)
+                material->SetUUID(uuid);
+            return material;
+        });
     }
     
     Ref<Material> ResourceLoader::LoadMaterial(UUID uuid)
     {
-        if(ResourceRegistry::Exists(uuid))
+        if(uuid == UUID::null)
+            return nullptr;
+
+        return LoadOnce<Material>(uuid, [&]() { return s_Importer.ImportMaterial(uuid); });
+    }
+
+    // Resources given by the handles of asynchronous loads until they are ready, loaded on first use
+    template <typename T>
+    static Ref<Resource> GetPlaceholder()
+    {
+        static Ref<Resource> s_Placeholder = []() -> Ref<Resource> {
+            if constexpr (std::is_same_v<T, Texture2D>)
+            {
+                return Texture2D::Load("assets/textures/Missing_Texture.png");
+            }
+            else if constexpr (std::is_same_v<T, Mesh>)
+            {
+                Ref<Model> model = Model::Load("assets/models/MissingMesh.glb");
+                return (model && !model->GetMeshes().empty()) ? model->GetMeshes()[0] : nullptr;
+            }
+            else if constexpr (std::is_same_v<T, Material>)
+            {
+                return Material::Create("Placeholder Material");
+            }
+            else
+            {
+                return Model::Load("assets/models/MissingMesh.glb");
+            }
+        }();
+
+        return s_Placeholder;
+    }
+
+    void ResourceLoadState::Wait()
+    {
+        JobSystem::Wait(counter);
+
+        if (UploadQueue::IsMainThread())
         {
-            return ResourceRegistry::Get<Material>(uuid);
+            Complete();
         }
+    }
 
-        const Ref<Material>& material = s_Importer.ImportMaterial(uuid);
+    void ResourceLoadState::Complete()
+    {
+        COFFEE_CORE_ASSERT(UploadQueue::IsMainThread(), "ResourceLoadState::Complete must be called from the main thread");
+
+        // Both Wait and the upload queue complete the load, the first one wins
+        if (state.load(std::memory_order_relaxed) != ResourceState::Loading)
+            return;
 
-        ResourceRegistry::Add(uuid, material);
-        return material;
+        if (resource)
+        {
+            resource->Upload();
+            uuid.store(resource->GetUUID(), std::memory_order_release);
+        }
+
+        state.store(resource ? ResourceState::Ready : ResourceState::Failed, std::memory_order_release);
+
+        if (ResourceLoader::s_EventCallback)
+        {
+            ResourceLoadedEvent event(uuid.load(std::memory_order_relaxed), type, resource != nullptr);
+            ResourceLoader::s_EventCallback(event);
+        }
     }
 
-    void ResourceLoader::RemoveResource(UUID uuid) // Think if would be better to pass the Resource as parameter
+    Ref<ResourceLoadState> ResourceLoader::StartAsync(ResourceType type, UUID uuid, const Ref<Resource>& placeholder,
+                                                      std::function<Ref<Resource>()> load)
     {
-        if(!ResourceRegistry::Exists(uuid))
+        Ref<ResourceLoadState> state = CreateRef<ResourceLoadState>();
+        state->uuid.store(uuid, std::memory_order_relaxed);
+        state->type = type;
+        state->placeholder = placeholder;
+
+        JobSystem::Execute(state->counter, [state, load = std::move(load)]() {
+            ZoneScopedN("ResourceLoader::LoadAsync");
+
+            try
+            {
+                state->resource = load();
+            }
+            catch (const std::exception& e)
+            {
+                COFFEE_CORE_ERROR("ResourceLoader::LoadAsync: Failed to load resource ({0})", e.what());
+            }
+
+            // Queued after the uploads of the resource, so the load completes once they ran
+            UploadQueue::Submit([state]() { state->Complete(); });
+        });
+
+        return state;
+    }
+
+    template <typename T>
+    ResourceHandle<T> ResourceLoader::LoadAsync(UUID uuid)
+    {
+        static_assert(std::is_same_v<T, Texture2D> || std::is_same_v<T, Mesh> || std::is_same_v<T, Material>,
+                      "LoadAsync(UUID) supports Texture2D, Mesh and Material");
+
+        if (uuid == UUID::null)
+            return ResourceHandle<T>();
+
+        if constexpr (std::is_same_v<T, Texture2D>)
         {
-            COFFEE_CORE_ERROR("ResourceLoader::RemoveResource: Resource {0} does not exist!", (uint64_t)uuid);
+            return ResourceHandle<T>(StartAsync(ResourceType::Texture2D, uuid, GetPlaceholder<T>(),
+                                                [uuid]() -> Ref<Resource> { return LoadTexture2D(uuid); }));
+        }
+        else if constexpr (std::is_same_v<T, Mesh>)
+        {
+            return ResourceHandle<T>(StartAsync(ResourceType::Mesh, uuid, GetPlaceholder<T>(),
+                                                [uuid]() -> Ref<Resource> { return LoadMesh(uuid); }));
+        }
+        else
+        {
+            return ResourceHandle<T>(StartAsync(ResourceType::Material, uuid, GetPlaceholder<T>(),
+                                                [uuid]() -> Ref<Resource> { return LoadMaterial(uuid); }));
+        }
+    }
+
+    template <typename T>
+    ResourceHandle<T> ResourceLoader::LoadAsync(const std::filesystem::path& path)
+    {
+        static_assert(std::is_same_v<T, Texture2D> || std::is_same_v<T, Model>,
+                      "LoadAsync(path) supports Texture2D and Model");
+
+        if constexpr (std::is_same_v<T, Texture2D>)
+        {
+            return LoadTexture2DAsync(path);
+        }
+        else
+        {
+            return ResourceHandle<T>(StartAsync(ResourceType::Model, UUID::null, GetPlaceholder<T>(),
+                                                [path]() -> Ref<Resource> { return LoadModel(path); }));
+        }
+    }
+
+    template ResourceHandle<Texture2D> ResourceLoader::LoadAsync<Texture2D>(UUID uuid);
+    template ResourceHandle<Mesh> ResourceLoader::LoadAsync<Mesh>(UUID uuid);
+    template ResourceHandle<Material> ResourceLoader::LoadAsync<Material>(UUID uuid);
+    template ResourceHandle<Texture2D> ResourceLoader::LoadAsync<Texture2D>(const std::filesystem::path& path);
+    template ResourceHandle<Model> ResourceLoader::LoadAsync<Model>(const std::filesystem::path& path);
+
+    ResourceHandle<Texture2D> ResourceLoader::LoadTexture2DAsync(const std::filesystem::path& path, bool srgb)
+    {
+        return ResourceHandle<Texture2D>(StartAsync(ResourceType::Texture2D, UUID::null, GetPlaceholder<Texture2D>(),
+                                                    [path, srgb]() -> Ref<Resource> {
+            if (!std::filesystem::exists(path))
+            {
+                COFFEE_CORE_ERROR("ResourceLoader::LoadTexture2DAsync: {0} does not exist!", path.string());
+                return nullptr;
+            }
+
+            return LoadTexture2D(path, srgb);
+        }));
+    }
+
+    void ResourceLoader::SetDefaultResidency(ResourceType type, ResourceResidency residency)
+    {
+        s_DefaultResidency[type] = residency;
+    }
+
+    ResourceResidency ResourceLoader::GetDefaultResidency(ResourceType type)
+    {
+        auto it = s_DefaultResidency.find(type);
+        return it != s_DefaultResidency.end() ? it->second : ResourceResidency::CPUAndGPU;
+    }
+
+    Ref<Resource> ResourceLoader::LoadCPUData(UUID uuid)
+    {
+        ZoneScoped;
+
+        if (uuid == UUID::null)
+            return nullptr;
+
+        return s_Importer.ImportCPUData(uuid);
+    }
+
+    Ref<Resource> ResourceLoader::Reload(UUID uuid, ResourceType type)
+    {
+        ZoneScoped;
+
+        ImportEntry entry;
+        switch (type)
+        {
+        case ResourceType::Texture2D:
+            return LoadTexture2D(uuid);
+        case ResourceType::Mesh:
+            return LoadMesh(uuid);
+        case ResourceType::Material:
+            return LoadMaterial(uuid);
+        case ResourceType::Model:
+            if (ImportIndex::Find(uuid, entry))
+                return LoadModel(ImportIndex::GetProjectDirectory() / entry.sourcePath);
+            break;
+        case ResourceType::Cubemap:
+            if (ImportIndex::Find(uuid, entry))
+                return LoadCubemap(ImportIndex::GetProjectDirectory() / entry.sourcePath);
+            break;
+        default:
+            break;
+        }
+
+        return nullptr;
+    }
+
+    bool ResourceLoader::IsReloadable(UUID uuid, ResourceType type)
+    {
+        ImportEntry entry;
+        switch (type)
+        {
+        case ResourceType::Texture2D:
+        case ResourceType::Mesh:
+        case ResourceType::Material:
+            return std::filesystem::exists(CacheManager::GetCachedFilePath(uuid));
+        case ResourceType::Model:
+        case ResourceType::Cubemap:
+            return ImportIndex::Find(uuid, entry) && std::filesystem::exists(CacheManager::GetCachedFilePath(uuid));
+        default:
+            return false;
+        }
+    }
+
+    void ResourceLoader::EnforceMemoryBudget()
+    {
+        ZoneScoped;
+
+        auto isOverBudget = []() {
+            return (s_CPUMemoryBudget != 0 && Resource::GetTotalCPUMemoryUsage() > s_CPUMemoryBudget) ||
+                   (s_GPUMemoryBudget != 0 && Resource::GetTotalGPUMemoryUsage() > s_GPUMemoryBudget);
+        };
+
+        if (!isOverBudget())
+            return;
+
+        // When nothing could be evicted, the registry is scanned again a second later
+        using Clock = std::chrono::steady_clock;
+        static Clock::time_point s_NextAttempt;
+        if (Clock::now() < s_NextAttempt)
             return;
+
+        COFFEE_CORE_ASSERT(UploadQueue::IsMainThread(), "ResourceLoader::EnforceMemoryBudget must be called from the main thread");
+
+        // Evicting a model or a material drops the last references to its meshes or textures, which are
+        // candidates of the next pass
+        uint32_t evictedCount = 0;
+        bool evicted = true;
+        while (evicted && isOverBudget())
+        {
+            evicted = false;
+            for (const EvictionCandidate& candidate : ResourceRegistry::GetEvictionCandidates())
+            {
+                if (!isOverBudget())
+                    break;
+
+                if (IsReloadable(candidate.uuid, candidate.type) && ResourceRegistry::Evict(candidate.uuid))
+                {
+                    evicted = true;
+                    ++evictedCount;
+                }
+            }
+        }
+
+        if (isOverBudget())
+            s_NextAttempt = Clock::now() + std::chrono::seconds(1);
+
+        if (evictedCount > 0)
+        {
+            COFFEE_CORE_INFO("ResourceLoader: Evicted {0} unused resources, {1} MB on the CPU and {2} MB on the GPU in use",
+                             evictedCount, Resource::GetTotalCPUMemoryUsage() / (1024 * 1024),
+                             Resource::GetTotalGPUMemoryUsage() / (1024 * 1024));
         }
+    }
 
-        // Remove the Cache file and all dependencies(TODO)
-        std::filesystem::path cacheFilePath = CacheManager::GetCachePath() / (std::to_string(uuid) + ".res");
-        if(std::filesystem::exists(cacheFilePath))
+    void ResourceLoader::RemoveResource(UUID uuid) // Think if would be better to pass the Resource as parameter
+    {
+        if(!ResourceRegistry::Exists(uuid))
         {
-            std::filesystem::remove(cacheFilePath);
+            COFFEE_CORE_ERROR("ResourceLoader::RemoveResource: Resource {0} does not exist!", (uint64_t)uuid);
+            return;
         }
 
+        // Retrieved before its cache file goes, an evicted resource is loaded back from it
         const Ref<Resource>& resource = ResourceRegistry::Get<Resource>(uuid);
 
+        // Remove the Cache file and the ones generated with it
+        CacheManager::RemoveEntry(CacheManager::GetCachedFilePath(uuid));
+
         const std::filesystem::path& resourcePath = resource->GetPath();
         std::filesystem::path importFilePath = resourcePath;
         importFilePath.replace_extension(".import");
@@ -326,6 +759,7 @@ namespace Coffee {
             std::filesystem::remove(resourcePath);
         }
 
+        ImportIndex::Remove(uuid);
         ResourceRegistry::Remove(uuid);
     }
 
@@ -333,15 +767,12 @@ namespace Coffee {
     {
         UUID uuid = GetUUIDFromImportFile(path);
         
-        // Remove the Cache file and all dependencies(TODO)
-        std::filesystem::path cacheFilePath = CacheManager::GetCachePath() / (std::to_string(uuid) + ".res");
-        if(std::filesystem::exists(cacheFilePath))
-        {
-            std::filesystem::remove(cacheFilePath);
-        }
-
+        // Retrieved before its cache file goes, an evicted resource is loaded back from it
         const Ref<Resource>& resource = ResourceRegistry::Get<Resource>(uuid);
 
+        // Remove the Cache file and the ones generated with it
+        CacheManager::RemoveEntry(CacheManager::GetCachedFilePath(uuid));
+
         const std::filesystem::path& resourcePath = resource->GetPath();
         std::filesystem::path importFilePath = resourcePath;
         importFilePath.replace_extension(".import");
@@ -356,6 +787,8 @@ namespace Coffee {
             std::filesystem::remove(resourcePath);
         }
 
+        ImportIndex::Remove(uuid);
+
         if(ResourceRegistry::Exists(uuid))
         {
             ResourceRegistry::Remove(uuid);
@@ -374,30 +807,109 @@ namespace Coffee {
             std::filesystem::path relativePath = std::filesystem::relative(path, s_WorkingDirectory);
             importData.originalPath = relativePath;
 
-            std::ofstream importFile(importFilePath);
-            cereal::JSONOutputArchive archive(importFile);
-            archive(CEREAL_NVP(importData));
+            {
+                std::ofstream importFile(importFilePath);
+                cereal::JSONOutputArchive archive(importFile);
+                archive(CEREAL_NVP(importData));
+            }
+
+            AddToImportIndex(importFilePath, importData);
         }
     }
 
+    void ResourceLoader::UpdateImportIndex(const std::filesystem::path& path)
+    {
+        std::filesystem::path importFilePath = path;
+        importFilePath.replace_extension(".import");
+
+        // An .import file changed since it was indexed, e.g. by version control, is read again
+        ImportEntry entry;
+        if(ImportIndex::Find(path, entry) && entry.importTime == ImportIndex::GetWriteTime(importFilePath))
+        {
+            // A source saved again is hashed again, its cache entries are reimported if the content changed
+            int64_t sourceTime = ImportIndex::GetWriteTime(path);
+            if(entry.sourceTime != sourceTime)
+            {
+                entry.sourceHash = ImportIndex::HashFile(path);
+                entry.sourceTime = sourceTime;
+                ImportIndex::Add(entry);
+            }
+            return;
+        }
+
+        if(!std::filesystem::exists(importFilePath))
+        {
+            COFFEE_CORE_INFO("ResourceLoader::UpdateImportIndex: Generating import file for {0}", path.string());
+            GenerateImportFile(path);
+            return;
+        }
+
+        ImportData importData;
+        ReadImportFile(importFilePath, importData);
+    }
+
+    bool ResourceLoader::ReadImportFile(const std::filesystem::path& importFilePath, ImportData& importData)
+    {
+        std::ifstream importFile(importFilePath);
+        if(!importFile)
+        {
+            return false;
+        }
+
+        cereal::JSONInputArchive archive(importFile);
+        archive(CEREAL_NVP(importData));
+
+        AddToImportIndex(importFilePath, importData);
+        return true;
+    }
+
+    void ResourceLoader::AddToImportIndex(const std::filesystem::path& importFilePath, const ImportData& importData)
+    {
+        const std::filesystem::path sourcePath = s_WorkingDirectory / importData.originalPath;
+
+        ImportEntry entry;
+        entry.uuid = importData.uuid;
+        entry.type = GetResourceTypeFromExtension(importData.originalPath);
+        entry.sourcePath = importData.originalPath;
+        entry.importPath = std::filesystem::absolute(importFilePath).lexically_normal().lexically_relative(s_WorkingDirectory);
+        entry.sourceHash = ImportIndex::HashFile(sourcePath);
+        entry.sourceTime = ImportIndex::GetWriteTime(sourcePath);
+        entry.importTime = ImportIndex::GetWriteTime(importFilePath);
+
+        // Where ResourceImporter caches each type
+        switch (entry.type)
+        {
+            case ResourceType::Texture2D:
+            case ResourceType::Cubemap:
+                entry.cachePath = std::to_string(entry.uuid) + ".res";
+                break;
+            case ResourceType::Model:
+                entry.cachePath = importData.originalPath.filename().string() + ".res";
+                break;
+            default:
+                break;
+        }
+
+        ImportIndex::Add(entry);
+    }
+
     ResourceLoader::ImportData ResourceLoader::GetImportData(const std::filesystem::path& path)
     {
         ImportData importData;
 
+        ImportEntry entry;
+        if(ImportIndex::Find(path, entry))
+        {
+            importData.uuid = entry.uuid;
+            importData.originalPath = s_WorkingDirectory / entry.sourcePath;
+            return importData;
+        }
+
         std::filesystem::path importFilePath = path;
         importFilePath.replace_extension(".import");
 
-        /* TODO: add the path serialization relative to the project directory.
-         * This means that when we load the path from the .import file we need to append the project directory
-         * 
-        */
-
-        if(std::filesystem::exists(importFilePath))
+        if(ReadImportFile(importFilePath, importData))
         {
-            std::ifstream importFile(importFilePath);
-            cereal::JSONInputArchive archive(importFile);
-            archive(CEREAL_NVP(importData));
-
             // Convert the relative path to an absolute path
             importData.originalPath = s_WorkingDirectory / importData.originalPath;
         }
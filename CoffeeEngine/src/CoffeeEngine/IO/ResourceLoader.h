@@ -7,11 +7,14 @@
 #pragma once
 
 #include "CoffeeEngine/Core/UUID.h"
+#include "CoffeeEngine/Events/Event.h"
+#include "CoffeeEngine/IO/ResourceHandle.h"
 #include "CoffeeEngine/IO/ResourceImporter.h"
 #include "CoffeeEngine/Math/BoundingBox.h"
 #include "CoffeeEngine/Renderer/Shader.h"
 #include "CoffeeEngine/Renderer/Texture.h"
 #include <filesystem>
+#include <functional>
 
 namespace Coffee {
 
@@ -28,11 +31,20 @@ namespace Coffee {
     class ResourceLoader
     {
     public:
+        using EventCallbackFn = std::function<void(Event&)>;
+        using ProgressCallbackFn = std::function<void(uint32_t loaded, uint32_t total)>;
+
         /**
-         * @brief Loads all resources from a directory.
+         * @brief Loads all resources from a directory on every core. Main thread only.
+         *
+         * The directory is scanned first, then the textures are decoded by the job system while the shaders
+         * and cubemaps are created on the main thread, and the models are imported once the textures they
+         * reference are loaded.
+         *
          * @param directory The directory to load resources from.
+         * @param progress Called on the main thread when the number of loaded resources changes.
          */
-        static void LoadDirectory(const std::filesystem::path& directory);
+        static void LoadDirectory(const std::filesystem::path& directory, const ProgressCallbackFn& progress = nullptr);
 
         /**
          * @brief Loads a single resource file.
@@ -71,6 +83,97 @@ namespace Coffee {
         static Ref<Material> LoadMaterial(const std::string& name, MaterialTextures& materialTextures);
         static Ref<Material> LoadMaterial(UUID uuid);
 
+        /**
+         * @brief Starts loading a resource on a job thread. Its GPU objects are created by the upload queue,
+         * and a ResourceLoadedEvent is raised once it is ready. Available for Texture2D, Mesh and Material.
+         * @tparam T The type of the resource.
+         * @param uuid The UUID of the resource to load.
+         * @return A handle giving a placeholder until the resource is ready.
+         */
+        template <typename T>
+        static ResourceHandle<T> LoadAsync(UUID uuid);
+
+        /**
+         * @brief Starts loading a resource file on a job thread, see LoadAsync(UUID). Available for Texture2D
+         * and Model.
+         * @tparam T The type of the resource.
+         * @param path The file path of the resource to load.
+         * @return A handle giving a placeholder until the resource is ready.
+         */
+        template <typename T>
+        static ResourceHandle<T> LoadAsync(const std::filesystem::path& path);
+
+        /**
+         * @brief Starts loading a texture file on a job thread, see LoadAsync(UUID).
+         * @param path The file path of the texture to load.
+         * @param srgb Whether the texture should be loaded in sRGB format.
+         * @return A handle giving a placeholder until the texture is ready.
+         */
+        static ResourceHandle<Texture2D> LoadTexture2DAsync(const std::filesystem::path& path, bool srgb = true);
+
+        /**
+         * @brief Sets the callback receiving the ResourceLoadedEvent of asynchronous loads.
+         * @param callback The event callback.
+         */
+        static void SetEventCallback(const EventCallbackFn& callback) { s_EventCallback = callback; }
+
+        /**
+         * @brief Sets the residency given to the resources of a type when they are loaded.
+         * @param type The type of the resources.
+         * @param residency The residency, CPUAndGPU by default, GPUOnly for textures, cubemaps and meshes.
+         */
+        static void SetDefaultResidency(ResourceType type, ResourceResidency residency);
+
+        /**
+         * @brief Gets the residency given to the resources of a type when they are loaded.
+         * @param type The type of the resources.
+         * @return The residency.
+         */
+        static ResourceResidency GetDefaultResidency(ResourceType type);
+
+        /**
+         * @brief Reads a resource back from the cache without creating GPU objects or registering it, used by
+         * resources to get back the CPU data they released.
+         * @param uuid The UUID of the resource.
+         * @return A new instance of the resource, nullptr if it is not cached.
+         */
+        static Ref<Resource> LoadCPUData(UUID uuid);
+
+        /**
+         * @brief Sets the memory the loaded resources may use before the least recently used ones that
+         * nothing references are evicted, see EnforceMemoryBudget.
+         * @param cpuBudget The CPU memory budget in bytes, 0 for no limit.
+         * @param gpuBudget The estimated GPU memory budget in bytes, 0 for no limit.
+         */
+        static void SetMemoryBudget(uint64_t cpuBudget, uint64_t gpuBudget) { s_CPUMemoryBudget = cpuBudget; s_GPUMemoryBudget = gpuBudget; }
+
+        /**
+         * @brief Gets the CPU memory budget of the loaded resources.
+         * @return The budget in bytes, 0 for no limit.
+         */
+        static uint64_t GetCPUMemoryBudget() { return s_CPUMemoryBudget; }
+
+        /**
+         * @brief Gets the GPU memory budget of the loaded resources.
+         * @return The budget in bytes, 0 for no limit.
+         */
+        static uint64_t GetGPUMemoryBudget() { return s_GPUMemoryBudget; }
+
+        /**
+         * @brief Evicts the least recently used resources only referenced by the registry until the memory
+         * budget is met. Evicted resources are loaded back from the cache when retrieved. Called every frame.
+         * Main thread only.
+         */
+        static void EnforceMemoryBudget();
+
+        /**
+         * @brief Loads a resource again after it was evicted.
+         * @param uuid The UUID of the resource.
+         * @param type The type of the resource.
+         * @return A reference to the resource, nullptr if it can not be loaded from the cache.
+         */
+        static Ref<Resource> Reload(UUID uuid, ResourceType type);
+
         static void RemoveResource(UUID uuid);
         static void RemoveResource(const std::filesystem::path& path);
 
@@ -91,11 +194,25 @@ namespace Coffee {
         static void GenerateImportFile(const std::filesystem::path& path);
         static ImportData GetImportData(const std::filesystem::path& path);
 
+        static void UpdateImportIndex(const std::filesystem::path& path);
+        static bool ReadImportFile(const std::filesystem::path& importFilePath, ImportData& importData);
+        static void AddToImportIndex(const std::filesystem::path& importFilePath, const ImportData& importData);
+
         static UUID GetUUIDFromImportFile(const std::filesystem::path& path);
         static std::filesystem::path GetPathFromImportFile(const std::filesystem::path& path);
+
+        static bool IsReloadable(UUID uuid, ResourceType type);
+
+        static Ref<ResourceLoadState> StartAsync(ResourceType type, UUID uuid, const Ref<Resource>& placeholder,
+                                                 std::function<Ref<Resource>()> load);
     private:
         static std::filesystem::path s_WorkingDirectory; ///< The working directory of the resource loader.
         static ResourceImporter s_Importer; ///< The importer used to load resources.
+        static EventCallbackFn s_EventCallback; ///< Receives the events of asynchronous loads.
+        static uint64_t s_CPUMemoryBudget; ///< CPU memory the resources may use, 0 for no limit.
+        static uint64_t s_GPUMemoryBudget; ///< GPU memory the resources may use, 0 for no limit.
+
+        friend struct ResourceLoadState;
     };
 
 }
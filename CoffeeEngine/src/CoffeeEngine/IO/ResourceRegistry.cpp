@@ -1,9 +1,268 @@
 #include "ResourceRegistry.h"
 #include "CoffeeEngine/Core/UUID.h"
+#include "CoffeeEngine/IO/ResourceLoader.h"
+
+#include <algorithm>
+#include <mutex>
 
 namespace Coffee {
 
-    std::unordered_map<UUID, Ref<Resource>> ResourceRegistry::m_Resources;
-    std::unordered_map<std::string, UUID> ResourceRegistry::m_NameToUUID;
+    std::array<ResourceRegistry::ResourceShard, ResourceRegistry::ShardCount> ResourceRegistry::m_Shards;
+    std::array<ResourceRegistry::NameShard, ResourceRegistry::ShardCount> ResourceRegistry::m_NameShards;
+    std::unordered_map<std::string, uint32_t, ResourceRegistry::NameHash, std::equal_to<>> ResourceRegistry::m_Names;
+    std::shared_mutex ResourceRegistry::m_NamesMutex;
+    std::atomic<uint64_t> ResourceRegistry::m_UseTick = 0;
+
+    void ResourceRegistry::Add(UUID uuid, Ref<Resource> resource)
+    {
+        std::string_view name = Intern(resource->GetName());
+
+        // The shard locks are never nested, the name index is updated once the entry is
+        std::string_view previousName;
+        bool replaced;
+        {
+            ResourceShard& shard = GetShard(uuid);
+            std::unique_lock lock(shard.mutex);
+
+            auto [it, inserted] = shard.resources.try_emplace(uuid);
+            Entry& entry = it->second;
+            replaced = !inserted;
+            previousName = entry.name;
+            entry.type = resource->GetType();
+            entry.name = name;
+            entry.lastUse = NextUseTick();
+            entry.resource = std::move(resource);
+        }
+
+        if (replaced && previousName != name)
+        {
+            NameShard& nameShard = GetNameShard(previousName);
+            std::unique_lock lock(nameShard.mutex);
+
+            auto it = nameShard.uuids.find(previousName);
+            if (it != nameShard.uuids.end() && it->second == uuid)
+            {
+                nameShard.uuids.erase(it);
+                Release(previousName);
+            }
+        }
+
+        {
+            NameShard& nameShard = GetNameShard(name);
+            std::unique_lock lock(nameShard.mutex);
+
+            auto [it, inserted] = nameShard.uuids.try_emplace(name, uuid);
+            if (inserted)
+                Intern(name);
+            else
+                it->second = uuid;
+        }
+
+        // The reference of the replaced entry, released last so the name outlives its uses above
+        if (replaced)
+            Release(previousName);
+    }
+
+    Ref<Resource> ResourceRegistry::GetResource(UUID uuid)
+    {
+        ResourceType type;
+        {
+            ResourceShard& shard = GetShard(uuid);
+            std::shared_lock lock(shard.mutex);
+
+            auto it = shard.resources.find(uuid);
+            if (it == shard.resources.end())
+            {
+                COFFEE_CORE_ERROR("Resource {0} not found!", (uint64_t)uuid);
+                return nullptr;
+            }
+
+            if (it->second.resource)
+            {
+                std::atomic_ref<uint64_t>(it->second.lastUse).store(NextUseTick(), std::memory_order_relaxed);
+                return it->second.resource;
+            }
+
+            type = it->second.type;
+        }
+
+        return Reload(uuid, type);
+    }
+
+    Ref<Resource> ResourceRegistry::TryGetResource(UUID uuid)
+    {
+        ResourceShard& shard = GetShard(uuid);
+        std::shared_lock lock(shard.mutex);
+
+        auto it = shard.resources.find(uuid);
+        if (it == shard.resources.end() || !it->second.resource)
+            return nullptr;
+
+        std::atomic_ref<uint64_t>(it->second.lastUse).store(NextUseTick(), std::memory_order_relaxed);
+        return it->second.resource;
+    }
+
+    bool ResourceRegistry::Exists(UUID uuid)
+    {
+        ResourceShard& shard = GetShard(uuid);
+        std::shared_lock lock(shard.mutex);
+        return shard.resources.find(uuid) != shard.resources.end();
+    }
+
+    void ResourceRegistry::Remove(UUID uuid)
+    {
+        Ref<Resource> removed;
+        std::string_view name;
+        {
+            ResourceShard& shard = GetShard(uuid);
+            std::unique_lock lock(shard.mutex);
+
+            auto it = shard.resources.find(uuid);
+            if (it == shard.resources.end())
+                return;
+
+            removed = std::move(it->second.resource);
+            name = it->second.name;
+            shard.resources.erase(it);
+        }
+
+        // Another resource may have been registered with the same name since, its mapping stays
+        NameShard& nameShard = GetNameShard(name);
+        std::unique_lock lock(nameShard.mutex);
+
+        auto it = nameShard.uuids.find(name);
+        if (it != nameShard.uuids.end() && it->second == uuid)
+        {
+            nameShard.uuids.erase(it);
+            Release(name);
+        }
+
+        Release(name);
+    }
+
+    void ResourceRegistry::Clear()
+    {
+        for (ResourceShard& shard : m_Shards)
+        {
+            std::unique_lock lock(shard.mutex);
+            shard.resources.clear();
+        }
+
+        for (NameShard& nameShard : m_NameShards)
+        {
+            std::unique_lock lock(nameShard.mutex);
+            nameShard.uuids.clear();
+        }
+
+        std::unique_lock lock(m_NamesMutex);
+        m_Names.clear();
+    }
+
+    UUID ResourceRegistry::GetUUIDByName(std::string_view name)
+    {
+        NameShard& nameShard = GetNameShard(name);
+        std::shared_lock lock(nameShard.mutex);
+
+        auto it = nameShard.uuids.find(name);
+        return it != nameShard.uuids.end() ? it->second : UUID::null;
+    }
+
+    std::vector<EvictionCandidate> ResourceRegistry::GetEvictionCandidates()
+    {
+        std::vector<EvictionCandidate> candidates;
+        for (ResourceShard& shard : m_Shards)
+        {
+            std::shared_lock lock(shard.mutex);
+
+            for (auto& [uuid, entry] : shard.resources)
+            {
+                // Anything else holding the resource, a component or a load in flight, keeps it loaded
+                if (entry.resource && entry.resource.use_count() == 1)
+                {
+                    uint64_t lastUse = std::atomic_ref<uint64_t>(entry.lastUse).load(std::memory_order_relaxed);
+                    candidates.push_back({uuid, entry.type, lastUse, entry.resource->GetCPUMemoryUsage(),
+                                          entry.resource->GetGPUMemoryUsage()});
+                }
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const EvictionCandidate& a, const EvictionCandidate& b) { return a.lastUse < b.lastUse; });
+        return candidates;
+    }
+
+    bool ResourceRegistry::Evict(UUID uuid)
+    {
+        Ref<Resource> evicted;
+        {
+            ResourceShard& shard = GetShard(uuid);
+            std::unique_lock lock(shard.mutex);
+
+            auto it = shard.resources.find(uuid);
+            if (it == shard.resources.end() || !it->second.resource || it->second.resource.use_count() != 1)
+                return false;
+
+            evicted = std::move(it->second.resource);
+        }
+
+        // Destroyed here, outside of the lock
+        return true;
+    }
+
+    std::vector<std::pair<UUID, ResourceEntry>> ResourceRegistry::GetSnapshot()
+    {
+        std::vector<std::pair<UUID, ResourceEntry>> snapshot;
+        for (ResourceShard& shard : m_Shards)
+        {
+            std::shared_lock lock(shard.mutex);
+
+            snapshot.reserve(snapshot.size() + shard.resources.size());
+            for (auto& [uuid, entry] : shard.resources)
+            {
+                uint64_t lastUse = std::atomic_ref<uint64_t>(entry.lastUse).load(std::memory_order_relaxed);
+                snapshot.emplace_back(uuid, ResourceEntry{entry.resource, entry.type, std::string(entry.name), lastUse});
+            }
+        }
+
+        return snapshot;
+    }
+
+    size_t ResourceRegistry::GetInternedNameCount()
+    {
+        std::shared_lock lock(m_NamesMutex);
+        return m_Names.size();
+    }
+
+    Ref<Resource> ResourceRegistry::Reload(UUID uuid, ResourceType type)
+    {
+        Ref<Resource> resource = ResourceLoader::Reload(uuid, type);
+        if (!resource)
+        {
+            COFFEE_CORE_ERROR("Resource {0} was evicted and could not be loaded back!", (uint64_t)uuid);
+        }
+        return resource;
+    }
+
+    std::string_view ResourceRegistry::Intern(std::string_view name)
+    {
+        // Only called when a resource is added, lookups hash the name index directly
+        std::unique_lock lock(m_NamesMutex);
+
+        auto it = m_Names.find(name);
+        if (it == m_Names.end())
+            it = m_Names.emplace(std::string(name), 0).first;
+
+        ++it->second;
+        return it->first;
+    }
+
+    void ResourceRegistry::Release(std::string_view name)
+    {
+        std::unique_lock lock(m_NamesMutex);
+
+        auto it = m_Names.find(name);
+        if (it != m_Names.end() && --it->second == 0)
+            m_Names.erase(it);
+    }
 
-} // namespace Coffee
\ No newline at end of file
+} // namespace Coffee
@@ -9,110 +9,213 @@
 #include "CoffeeEngine/Core/Base.h"
 #include "CoffeeEngine/Core/UUID.h"
 #include "CoffeeEngine/IO/Resource.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <vector>
 
 namespace Coffee {
 
     //TODO: Update the Resource Registry to use the path as key to avoid collisions.
 
+    /**
+     * @brief A resource known to the registry.
+     */
+    struct ResourceEntry
+    {
+        Ref<Resource> resource; ///< The resource, null while it is evicted.
+        ResourceType type = ResourceType::Unknown; ///< The type of the resource, kept while it is evicted.
+        std::string name; ///< The name the resource was registered with.
+        uint64_t lastUse = 0; ///< When the resource was last retrieved, in registry use ticks.
+    };
+
+    /**
+     * @brief A resource that can be evicted, see ResourceRegistry::GetEvictionCandidates.
+     */
+    struct EvictionCandidate
+    {
+        UUID uuid = UUID::null; ///< The UUID of the resource.
+        ResourceType type = ResourceType::Unknown; ///< The type of the resource.
+        uint64_t lastUse = 0; ///< When the resource was last retrieved.
+        uint64_t cpuMemory = 0; ///< The CPU memory the eviction frees.
+        uint64_t gpuMemory = 0; ///< The GPU memory the eviction frees.
+    };
+
     /**
      * @class ResourceRegistry
      * @brief Manages the registration and retrieval of resources.
+     *
+     * A resource only referenced by the registry can be evicted to free its memory. The registry keeps its
+     * entry, and retrieving it loads it back from the cache.
+     *
+     * Thread safe. The resources are spread over shards by UUID and the names over shards of their own, each
+     * shard with a reader-writer lock, so lookups from job threads only contend with inserts to the same shard.
+     * Names are interned, an entry and the name index share a single copy.
      */
     class ResourceRegistry
     {
     public:
         /**
-         * @brief Adds a resource to the registry.
-         * @param name The name of the resource.
+         * @brief Adds a resource to the registry, or replaces the one with the same UUID.
+         * @param uuid The UUID of the resource.
          * @param resource A reference to the resource to add.
          */
-        static void Add(UUID uuid, Ref<Resource> resource)
-        { 
-            m_Resources[uuid] = resource;
-
-            const std::string& name = resource->GetName();
-            m_NameToUUID[name] = uuid;
-        }
+        static void Add(UUID uuid, Ref<Resource> resource);
 
         /**
-         * @brief Retrieves a resource from the registry.
+         * @brief Retrieves a resource from the registry, loading it back if it was evicted.
          * @tparam T The type of the resource.
-         * @param name The name of the resource.
+         * @param uuid The UUID of the resource.
          * @return A reference to the resource, or nullptr if not found.
          */
         template<typename T>
         static Ref<T> Get(UUID uuid)
         {
-            if (!Exists(uuid))
-            {
-                COFFEE_CORE_ERROR("Resource {0} not found!", (uint64_t)uuid);
-                return nullptr;
-            }
-            return std::static_pointer_cast<T>(m_Resources[uuid]);
+            return std::static_pointer_cast<T>(GetResource(uuid));
         }
 
         /**
-         * @brief Retrieves a resource from the registry.
+         * @brief Retrieves a resource from the registry, loading it back if it was evicted.
+         * @tparam T The type of the resource.
          * @param name The name of the resource.
          * @return A reference to the resource, or nullptr if not found.
          */
-         template<typename T>
-        static Ref<T> Get(const std::string& name)
+        template<typename T>
+        static Ref<T> Get(std::string_view name)
         {
-            if (!Exists(name))
+            UUID uuid = GetUUIDByName(name);
+            if (uuid == UUID::null)
             {
                 COFFEE_CORE_ERROR("Resource {0} not found!", name);
                 return nullptr;
             }
-            return std::static_pointer_cast<T>(m_Resources[m_NameToUUID[name]]);
+
+            return std::static_pointer_cast<T>(GetResource(uuid));
         }
 
         /**
-         * @brief Checks if a resource exists in the registry.
-         * @param name The name of the resource.
+         * @brief Retrieves a resource if it is loaded, without loading it back when evicted.
+         * @tparam T The type of the resource.
+         * @param uuid The UUID of the resource.
+         * @return A reference to the resource, or nullptr if it is unknown or evicted.
+         */
+        template<typename T>
+        static Ref<T> TryGet(UUID uuid)
+        {
+            return std::static_pointer_cast<T>(TryGetResource(uuid));
+        }
+
+        /**
+         * @brief Checks if a resource exists in the registry, loaded or evicted.
+         * @param uuid The UUID of the resource.
          * @return True if the resource exists, false otherwise.
          */
-        static bool Exists(UUID uuid) { return m_Resources.find(uuid) != m_Resources.end(); }
+        static bool Exists(UUID uuid);
 
         /**
-         * @brief Checks if a resource exists in the registry.
+         * @brief Checks if a resource exists in the registry, loaded or evicted.
          * @param name The name of the resource.
          * @return True if the resource exists, false otherwise.
          */
-        static bool Exists(const std::string& name) { return m_NameToUUID.find(name) != m_NameToUUID.end(); }
+        static bool Exists(std::string_view name) { return GetUUIDByName(name) != UUID::null; }
 
-        static void Remove(UUID uuid)
-        {
-            if (Exists(uuid))
-            {
-                m_NameToUUID.erase(m_Resources[uuid]->GetName());
-                m_Resources.erase(uuid);
-            }
-        }
+        /**
+         * @brief Removes a resource from the registry.
+         * @param uuid The UUID of the resource.
+         */
+        static void Remove(UUID uuid);
 
         /**
-         * @brief Clears all resources from the registry.
+         * @brief Clears all resources from the registry. No other thread may use the registry meanwhile.
          */
-        static void Clear() 
-        {
-            m_Resources.clear();
-            m_NameToUUID.clear();
-        }
+        static void Clear();
+
+        /**
+         * @brief Gets the UUID a name was last registered with.
+         * @param name The name of the resource.
+         * @return The UUID of the resource, UUID::null if no resource has that name.
+         */
+        static UUID GetUUIDByName(std::string_view name);
+
+        /**
+         * @brief Gets the loaded resources only referenced by the registry, least recently used first.
+         * @return The resources that can be evicted.
+         */
+        static std::vector<EvictionCandidate> GetEvictionCandidates();
+
+        /**
+         * @brief Releases the registry reference to a resource, if it is still the only one. Its entry is
+         * kept, and Get loads it back. Main thread only, the resource may be destroyed.
+         * @param uuid The UUID of the resource.
+         * @return True if the resource was evicted.
+         */
+        static bool Evict(UUID uuid);
 
-        static UUID GetUUIDByName(const std::string& name) { return m_NameToUUID[name]; }
+        /**
+         * @brief Copies the entries of the registry. Each shard is copied under its lock, entries added or
+         * removed meanwhile may be missing.
+         * @return The UUIDs and entries of the registered resources.
+         */
+        static std::vector<std::pair<UUID, ResourceEntry>> GetSnapshot();
 
         /**
-         * @brief Gets the entire resource registry.
-         * @return A constant reference to the resource registry.
+         * @brief Gets the number of interned names, those still used by an entry or the name index.
+         * @return The number of interned names.
          */
-        static const std::unordered_map<UUID, Ref<Resource>>& GetResourceRegistry() { return m_Resources; }
+        static size_t GetInternedNameCount();
+
+    private:
+        static constexpr size_t ShardCount = 16; ///< The number of resource shards, and of name shards.
+
+        struct Entry
+        {
+            Ref<Resource> resource;
+            ResourceType type = ResourceType::Unknown;
+            std::string_view name; ///< Interned, holds a reference to it, see Intern.
+            alignas(std::atomic_ref<uint64_t>::required_alignment) uint64_t lastUse = 0; ///< Written through an atomic_ref under a shared lock.
+        };
+
+        struct ResourceShard
+        {
+            std::unordered_map<UUID, Entry> resources;
+            std::shared_mutex mutex;
+        };
+
+        struct NameShard
+        {
+            std::unordered_map<std::string_view, UUID> uuids; ///< Keys are interned, each holds a reference to it, see Intern.
+            std::shared_mutex mutex;
+        };
+
+        struct NameHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view name) const { return std::hash<std::string_view>()(name); }
+        };
+
+        static Ref<Resource> GetResource(UUID uuid);
+        static Ref<Resource> TryGetResource(UUID uuid);
+        static Ref<Resource> Reload(UUID uuid, ResourceType type);
+
+        static std::string_view Intern(std::string_view name);
+        static void Release(std::string_view name);
+        static uint64_t NextUseTick() { return m_UseTick.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+        static ResourceShard& GetShard(UUID uuid) { return m_Shards[std::hash<UUID>()(uuid) % ShardCount]; }
+        static NameShard& GetNameShard(std::string_view name) { return m_NameShards[std::hash<std::string_view>()(name) % ShardCount]; }
 
     private:
-        static std::unordered_map<UUID, Ref<Resource>> m_Resources; ///< The resource registry.
-        static std::unordered_map<std::string, UUID> m_NameToUUID; ///< The mapping of resource names to UUIDs.
+        static std::array<ResourceShard, ShardCount> m_Shards; ///< The resources by UUID.
+        static std::array<NameShard, ShardCount> m_NameShards; ///< The mapping of resource names to UUIDs.
+        static std::unordered_map<std::string, uint32_t, NameHash, std::equal_to<>> m_Names; ///< The interned names and the number of entries and name index keys using them.
+        static std::shared_mutex m_NamesMutex; ///< Guards the interned names.
+        static std::atomic<uint64_t> m_UseTick; ///< Incremented every time a resource is retrieved.
     };
 
 }
 
-/** @} */
\ No newline at end of file
+/** @} */
@@ -1,10 +1,14 @@
 #include "ResourceSaver.h"
 #include "CoffeeEngine/IO/Resource.h"
 #include "CoffeeEngine/IO/ResourceFormat.h"
+#include "CoffeeEngine/IO/CacheBuffer.h"
 #include "CoffeeEngine/IO/CacheManager.h"
+#include "CoffeeEngine/Core/Log.h"
 #include <cereal/archives/binary.hpp>
 #include <cereal/archives/json.hpp>
+#include <cereal/types/vector.hpp>
 #include <fstream>
+#include <sstream>
 
 namespace Coffee
 {
@@ -50,11 +54,42 @@ namespace Coffee
             break;
         }
     }
-    void ResourceSaver::SaveToCache(const std::string& filename, const Ref<Resource>& resource)
+    void ResourceSaver::SaveToCache(const std::string& filename, const Ref<Resource>& resource, const CacheHeader& header)
     {
         std::filesystem::path cacheFilePath = CacheManager::GetCachedFilePath(filename);
 
-        Save(cacheFilePath, resource);
+        // Written next to the entry and renamed over it, so a reader never sees half an entry
+        std::filesystem::path tempFilePath = cacheFilePath;
+        tempFilePath += ".tmp";
+        {
+            // The buffers of the resource go after its serialized data, aligned, so loads can map them in place
+            CachePayloadWriter payload;
+            std::ostringstream metadata(std::ios::binary);
+            {
+                cereal::BinaryOutputArchive metadataArchive(metadata);
+                metadataArchive(resource);
+            }
+            const std::string metadataBytes = metadata.str();
+
+            std::ofstream file{tempFilePath, std::ios::binary};
+            {
+                cereal::BinaryOutputArchive oArchive(file);
+                oArchive(CacheHeader::MappedMagic, header, static_cast<uint64_t>(metadataBytes.size()));
+            }
+            file.write(metadataBytes.data(), static_cast<std::streamsize>(metadataBytes.size()));
+
+            static const char padding[CachePayloadWriter::Alignment] = {};
+            const uint64_t position = static_cast<uint64_t>(file.tellp());
+            file.write(padding, static_cast<std::streamsize>((CachePayloadWriter::Alignment - position % CachePayloadWriter::Alignment) % CachePayloadWriter::Alignment));
+            payload.WriteTo(file);
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempFilePath, cacheFilePath, error);
+        if (error)
+        {
+            COFFEE_CORE_ERROR("ResourceSaver::SaveToCache: Failed to write {0} ({1})", cacheFilePath.string(), error.message());
+        }
     }
 
     void ResourceSaver::BinarySerialization(const std::filesystem::path& path, const Ref<Resource>& resource)
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/IO/CacheManager.h"
 #include "CoffeeEngine/IO/Resource.h"
 
 namespace Coffee
@@ -35,10 +36,12 @@ namespace Coffee
         static void Save(const std::filesystem::path& path, const Ref<Resource>& resource);
 
         /**
-         * @brief Saves a resource to the project cache.
+         * @brief Saves a resource to the project cache, after a header used to validate the entry.
+         * @param filename The name of the cache file, without extension.
          * @param resource A reference to the resource to save to cache.
+         * @param header The header describing what the entry was generated from.
          */
-        static void SaveToCache(const std::string& filename, const Ref<Resource>& resource);
+        static void SaveToCache(const std::string& filename, const Ref<Resource>& resource, const CacheHeader& header);
       private:
         /**
          * @brief Serializes a resource to a binary file.
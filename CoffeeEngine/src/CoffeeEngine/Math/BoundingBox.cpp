@@ -0,0 +1,63 @@
+#include "BoundingBox.h"
+
+#include <tracy/Tracy.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define COFFEE_BOUNDS_SSE 1
+    #include <emmintrin.h>
+#endif
+
+namespace Coffee {
+
+    void TransformAABBs(const AABB* boxes, const glm::mat4* transforms, AABB* out, uint32_t count)
+    {
+        ZoneScoped;
+
+#ifdef COFFEE_BOUNDS_SSE
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const float* matrix = &transforms[i][0][0];
+            const __m128 column0 = _mm_loadu_ps(matrix);
+            const __m128 column1 = _mm_loadu_ps(matrix + 4);
+            const __m128 column2 = _mm_loadu_ps(matrix + 8);
+            const __m128 column3 = _mm_loadu_ps(matrix + 12);
+
+            const AABB& box = boxes[i];
+            const __m128 min = _mm_setr_ps(box.min.x, box.min.y, box.min.z, 0.0f);
+            const __m128 max = _mm_setr_ps(box.max.x, box.max.y, box.max.z, 0.0f);
+            const __m128 center = _mm_mul_ps(_mm_add_ps(min, max), half);
+            const __m128 extent = _mm_mul_ps(_mm_sub_ps(max, min), half);
+
+            // Broadcast each component of the center and the extent to multiply whole columns
+            const __m128 centerX = _mm_shuffle_ps(center, center, _MM_SHUFFLE(0, 0, 0, 0));
+            const __m128 centerY = _mm_shuffle_ps(center, center, _MM_SHUFFLE(1, 1, 1, 1));
+            const __m128 centerZ = _mm_shuffle_ps(center, center, _MM_SHUFFLE(2, 2, 2, 2));
+            const __m128 extentX = _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0));
+            const __m128 extentY = _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1));
+            const __m128 extentZ = _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2));
+
+            const __m128 newCenter = _mm_add_ps(_mm_add_ps(_mm_mul_ps(column0, centerX), _mm_mul_ps(column1, centerY)),
+                                                _mm_add_ps(_mm_mul_ps(column2, centerZ), column3));
+            const __m128 newExtent = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(column0, absMask), extentX),
+                                                           _mm_mul_ps(_mm_and_ps(column1, absMask), extentY)),
+                                                _mm_mul_ps(_mm_and_ps(column2, absMask), extentZ));
+
+            alignas(16) float newMin[4];
+            alignas(16) float newMax[4];
+            _mm_store_ps(newMin, _mm_sub_ps(newCenter, newExtent));
+            _mm_store_ps(newMax, _mm_add_ps(newCenter, newExtent));
+
+            out[i] = AABB(glm::vec3(newMin[0], newMin[1], newMin[2]), glm::vec3(newMax[0], newMax[1], newMax[2]));
+        }
+#else
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            out[i] = boxes[i].CalculateTransformedAABB(transforms[i]);
+        }
+#endif
+    }
+
+}
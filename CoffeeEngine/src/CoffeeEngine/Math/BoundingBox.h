@@ -4,6 +4,8 @@
 #include <cereal/access.hpp>
 
 #include <array>
+#include <cstdint>
+#include <vector>
 
 namespace Coffee {
 
@@ -46,41 +48,26 @@ namespace Coffee {
             return min.x < max.x && min.y < max.y && min.z < max.z;
         }
 
+        /**
+         * @brief Calculates the bounds of the box after an affine transformation.
+         *
+         * Uses Arvo's method in center/extent form: the center is transformed as a point and the new extent is
+         * the absolute value of the upper 3x3 matrix times the extent, instead of transforming the 8 corners.
+         *
+         * @param transform The affine transformation matrix.
+         * @return The transformed AABB.
+         */
         AABB CalculateTransformedAABB(const glm::mat4& transform) const
         {
-            AABB aabb = *this;
-
-            // Compute the 8 corners of the AABB
-            glm::vec3 corners[8] = {
-                aabb.min,
-                glm::vec3(aabb.min.x, aabb.min.y, aabb.max.z),
-                glm::vec3(aabb.min.x, aabb.max.y, aabb.min.z),
-                glm::vec3(aabb.min.x, aabb.max.y, aabb.max.z),
-                glm::vec3(aabb.max.x, aabb.min.y, aabb.min.z),
-                glm::vec3(aabb.max.x, aabb.min.y, aabb.max.z),
-                glm::vec3(aabb.max.x, aabb.max.y, aabb.min.z),
-                aabb.max
-            };
-
-            // Transform the corners
-            glm::vec3 transformedCorners[8];
-            for (int i = 0; i < 8; ++i) {
-                transformedCorners[i] = glm::vec3(transform * glm::vec4(corners[i], 1.0f));
-            }
-
-            // Find the new min and max points
-            glm::vec3 newMin = transformedCorners[0];
-            glm::vec3 newMax = transformedCorners[0];
-
-            for (int i = 1; i < 8; ++i) {
-                newMin = glm::min(newMin, transformedCorners[i]);
-                newMax = glm::max(newMax, transformedCorners[i]);
-            }
+            glm::vec3 center = GetCenter();
+            glm::vec3 extent = GetHalfSize();
 
-            // Create the transformed AABB
-            AABB transformedAABB(newMin, newMax);
+            glm::vec3 newCenter = glm::vec3(transform[0]) * center.x + glm::vec3(transform[1]) * center.y +
+                                  glm::vec3(transform[2]) * center.z + glm::vec3(transform[3]);
+            glm::vec3 newExtent = glm::abs(glm::vec3(transform[0])) * extent.x + glm::abs(glm::vec3(transform[1])) * extent.y +
+                                  glm::abs(glm::vec3(transform[2])) * extent.z;
 
-            return transformedAABB;
+            return AABB(newCenter - newExtent, newCenter + newExtent);
         }
 
         // Used when the AABB's min and max points are in local space of the object
@@ -135,6 +122,14 @@ namespace Coffee {
             return IntersectionType::Inside;
         }
 
+        // Used when the AABB's min and max points are in world space
+        bool OverlapsSphere(const glm::vec3& center, float radius) const {
+            glm::vec3 closest = glm::clamp(center, min, max);
+            glm::vec3 offset = center - closest;
+
+            return glm::dot(offset, offset) <= radius * radius;
+        }
+
         private:
             friend class cereal::access;
 
@@ -145,6 +140,96 @@ namespace Coffee {
             }
     };
 
+    /**
+     * @brief Transforms an array of boxes, out[i] = boxes[i].CalculateTransformedAABB(transforms[i]).
+     *
+     * Same method as AABB::CalculateTransformedAABB, with the matrix columns kept in SSE registers when
+     * available.
+     *
+     * @param boxes The boxes to transform.
+     * @param transforms The affine transformation of each box.
+     * @param out The transformed boxes, it can alias boxes.
+     * @param count The number of boxes.
+     */
+    void TransformAABBs(const AABB* boxes, const glm::mat4* transforms, AABB* out, uint32_t count);
+
+    /**
+     * @brief Array of axis-aligned bounding boxes stored as structure of arrays, in center/extent form.
+     *
+     * Every component lives in its own contiguous array so culling kernels can load the same component of
+     * several boxes with a single SIMD load.
+     */
+    struct BoundsSoA
+    {
+        std::vector<float> CenterX, CenterY, CenterZ; ///< The centers of the boxes.
+        std::vector<float> ExtentX, ExtentY, ExtentZ; ///< The half sizes of the boxes.
+
+        uint32_t Size() const { return static_cast<uint32_t>(CenterX.size()); }
+        bool Empty() const { return CenterX.empty(); }
+
+        void Clear()
+        {
+            for (auto* component : {&CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ})
+                component->clear();
+        }
+
+        void PushBack(const AABB& aabb)
+        {
+            glm::vec3 center = aabb.GetCenter();
+            glm::vec3 extent = aabb.GetHalfSize();
+            CenterX.push_back(center.x);
+            CenterY.push_back(center.y);
+            CenterZ.push_back(center.z);
+            ExtentX.push_back(extent.x);
+            ExtentY.push_back(extent.y);
+            ExtentZ.push_back(extent.z);
+        }
+
+        /**
+         * @brief Appends a copy of a box of another array, without converting it back and forth.
+         */
+        void PushBack(const BoundsSoA& other, uint32_t index)
+        {
+            CenterX.push_back(other.CenterX[index]);
+            CenterY.push_back(other.CenterY[index]);
+            CenterZ.push_back(other.CenterZ[index]);
+            ExtentX.push_back(other.ExtentX[index]);
+            ExtentY.push_back(other.ExtentY[index]);
+            ExtentZ.push_back(other.ExtentZ[index]);
+        }
+
+        void Set(uint32_t index, const AABB& aabb)
+        {
+            glm::vec3 center = aabb.GetCenter();
+            glm::vec3 extent = aabb.GetHalfSize();
+            CenterX[index] = center.x;
+            CenterY[index] = center.y;
+            CenterZ[index] = center.z;
+            ExtentX[index] = extent.x;
+            ExtentY[index] = extent.y;
+            ExtentZ[index] = extent.z;
+        }
+
+        AABB Get(uint32_t index) const
+        {
+            glm::vec3 center(CenterX[index], CenterY[index], CenterZ[index]);
+            glm::vec3 extent(ExtentX[index], ExtentY[index], ExtentZ[index]);
+            return AABB(center - extent, center + extent);
+        }
+
+        /**
+         * @brief Removes a box by moving the last one into its place.
+         */
+        void SwapRemove(uint32_t index)
+        {
+            for (auto* component : {&CenterX, &CenterY, &CenterZ, &ExtentX, &ExtentY, &ExtentZ})
+            {
+                (*component)[index] = component->back();
+                component->pop_back();
+            }
+        }
+    };
+
     /**
      * @brief Structure representing an oriented bounding box (OBB).
      */
@@ -43,6 +43,9 @@ namespace Coffee
         // Get the 8 points of the frustum
         const glm::vec3* GetPoints() const { return m_points; }
 
+        // Get the 6 planes of the frustum (left, right, bottom, top, near, far), pointing inwards and not normalized
+        const glm::vec4* GetPlanes() const { return m_planes; }
+
     private:
         enum Planes
         {
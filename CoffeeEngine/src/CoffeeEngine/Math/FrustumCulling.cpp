@@ -0,0 +1,153 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tracy/Tracy.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define COFFEE_CULLING_SSE 1
+    #include <emmintrin.h>
+#endif
+
+namespace Coffee {
+
+    IntersectionType FrustumCulling::Classify(const glm::vec4* planes, const AABB& aabb, uint32_t& planeMask)
+    {
+        glm::vec3 center = aabb.GetCenter();
+        glm::vec3 extent = aabb.GetHalfSize();
+
+        for (uint32_t plane = 0; plane < PlaneCount; ++plane)
+        {
+            if (!(planeMask & (1u << plane)))
+                continue;
+
+            glm::vec3 normal(planes[plane]);
+            float distance = glm::dot(normal, center) + planes[plane].w;
+            float radius = glm::dot(glm::abs(normal), extent);
+
+            if (distance < -radius)
+                return IntersectionType::Outside;
+
+            if (distance > radius)
+                planeMask &= ~(1u << plane);
+        }
+
+        return planeMask == 0 ? IntersectionType::Inside : IntersectionType::Intersect;
+    }
+
+    void FrustumCulling::CullBounds(const glm::vec4* planes, uint32_t planeMask, const BoundsSoA& bounds, uint64_t* visibility,
+                                    uint8_t* planeCache)
+    {
+        ZoneScoped;
+
+        const uint32_t count = bounds.Size();
+        std::fill_n(visibility, GetVisibilityWordCount(count), 0ull);
+
+        uint32_t activePlanes[PlaneCount];
+        uint32_t activeCount = 0;
+        for (uint32_t plane = 0; plane < PlaneCount; ++plane)
+        {
+            if (planeMask & (1u << plane))
+                activePlanes[activeCount++] = plane;
+        }
+
+        if (activeCount == 0)
+        {
+            for (uint32_t i = 0; i < count; ++i)
+                visibility[i / 64] |= 1ull << (i % 64);
+            return;
+        }
+
+        // Plane that rejected the group last time if it is still active, otherwise the first active one
+        auto firstPlane = [&](uint32_t group) {
+            uint32_t cached = planeCache ? planeCache[group] : activePlanes[0];
+            return (cached < PlaneCount && (planeMask & (1u << cached))) ? cached : activePlanes[0];
+        };
+
+        uint32_t i = 0;
+
+#ifdef COFFEE_CULLING_SSE
+        __m128 normalX[PlaneCount], normalY[PlaneCount], normalZ[PlaneCount], offset[PlaneCount];
+        __m128 absNormalX[PlaneCount], absNormalY[PlaneCount], absNormalZ[PlaneCount];
+        for (uint32_t plane = 0; plane < PlaneCount; ++plane)
+        {
+            normalX[plane] = _mm_set1_ps(planes[plane].x);
+            normalY[plane] = _mm_set1_ps(planes[plane].y);
+            normalZ[plane] = _mm_set1_ps(planes[plane].z);
+            offset[plane] = _mm_set1_ps(planes[plane].w);
+            absNormalX[plane] = _mm_set1_ps(std::abs(planes[plane].x));
+            absNormalY[plane] = _mm_set1_ps(std::abs(planes[plane].y));
+            absNormalZ[plane] = _mm_set1_ps(std::abs(planes[plane].z));
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const __m128 centerX = _mm_loadu_ps(&bounds.CenterX[i]);
+            const __m128 centerY = _mm_loadu_ps(&bounds.CenterY[i]);
+            const __m128 centerZ = _mm_loadu_ps(&bounds.CenterZ[i]);
+            const __m128 extentX = _mm_loadu_ps(&bounds.ExtentX[i]);
+            const __m128 extentY = _mm_loadu_ps(&bounds.ExtentY[i]);
+            const __m128 extentZ = _mm_loadu_ps(&bounds.ExtentZ[i]);
+
+            // Lanes with distance + radius < 0 are outside of the plane
+            auto outsideMask = [&](uint32_t plane) {
+                __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(normalX[plane], centerX), _mm_mul_ps(normalY[plane], centerY)),
+                                             _mm_add_ps(_mm_mul_ps(normalZ[plane], centerZ), offset[plane]));
+                __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormalX[plane], extentX), _mm_mul_ps(absNormalY[plane], extentY)),
+                                           _mm_mul_ps(absNormalZ[plane], extentZ));
+                return _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero));
+            };
+
+            const uint32_t group = i / 4;
+            const uint32_t first = firstPlane(group);
+
+            int outside = outsideMask(first);
+            for (uint32_t k = 0; k < activeCount && outside != 0xF; ++k)
+            {
+                if (activePlanes[k] == first)
+                    continue;
+
+                outside |= outsideMask(activePlanes[k]);
+
+                if (outside == 0xF && planeCache)
+                    planeCache[group] = static_cast<uint8_t>(activePlanes[k]);
+            }
+
+            visibility[i / 64] |= static_cast<uint64_t>(~outside & 0xF) << (i % 64);
+        }
+#endif
+
+        // Remaining boxes, or all of them without SSE
+        for (; i < count; ++i)
+        {
+            const glm::vec3 center(bounds.CenterX[i], bounds.CenterY[i], bounds.CenterZ[i]);
+            const glm::vec3 extent(bounds.ExtentX[i], bounds.ExtentY[i], bounds.ExtentZ[i]);
+
+            auto isOutside = [&](uint32_t plane) {
+                glm::vec3 normal(planes[plane]);
+                return glm::dot(normal, center) + planes[plane].w + glm::dot(glm::abs(normal), extent) < 0.0f;
+            };
+
+            const uint32_t group = i / 4;
+            const uint32_t first = firstPlane(group);
+
+            bool outside = isOutside(first);
+            for (uint32_t k = 0; k < activeCount && !outside; ++k)
+            {
+                if (activePlanes[k] == first)
+                    continue;
+
+                outside = isOutside(activePlanes[k]);
+
+                if (outside && planeCache)
+                    planeCache[group] = static_cast<uint8_t>(activePlanes[k]);
+            }
+
+            if (!outside)
+                visibility[i / 64] |= 1ull << (i % 64);
+        }
+    }
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+namespace Coffee {
+
+    /**
+     * @brief Batched frustum culling kernels.
+     *
+     * The boxes are tested in center/extent form: a box is outside of a plane when the signed distance of its
+     * center is below minus its projected radius, dot(|n|, extent). The planes do not need to be normalized.
+     *
+     * A plane mask selects which of the six planes are tested, bit i for plane i. Hierarchical traversals
+     * clear the bits of the planes a parent is completely inside of, so the children skip them.
+     */
+    class FrustumCulling
+    {
+    public:
+        static constexpr uint32_t PlaneCount = 6;
+        static constexpr uint32_t AllPlanes = (1u << PlaneCount) - 1;
+
+        /**
+         * @brief Classifies a single box against the planes in the mask.
+         * @param planes The six frustum planes.
+         * @param aabb The box.
+         * @param planeMask The planes to test. The planes the box is completely inside of are cleared.
+         * @return Outside, Inside if the box is inside every plane of the mask, or Intersect.
+         */
+        static IntersectionType Classify(const glm::vec4* planes, const AABB& aabb, uint32_t& planeMask);
+
+        /**
+         * @brief Tests an array of boxes against the planes, four at a time with SSE when available.
+         *
+         * The plane that rejected a group of four boxes is remembered in the plane cache and tested first on
+         * the next call: from one frame to the next the same plane usually rejects the same boxes, so most
+         * invisible groups are discarded after a single plane.
+         *
+         * @param planes The six frustum planes.
+         * @param planeMask The planes to test.
+         * @param bounds The boxes.
+         * @param visibility Output bitset, bit i set if box i is visible. Must hold (Size() + 63) / 64 words.
+         * @param planeCache Optional, one entry per group of four boxes, (Size() + 3) / 4 entries. Zero
+         * initialized the first time.
+         */
+        static void CullBounds(const glm::vec4* planes, uint32_t planeMask, const BoundsSoA& bounds, uint64_t* visibility,
+                               uint8_t* planeCache = nullptr);
+
+        static uint32_t GetVisibilityWordCount(uint32_t count) { return (count + 63) / 64; }
+        static uint32_t GetPlaneCacheSize(uint32_t count) { return (count + 3) / 4; }
+    };
+
+}
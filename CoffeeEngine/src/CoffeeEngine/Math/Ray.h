@@ -0,0 +1,115 @@
+#pragma once
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+
+namespace Coffee {
+
+    /**
+     * @brief Structure representing a ray, origin + t * direction for t >= 0.
+     *
+     * The direction does not need to be normalized: distances are measured in units of the direction, so
+     * they only are world distances when it is normalized.
+     */
+    struct Ray {
+
+        glm::vec3 origin = glm::vec3(0.0f);               ///< The origin of the ray.
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f); ///< The direction of the ray.
+
+        Ray() = default;
+
+        /**
+         * @brief Constructs a ray with the specified origin and direction.
+         * @param origin The origin of the ray.
+         * @param direction The direction of the ray.
+         */
+        Ray(const glm::vec3& origin, const glm::vec3& direction)
+            : origin(origin), direction(direction) {}
+
+        glm::vec3 GetPoint(float distance) const
+        {
+            return origin + direction * distance;
+        }
+
+        /**
+         * @brief Gets the ray in the space of a transformation, keeping the distances of this ray.
+         * @param transform The transformation matrix, usually the inverse of a world transform.
+         * @return The transformed ray, its direction is not normalized.
+         */
+        Ray Transform(const glm::mat4& transform) const
+        {
+            return Ray(glm::vec3(transform * glm::vec4(origin, 1.0f)), glm::vec3(transform * glm::vec4(direction, 0.0f)));
+        }
+
+        /**
+         * @brief Intersects the ray with a box using the slab method.
+         * @param aabb The box.
+         * @param maxDistance The maximum distance along the ray.
+         * @param distance The distance where the ray enters the box, 0 if the origin is inside.
+         * @return True if the ray hits the box before maxDistance.
+         */
+        bool Intersect(const AABB& aabb, float maxDistance, float& distance) const
+        {
+            // Divisions by zero give infinities, which the min/max below handle
+            glm::vec3 inverseDirection = 1.0f / direction;
+            glm::vec3 t0 = (aabb.min - origin) * inverseDirection;
+            glm::vec3 t1 = (aabb.max - origin) * inverseDirection;
+            glm::vec3 tNear = glm::min(t0, t1);
+            glm::vec3 tFar = glm::max(t0, t1);
+
+            float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+            float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+
+            if (enter > exit)
+                return false;
+
+            distance = enter;
+            return true;
+        }
+
+        /**
+         * @brief Intersects the ray with a triangle, both faces, using the Moller-Trumbore algorithm.
+         * @param v0 The first vertex of the triangle.
+         * @param v1 The second vertex of the triangle.
+         * @param v2 The third vertex of the triangle.
+         * @param maxDistance The maximum distance along the ray.
+         * @param distance The distance of the hit.
+         * @return True if the ray hits the triangle before maxDistance.
+         */
+        bool Intersect(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float maxDistance, float& distance) const
+        {
+            constexpr float epsilon = 1e-8f;
+
+            glm::vec3 edge1 = v1 - v0;
+            glm::vec3 edge2 = v2 - v0;
+            glm::vec3 p = glm::cross(direction, edge2);
+            float determinant = glm::dot(edge1, p);
+
+            // Parallel to the triangle
+            if (std::abs(determinant) < epsilon)
+                return false;
+
+            float inverseDeterminant = 1.0f / determinant;
+            glm::vec3 s = origin - v0;
+            float u = glm::dot(s, p) * inverseDeterminant;
+            if (u < 0.0f || u > 1.0f)
+                return false;
+
+            glm::vec3 q = glm::cross(s, edge1);
+            float v = glm::dot(direction, q) * inverseDeterminant;
+            if (v < 0.0f || u + v > 1.0f)
+                return false;
+
+            float t = glm::dot(edge2, q) * inverseDeterminant;
+            if (t < 0.0f || t > maxDistance)
+                return false;
+
+            distance = t;
+            return true;
+        }
+    };
+
+}
@@ -1,6 +1,8 @@
 #include "Project.h"
 #include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Core/Log.h"
 #include "CoffeeEngine/IO/CacheManager.h"
+#include "CoffeeEngine/IO/ImportIndex.h"
 #include "CoffeeEngine/IO/ResourceRegistry.h"
 #include "CoffeeEngine/IO/ResourceLoader.h"
 
@@ -12,6 +14,8 @@ namespace Coffee {
 
     static Ref<Project> s_ActiveProject;
 
+    static constexpr uint64_t Megabyte = 1024 * 1024;
+
     Ref<Project> Project::New(const std::filesystem::path& path)
     {
         s_ActiveProject = CreateRef<Project>();
@@ -25,6 +29,8 @@ namespace Coffee {
 
         CacheManager::SetCachePath(s_ActiveProject->m_ProjectDirectory / s_ActiveProject->m_CacheDirectory);
         ResourceLoader::SetWorkingDirectory(s_ActiveProject->m_ProjectDirectory);
+        ImportIndex::Load(CacheManager::GetCachePath() / "ImportIndex.bin", s_ActiveProject->m_ProjectDirectory);
+        ResourceLoader::SetMemoryBudget(0, 0);
 
         return s_ActiveProject;
     }
@@ -46,11 +52,30 @@ namespace Coffee {
 
         CacheManager::SetCachePath(project->m_ProjectDirectory / project->m_CacheDirectory);
         ResourceLoader::SetWorkingDirectory(s_ActiveProject->m_ProjectDirectory);
-        ResourceLoader::LoadDirectory(project->m_ProjectDirectory);
+        ResourceLoader::SetMemoryBudget(project->m_CPUMemoryBudgetMB * Megabyte, project->m_GPUMemoryBudgetMB * Megabyte);
+        ImportIndex::Load(CacheManager::GetCachePath() / "ImportIndex.bin", s_ActiveProject->m_ProjectDirectory);
+        ResourceLoader::LoadDirectory(project->m_ProjectDirectory, [lastStep = 0u](uint32_t loaded, uint32_t total) mutable {
+            uint32_t step = loaded * 10 / total;
+            if (step != lastStep)
+            {
+                lastStep = step;
+                COFFEE_CORE_INFO("Project::Load: Loading resources {0}/{1}", loaded, total);
+            }
+        });
+
+        CacheManager::CollectGarbage();
 
         return project;
     }
 
+    void Project::SetMemoryBudget(uint64_t cpuBudgetMB, uint64_t gpuBudgetMB)
+    {
+        s_ActiveProject->m_CPUMemoryBudgetMB = cpuBudgetMB;
+        s_ActiveProject->m_GPUMemoryBudgetMB = gpuBudgetMB;
+
+        ResourceLoader::SetMemoryBudget(cpuBudgetMB * Megabyte, gpuBudgetMB * Megabyte);
+    }
+
     void Project::SaveActive()
     {
         std::filesystem::path path = s_ActiveProject->m_ProjectDirectory / s_ActiveProject->m_Name;
@@ -59,6 +84,8 @@ namespace Coffee {
         cereal::JSONOutputArchive archive(projectFile);
 
         archive(cereal::make_nvp("Project", *s_ActiveProject));
+
+        ImportIndex::Save();
     }
 
 }
\ No newline at end of file
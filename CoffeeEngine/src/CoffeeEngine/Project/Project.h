@@ -1,7 +1,9 @@
 #pragma once
 
 #include "CoffeeEngine/Core/Base.h"
+#include <cereal/archives/json.hpp>
 #include <cereal/cereal.hpp>
+#include <cstdint>
 #include <filesystem>
 #include <string>
 
@@ -65,23 +67,82 @@ namespace Coffee {
          */
         static std::filesystem::path GetCacheDirectory() { return s_ActiveProject->GetProjectDirectory() / s_ActiveProject->m_CacheDirectory; }
 
+        /**
+         * @brief Sets the memory the resources of the active project may use and applies it to the resource
+         * loader. Saved with the project.
+         * @param cpuBudgetMB The CPU memory budget in megabytes, 0 for no limit.
+         * @param gpuBudgetMB The GPU memory budget in megabytes, 0 for no limit.
+         */
+        static void SetMemoryBudget(uint64_t cpuBudgetMB, uint64_t gpuBudgetMB);
+
+        /**
+         * @brief Gets the CPU memory budget of the active project.
+         * @return The budget in megabytes, 0 for no limit.
+         */
+        static uint64_t GetCPUMemoryBudgetMB() { return s_ActiveProject->m_CPUMemoryBudgetMB; }
+
+        /**
+         * @brief Gets the GPU memory budget of the active project.
+         * @return The budget in megabytes, 0 for no limit.
+         */
+        static uint64_t GetGPUMemoryBudgetMB() { return s_ActiveProject->m_GPUMemoryBudgetMB; }
+
         /**
          * @brief Serializes the project data.
          * @tparam Archive The type of the archive.
          * @param archive The archive to serialize to.
          */
         template<class Archive>
-        void serialize(Archive& archive) 
+        void save(Archive& archive) const
         {
             archive(cereal::make_nvp("Name", m_Name),
                     cereal::make_nvp("StartScene",m_StartScenePath.string()),
+                    cereal::make_nvp("CacheDirectory", m_CacheDirectory),
+                    cereal::make_nvp("CPUMemoryBudgetMB", m_CPUMemoryBudgetMB),
+                    cereal::make_nvp("GPUMemoryBudgetMB", m_GPUMemoryBudgetMB));
+        }
+
+        /**
+         * @brief Deserializes the project data.
+         * @tparam Archive The type of the archive.
+         * @param archive The archive to deserialize from.
+         */
+        template<class Archive>
+        void load(Archive& archive)
+        {
+            std::string startScene;
+            archive(cereal::make_nvp("Name", m_Name),
+                    cereal::make_nvp("StartScene", startScene),
                     cereal::make_nvp("CacheDirectory", m_CacheDirectory));
+            m_StartScenePath = startScene;
+
+            // Projects saved before the memory budget existed do not have the fields, they have no limit
+            if constexpr (std::is_same_v<Archive, cereal::JSONInputArchive>)
+            {
+                try
+                {
+                    archive(cereal::make_nvp("CPUMemoryBudgetMB", m_CPUMemoryBudgetMB),
+                            cereal::make_nvp("GPUMemoryBudgetMB", m_GPUMemoryBudgetMB));
+                }
+                catch (const cereal::Exception&)
+                {
+                    m_CPUMemoryBudgetMB = 0;
+                    m_GPUMemoryBudgetMB = 0;
+                }
+            }
+            else
+            {
+                archive(cereal::make_nvp("CPUMemoryBudgetMB", m_CPUMemoryBudgetMB),
+                        cereal::make_nvp("GPUMemoryBudgetMB", m_GPUMemoryBudgetMB));
+            }
         }
 
     private:
         std::string m_Name = "Untitled"; ///< The name of the project.
         std::filesystem::path m_ProjectDirectory; ///< The directory of the project.
         std::filesystem::path m_CacheDirectory; ///< The directory of the project cache.
+        uint64_t m_CPUMemoryBudgetMB = 0; ///< The CPU memory the resources may use in megabytes, 0 for no limit.
+        uint64_t m_GPUMemoryBudgetMB = 0; ///< The GPU memory the resources may use in megabytes, 0 for no limit.
 
         std::filesystem::path m_StartScenePath; ///< The path to the start scene.
 
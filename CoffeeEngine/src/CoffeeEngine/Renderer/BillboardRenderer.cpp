@@ -1,34 +1,58 @@
 #include "CoffeeEngine/Renderer/BillboardRenderer.h"
 #include "CoffeeEngine/Renderer/Buffer.h"
+#include "CoffeeEngine/Renderer/RendererAPI.h"
+
+#include <algorithm>
 #include <tracy/Tracy.hpp>
 
 namespace Coffee
 {
     BillboardRenderer::BillboardRendererData BillboardRenderer::s_Data;
 
-    void BillboardRenderer::Init()
+    static const glm::vec2 s_QuadCorners[4] = {{-0.5f, -0.5f}, {0.5f, -0.5f}, {0.5f, 0.5f}, {-0.5f, 0.5f}};
+    static const glm::vec2 s_QuadTexCoords[4] = {{0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f}};
+
+    static glm::vec3 EntityIDToColor(uint32_t entityID)
     {
-        ZoneScoped;
+        uint32_t r = (entityID & 0x000000FF) >> 0;
+        uint32_t g = (entityID & 0x0000FF00) >> 8;
+        uint32_t b = (entityID & 0x00FF0000) >> 16;
+        return glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f);
+    }
 
-        // Create quad vertices
-        float vertices[] = {// positions        // texture coords
-                            -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 
-                            0.5f,  -0.5f, 0.0f, 1.0f, 0.0f,
-                            0.5f,  0.5f,  0.0f, 1.0f, 1.0f, 
-                            -0.5f, 0.5f,  0.0f, 0.0f, 1.0f};
+    static glm::vec3 SafeNormalize(const glm::vec3& vector)
+    {
+        float length = glm::length(vector);
+        return length > 0.0f ? vector / length : glm::vec3(0.0f);
+    }
 
-        uint32_t indices[] = {0, 1, 2, 2, 3, 0};
+    // Expands a billboard into the four world space corners of its quad
+    static void AppendQuad(std::vector<BillboardVertex>& vertices, const glm::mat4& transform, const glm::vec4& color, uint32_t entityID)
+    {
+        const glm::vec3 right = transform[0];
+        const glm::vec3 up = transform[1];
+        const glm::vec3 center = transform[3];
+        const glm::vec3 normal = SafeNormalize(transform[2]);
+        const glm::vec3 tangent = SafeNormalize(right);
+        const glm::vec3 bitangent = SafeNormalize(up);
+        const glm::vec3 entityColor = EntityIDToColor(entityID);
+
+        for (int i = 0; i < 4; ++i)
+        {
+            vertices.push_back({center + right * s_QuadCorners[i].x + up * s_QuadCorners[i].y, s_QuadTexCoords[i],
+                                normal, tangent, bitangent, color, entityColor});
+        }
+    }
 
-        s_Data.QuadVertexArray = VertexArray::Create();
-        s_Data.QuadVertexBuffer = VertexBuffer::Create(vertices, sizeof(vertices));
+    void BillboardRenderer::Init()
+    {
+        ZoneScoped;
 
-        BufferLayout layout = {{ShaderDataType::Vec3, "a_Position"}, {ShaderDataType::Vec2, "a_TexCoord"}};
+        EnsureCapacity(QuadChunkSize);
 
-        s_Data.QuadVertexBuffer->SetLayout(layout);
-        s_Data.QuadVertexArray->AddVertexBuffer(s_Data.QuadVertexBuffer);
-
-        Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indices, sizeof(indices) / sizeof(uint32_t));
-        s_Data.QuadVertexArray->SetIndexBuffer(indexBuffer);
+        uint32_t whitePixel = 0xFFFFFFFF;
+        s_Data.WhiteTexture = Texture2D::Create(1, 1, ImageFormat::RGBA8);
+        s_Data.WhiteTexture->SetData(&whitePixel, sizeof(uint32_t));
 
         if (!std::filesystem::exists("assets/shaders/Billboard.glsl"))
         {
@@ -43,6 +67,52 @@ namespace Coffee
         s_Data.QuadVertexArray.reset();
         s_Data.QuadVertexBuffer.reset();
         s_Data.BillboardShader.reset();
+        s_Data.WhiteTexture.reset();
+        s_Data.QuadCapacity = 0;
+    }
+
+    void BillboardRenderer::EnsureCapacity(uint32_t quadCount)
+    {
+        if (quadCount <= s_Data.QuadCapacity)
+            return;
+
+        ZoneScoped;
+
+        // Grow in whole chunks so a slowly increasing particle count does not recreate the buffers every frame
+        uint32_t capacity = ((quadCount + QuadChunkSize - 1) / QuadChunkSize) * QuadChunkSize;
+        capacity = std::min(capacity, MaxQuads);
+
+        std::vector<uint32_t> indices(capacity * 6);
+        for (uint32_t quad = 0; quad < capacity; ++quad)
+        {
+            uint32_t vertex = quad * 4;
+            indices[quad * 6 + 0] = vertex + 0;
+            indices[quad * 6 + 1] = vertex + 1;
+            indices[quad * 6 + 2] = vertex + 2;
+            indices[quad * 6 + 3] = vertex + 2;
+            indices[quad * 6 + 4] = vertex + 3;
+            indices[quad * 6 + 5] = vertex + 0;
+        }
+
+        s_Data.QuadVertexArray = VertexArray::Create();
+        s_Data.QuadVertexBuffer = VertexBuffer::Create(capacity * 4 * sizeof(BillboardVertex));
+
+        BufferLayout layout = {{ShaderDataType::Vec3, "a_Position"},
+                               {ShaderDataType::Vec2, "a_TexCoord"},
+                               {ShaderDataType::Vec3, "a_Normal"},
+                               {ShaderDataType::Vec3, "a_Tangent"},
+                               {ShaderDataType::Vec3, "a_Bitangent"},
+                               {ShaderDataType::Vec4, "a_Color"},
+                               {ShaderDataType::Vec3, "a_EntityID"}};
+
+        s_Data.QuadVertexBuffer->SetLayout(layout);
+        s_Data.QuadVertexArray->AddVertexBuffer(s_Data.QuadVertexBuffer);
+
+        Ref<IndexBuffer> indexBuffer = IndexBuffer::Create(indices.data(), static_cast<uint32_t>(indices.size()));
+        s_Data.QuadVertexArray->SetIndexBuffer(indexBuffer);
+
+        s_Data.QuadCapacity = capacity;
+        s_Data.Vertices.reserve(capacity * 4);
     }
 
     void BillboardRenderer::BeginScene(const glm::mat4& viewProjection, const glm::vec3& cameraPosition, const glm::vec3& cameraUp)
@@ -57,56 +127,90 @@ namespace Coffee
     {
         ZoneScoped;
 
-        for (const auto& command : s_Data.billboardQueue)
-        {
-            Material* material = command.material.get();
-            material->GetShader()->setVec4("u_Color", command.billboard->GetColor());
-            if (material == nullptr)
-            {
-                // There should be access to the default material here
-                continue;
-            }
+        auto& queue = s_Data.billboardQueue;
 
-            material->Use();
-            const Ref<Shader>& shader = material->GetShader();
-            shader->Bind();
+        // Commands without a billboard or material cannot be drawn, drop them before batching
+        queue.erase(std::remove_if(queue.begin(), queue.end(),
+                                   [](const BillboardRenderCommand& command) { return !command.billboard || !command.material; }),
+                    queue.end());
 
-            glm::mat4 transform = command.billboard->CalculateTransform(s_Data.CameraPosition, s_Data.CameraUp);
+        // Blending needs the whole queue back to front, a batch only lasts while the material and entity repeat
+        std::sort(queue.begin(), queue.end(), [](const BillboardRenderCommand& a, const BillboardRenderCommand& b) {
+            glm::vec3 offsetA = a.billboard->GetPosition() - s_Data.CameraPosition;
+            glm::vec3 offsetB = b.billboard->GetPosition() - s_Data.CameraPosition;
+            return glm::dot(offsetA, offsetA) > glm::dot(offsetB, offsetB);
+        });
+
+        EnsureCapacity(static_cast<uint32_t>(queue.size()));
 
-            shader->setMat4("model", transform);
-            shader->setMat3("normalMatrix", glm::transpose(glm::inverse(glm::mat3(transform))));
+        for (size_t i = 0; i < queue.size(); ++i)
+        {
+            const BillboardRenderCommand& command = queue[i];
 
-            // Conversin de entityID
-            uint32_t r = (command.entityID & 0x000000FF) >> 0;
-            uint32_t g = (command.entityID & 0x0000FF00) >> 8;
-            uint32_t b = (command.entityID & 0x00FF0000) >> 16;
-            glm::vec3 entityIDVec3 = glm::vec3(r / 255.0f, g / 255.0f, b / 255.0f);
-            shader->setVec3("entityID", entityIDVec3);
+            glm::mat4 transform = command.billboard->CalculateTransform(s_Data.CameraPosition, s_Data.CameraUp);
+            AppendQuad(s_Data.Vertices, transform, command.billboard->GetColor(), command.entityID);
 
-            s_Data.QuadVertexArray->Bind();
-            glDrawElements(GL_TRIANGLES, s_Data.QuadVertexArray->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
-            s_Data.QuadVertexArray->Unbind();
+            // Draw when the next billboard breaks the batch or the buffer is at its maximum size
+            bool lastOfBatch = i + 1 == queue.size() || queue[i + 1].material != command.material ||
+                               queue[i + 1].entityID != command.entityID;
+            if (lastOfBatch || s_Data.Vertices.size() / 4 == s_Data.QuadCapacity)
+            {
+                FlushBatch(*command.material, command.entityID);
+            }
         }
 
-        s_Data.billboardQueue.clear();
+        queue.clear();
     }
 
-    void BillboardRenderer::DrawBillboard(const Ref<Billboard>& billboard, const Ref<Texture2D>& texture, const glm::vec4& color)
+    void BillboardRenderer::FlushBatch(const Ref<Texture2D>& texture)
     {
+        if (s_Data.Vertices.empty())
+            return;
+
         ZoneScoped;
 
         s_Data.BillboardShader->Bind();
         s_Data.BillboardShader->setMat4("u_ViewProjection", s_Data.ViewProjection);
-        s_Data.BillboardShader->setMat4("u_Transform",
-                                        billboard->CalculateTransform(s_Data.CameraPosition, s_Data.CameraUp));
-        s_Data.BillboardShader->setVec4("u_Color", color);
-
-        texture->Bind(0);
         s_Data.BillboardShader->setInt("u_Texture", 0);
+        texture->Bind(0);
+
+        DrawVertices();
+    }
+
+    void BillboardRenderer::FlushBatch(Material& material, uint32_t entityID)
+    {
+        if (s_Data.Vertices.empty())
+            return;
+
+        ZoneScoped;
+
+        // The quads are already in world space
+        material.Use();
+        Ref<Shader> shader = material.GetShader();
+        shader->setMat4("model", glm::mat4(1.0f));
+        shader->setMat3("normalMatrix", glm::mat3(1.0f));
+        shader->setVec3("entityID", EntityIDToColor(entityID));
+
+        DrawVertices();
+    }
+
+    void BillboardRenderer::DrawVertices()
+    {
+        s_Data.QuadVertexBuffer->SetData(s_Data.Vertices.data(), static_cast<uint32_t>(s_Data.Vertices.size() * sizeof(BillboardVertex)));
+
+        RendererAPI::DrawIndexed(s_Data.QuadVertexArray, static_cast<uint32_t>(s_Data.Vertices.size() / 4 * 6));
+
+        s_Data.Vertices.clear();
+    }
+
+    void BillboardRenderer::DrawBillboard(const Ref<Billboard>& billboard, const Ref<Texture2D>& texture, const glm::vec4& color)
+    {
+        ZoneScoped;
+
+        glm::mat4 transform = billboard->CalculateTransform(s_Data.CameraPosition, s_Data.CameraUp);
+        AppendQuad(s_Data.Vertices, transform, color, 4294967295);
 
-        billboard->GetMaterial()->Use();
-        s_Data.QuadVertexArray->Bind();
-        glDrawElements(GL_TRIANGLES, s_Data.QuadVertexArray->GetIndexBuffer()->GetCount(), GL_UNSIGNED_INT, nullptr);
+        FlushBatch(texture ? texture : s_Data.WhiteTexture);
     }
 
     void BillboardRenderer::Submit(const BillboardRenderCommand& command)
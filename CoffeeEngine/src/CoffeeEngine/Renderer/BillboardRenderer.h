@@ -2,11 +2,13 @@
 
 #include "CoffeeEngine/Core/Base.h"
 #include "CoffeeEngine/Core/Billboard.h"
+#include "CoffeeEngine/Renderer/Buffer.h"
 #include "CoffeeEngine/Renderer/Shader.h"
 #include "CoffeeEngine/Renderer/Texture.h"
 #include "CoffeeEngine/Renderer/VertexArray.h"
 #include "CoffeeEngine/Renderer/Material.h"
 #include <glm/fwd.hpp>
+#include <vector>
 
 namespace Coffee
 {
@@ -16,14 +18,35 @@ namespace Coffee
         Ref<Material> material;
         uint32_t entityID;
     };
-    static void DrawBillboard(
-    const Ref<Billboard>& billboard, 
-    const Ref<Texture2D>& texture, 
-    const glm::vec4& color = glm::vec4(1.0f)
-);
+
+    /**
+     * @brief Vertex of an expanded billboard quad, already in world space.
+     */
+    struct BillboardVertex
+    {
+        glm::vec3 Position; ///< The world position of the corner.
+        glm::vec2 TexCoord; ///< The texture coordinates of the corner.
+        glm::vec3 Normal; ///< The facing direction of the quad.
+        glm::vec3 Tangent; ///< The right direction of the quad.
+        glm::vec3 Bitangent; ///< The up direction of the quad.
+        glm::vec4 Color; ///< The billboard tint.
+        glm::vec3 EntityID; ///< The entity ID encoded as a color.
+    };
+
+    /**
+     * @brief Renders billboards in batches.
+     *
+     * Submitted billboards are sorted back to front across all materials and expanded on the CPU into a
+     * single dynamic vertex stream. Consecutive billboards sharing a material and an entity are drawn at once
+     * with the material shader, the first five attributes follow the mesh vertex layout. The GPU buffers grow
+     * in chunks of QuadChunkSize quads up to MaxQuads, past that a batch is flushed and a new one started.
+     */
     class BillboardRenderer
     {
       public:
+        static constexpr uint32_t QuadChunkSize = 1024; ///< Growth step of the quad capacity.
+        static constexpr uint32_t MaxQuads = 16384; ///< Maximum number of quads drawn at once.
+
         static void Init();
         static void Shutdown();
 
@@ -32,14 +55,24 @@ namespace Coffee
 
         static void DrawBillboard(const Ref<Billboard>& billboard, const Ref<Texture2D>& texture, const glm::vec4& color = glm::vec4(1.0f));
 
+      private:
+        static void EnsureCapacity(uint32_t quadCount);
+        static void FlushBatch(const Ref<Texture2D>& texture);
+        static void FlushBatch(Material& material, uint32_t entityID);
+        static void DrawVertices();
+
       private:
         struct BillboardRendererData
         {
             Ref<VertexArray> QuadVertexArray;
             Ref<VertexBuffer> QuadVertexBuffer;
             Ref<Shader> BillboardShader;
+            Ref<Texture2D> WhiteTexture;
             std::vector<BillboardRenderCommand> billboardQueue;
 
+            uint32_t QuadCapacity = 0; ///< Number of quads the GPU buffers can hold.
+            std::vector<BillboardVertex> Vertices; ///< CPU staging of the current batch.
+
             glm::mat4 ViewProjection = glm::mat4(1.0f);
             glm::vec3 CameraPosition = {0.0f, 0.0f, 0.0f};
             glm::vec3 CameraUp = {0.0f, 1.0f, 0.0f};
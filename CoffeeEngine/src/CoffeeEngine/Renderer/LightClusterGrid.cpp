@@ -0,0 +1,169 @@
+#include "LightClusterGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    LightClusterGrid::LightClusterGrid()
+    {
+        m_ClusterBounds.resize(ClusterCount);
+        m_ClusterRanges.resize(ClusterCount);
+    }
+
+    uint32_t LightClusterGrid::GetDepthSlice(float viewDepth) const
+    {
+        if (viewDepth <= m_NearClip)
+            return 0;
+
+        float slice = std::floor(std::log(viewDepth) * m_SliceScale - m_SliceBias);
+        return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(GridSizeZ - 1)));
+    }
+
+    uint32_t LightClusterGrid::GetClusterIndex(const glm::vec2& uv, float viewDepth) const
+    {
+        uint32_t x = static_cast<uint32_t>(std::clamp(uv.x * GridSizeX, 0.0f, static_cast<float>(GridSizeX - 1)));
+        uint32_t y = static_cast<uint32_t>(std::clamp(uv.y * GridSizeY, 0.0f, static_cast<float>(GridSizeY - 1)));
+        uint32_t z = GetDepthSlice(viewDepth);
+
+        return x + y * GridSizeX + z * GridSizeX * GridSizeY;
+    }
+
+    void LightClusterGrid::UpdateClusterBounds(const glm::mat4& projection, float nearClip, float farClip)
+    {
+        ZoneScoped;
+
+        m_Projection = projection;
+        m_NearClip = nearClip;
+        m_FarClip = farClip;
+
+        float logRatio = std::log(farClip / nearClip);
+        m_SliceScale = GridSizeZ / logRatio;
+        m_SliceBias = GridSizeZ * std::log(nearClip) / logRatio;
+
+        glm::mat4 inverseProjection = glm::inverse(projection);
+
+        auto unproject = [&](float x, float y, float z) {
+            glm::vec4 point = inverseProjection * glm::vec4(x, y, z, 1.0f);
+            return glm::vec3(point) / point.w;
+        };
+
+        for (uint32_t z = 0; z < GridSizeZ; ++z)
+        {
+            // Exponential slices keep the clusters roughly cubic along the whole depth range
+            float sliceNear = nearClip * std::pow(farClip / nearClip, static_cast<float>(z) / GridSizeZ);
+            float sliceFar = nearClip * std::pow(farClip / nearClip, static_cast<float>(z + 1) / GridSizeZ);
+
+            for (uint32_t y = 0; y < GridSizeY; ++y)
+            {
+                for (uint32_t x = 0; x < GridSizeX; ++x)
+                {
+                    glm::vec3 minPoint(std::numeric_limits<float>::max());
+                    glm::vec3 maxPoint(std::numeric_limits<float>::lowest());
+
+                    for (uint32_t corner = 0; corner < 4; ++corner)
+                    {
+                        float ndcX = -1.0f + 2.0f * static_cast<float>(x + (corner & 1)) / GridSizeX;
+                        float ndcY = -1.0f + 2.0f * static_cast<float>(y + (corner >> 1)) / GridSizeY;
+
+                        // Walk the ray through the tile corner to the depth of both slice planes
+                        glm::vec3 nearPoint = unproject(ndcX, ndcY, -1.0f);
+                        glm::vec3 farPoint = unproject(ndcX, ndcY, 1.0f);
+                        float depthRange = nearPoint.z - farPoint.z;
+
+                        for (float depth : {sliceNear, sliceFar})
+                        {
+                            float t = (depth + nearPoint.z) / depthRange;
+                            glm::vec3 point = nearPoint + (farPoint - nearPoint) * t;
+
+                            minPoint = glm::min(minPoint, point);
+                            maxPoint = glm::max(maxPoint, point);
+                        }
+                    }
+
+                    m_ClusterBounds[x + y * GridSizeX + z * GridSizeX * GridSizeY] = AABB(minPoint, maxPoint);
+                }
+            }
+        }
+    }
+
+    void LightClusterGrid::Build(const glm::mat4& projection, const glm::mat4& view, float nearClip, float farClip,
+                                 std::vector<LightComponent>& lights)
+    {
+        ZoneScoped;
+
+        if (projection != m_Projection || nearClip != m_NearClip || farClip != m_FarClip)
+        {
+            UpdateClusterBounds(projection, nearClip, farClip);
+        }
+
+        auto firstLocal = std::stable_partition(lights.begin(), lights.end(), [](const LightComponent& light) {
+            return light.type == LightComponent::Type::DirectionalLight;
+        });
+        m_DirectionalLightCount = static_cast<uint32_t>(firstLocal - lights.begin());
+
+        m_ClusterLightPairs.clear();
+
+        for (uint32_t lightIndex = m_DirectionalLightCount; lightIndex < lights.size(); ++lightIndex)
+        {
+            const LightComponent& light = lights[lightIndex];
+
+            glm::vec3 center = glm::vec3(view * glm::vec4(light.Position, 1.0f));
+            float radius = light.Range;
+            float depth = -center.z;
+
+            if (depth + radius < nearClip || depth - radius > farClip)
+                continue;
+
+            uint32_t firstSlice = GetDepthSlice(std::max(depth - radius, nearClip));
+            uint32_t lastSlice = GetDepthSlice(std::min(depth + radius, farClip));
+
+            for (uint32_t z = firstSlice; z <= lastSlice; ++z)
+            {
+                for (uint32_t cluster = z * GridSizeX * GridSizeY; cluster < (z + 1) * GridSizeX * GridSizeY; ++cluster)
+                {
+                    const AABB& bounds = m_ClusterBounds[cluster];
+
+                    glm::vec3 closest = glm::clamp(center, bounds.min, bounds.max);
+                    glm::vec3 delta = closest - center;
+
+                    if (glm::dot(delta, delta) <= radius * radius)
+                    {
+                        m_ClusterLightPairs.push_back(cluster);
+                        m_ClusterLightPairs.push_back(lightIndex);
+                    }
+                }
+            }
+        }
+
+        // Counting sort of the pairs by cluster, the lights stay in ascending order inside each cluster
+        for (auto& range : m_ClusterRanges)
+        {
+            range.Count = 0;
+        }
+
+        for (size_t i = 0; i < m_ClusterLightPairs.size(); i += 2)
+        {
+            m_ClusterRanges[m_ClusterLightPairs[i]].Count++;
+        }
+
+        uint32_t offset = 0;
+        for (auto& range : m_ClusterRanges)
+        {
+            range.Offset = offset;
+            offset += range.Count;
+            range.Count = 0;
+        }
+
+        m_LightIndices.resize(offset);
+
+        for (size_t i = 0; i < m_ClusterLightPairs.size(); i += 2)
+        {
+            LightClusterRange& range = m_ClusterRanges[m_ClusterLightPairs[i]];
+            m_LightIndices[range.Offset + range.Count++] = m_ClusterLightPairs[i + 1];
+        }
+    }
+
+}
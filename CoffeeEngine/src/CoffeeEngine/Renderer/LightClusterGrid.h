@@ -0,0 +1,112 @@
+#pragma once
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Scene/Components.h"
+
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @{
+     */
+
+    /**
+     * @brief Range of the light index list affecting one cluster.
+     */
+    struct LightClusterRange
+    {
+        uint32_t Offset = 0; ///< The first entry in the light index list.
+        uint32_t Count = 0; ///< The number of entries.
+    };
+
+    /**
+     * @brief CPU side clustered (froxel) light assignment.
+     *
+     * The view frustum is split in GridSizeX x GridSizeY screen tiles and GridSizeZ depth slices distributed
+     * exponentially between the near and far planes. Every point and spot light is tested, as a sphere of its
+     * range, against the view space bounds of the clusters it may touch. The result is a compact list of light
+     * indices plus one LightClusterRange per cluster pointing into it, ready to be uploaded to the GPU.
+     *
+     * Directional lights affect every cluster and are not assigned; Build() reorders the lights so they come
+     * first and reports how many there are.
+     *
+     * The class does not touch the graphics API so the assignment can be exercised on the CPU alone.
+     */
+    class LightClusterGrid
+    {
+    public:
+        static constexpr uint32_t GridSizeX = 16; ///< Number of tiles along the screen width.
+        static constexpr uint32_t GridSizeY = 9; ///< Number of tiles along the screen height.
+        static constexpr uint32_t GridSizeZ = 24; ///< Number of depth slices.
+        static constexpr uint32_t ClusterCount = GridSizeX * GridSizeY * GridSizeZ; ///< Total number of clusters.
+
+        LightClusterGrid();
+
+        /**
+         * @brief Assigns the lights to the clusters of the given camera.
+         *
+         * @param projection The camera projection matrix.
+         * @param view The camera view matrix.
+         * @param nearClip The near clip distance used for the depth slices.
+         * @param farClip The far clip distance used for the depth slices.
+         * @param lights The lights, in world space. Reordered so the directional lights come first.
+         */
+        void Build(const glm::mat4& projection, const glm::mat4& view, float nearClip, float farClip,
+                   std::vector<LightComponent>& lights);
+
+        /**
+         * @brief Gets the cluster index of a view space position and screen uv.
+         * @param uv The normalized screen position, (0, 0) being the bottom left corner.
+         * @param viewDepth The positive distance along the view direction.
+         * @return The cluster index.
+         */
+        uint32_t GetClusterIndex(const glm::vec2& uv, float viewDepth) const;
+
+        /**
+         * @brief Gets the depth slice of a view space depth.
+         * @param viewDepth The positive distance along the view direction.
+         * @return The slice in the range [0, GridSizeZ).
+         */
+        uint32_t GetDepthSlice(float viewDepth) const;
+
+        const std::vector<LightClusterRange>& GetClusterRanges() const { return m_ClusterRanges; }
+        const std::vector<uint32_t>& GetLightIndices() const { return m_LightIndices; }
+        const AABB& GetClusterBounds(uint32_t cluster) const { return m_ClusterBounds[cluster]; }
+
+        uint32_t GetDirectionalLightCount() const { return m_DirectionalLightCount; }
+        float GetNearClip() const { return m_NearClip; }
+        float GetFarClip() const { return m_FarClip; }
+
+        /**
+         * @brief Gets the scale applied to log(depth) to obtain the depth slice.
+         */
+        float GetSliceScale() const { return m_SliceScale; }
+
+        /**
+         * @brief Gets the bias subtracted from the scaled log(depth) to obtain the depth slice.
+         */
+        float GetSliceBias() const { return m_SliceBias; }
+
+    private:
+        void UpdateClusterBounds(const glm::mat4& projection, float nearClip, float farClip);
+
+    private:
+        std::vector<AABB> m_ClusterBounds; ///< View space bounds of each cluster.
+        std::vector<LightClusterRange> m_ClusterRanges;
+        std::vector<uint32_t> m_LightIndices;
+        std::vector<uint32_t> m_ClusterLightPairs; ///< Scratch (cluster, light) pairs, two entries per pair.
+
+        glm::mat4 m_Projection = glm::mat4(0.0f); ///< Projection the cluster bounds were built for.
+        float m_NearClip = 0.0f;
+        float m_FarClip = 0.0f;
+        float m_SliceScale = 0.0f;
+        float m_SliceBias = 0.0f;
+        uint32_t m_DirectionalLightCount = 0;
+    };
+
+    /** @} */
+}
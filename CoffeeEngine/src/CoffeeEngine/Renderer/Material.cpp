@@ -4,9 +4,11 @@
 #include "CoffeeEngine/IO/ResourceLoader.h"
 #include "CoffeeEngine/IO/ResourceRegistry.h"
 #include "CoffeeEngine/Renderer/Texture.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
 #include "CoffeeEngine/Embedded/StandardShader.inl"
 #include <cstdint>
 #include <glm/fwd.hpp>
+#include <mutex>
 #include <tracy/Tracy.hpp>
 
 namespace Coffee {
@@ -14,11 +16,12 @@ namespace Coffee {
     Ref<Texture2D> Material::s_MissingTexture;
     Ref<Shader> Material::s_StandardShader;
 
-     Material::Material() : Resource(ResourceType::Material)
+    Material::Material() : Resource(ResourceType::Material)
     {
-        s_StandardShader  = s_StandardShader ? s_StandardShader : CreateRef<Shader>("StandardShader", std::string(standardShaderSource));
-
-        m_Shader = s_StandardShader;
+        if (UploadQueue::CanUploadNow())
+        {
+            Upload();
+        }
     }
 
     Material::Material(const std::string& name)
@@ -28,18 +31,17 @@ namespace Coffee {
 
         m_Name = name;
 
-        s_MissingTexture = Texture2D::Load("assets/textures/UVMap-Grid.jpg");
-        s_StandardShader  = s_StandardShader ? s_StandardShader : CreateRef<Shader>("StandardShader", std::string(standardShaderSource));
+        // Materials are also constructed on job threads while loading
+        static std::once_flag missingTextureFlag;
+        std::call_once(missingTextureFlag, []() { s_MissingTexture = Texture2D::Load("assets/textures/UVMap-Grid.jpg"); });
 
         m_MaterialTextures.albedo = s_MissingTexture;
         m_MaterialTextureFlags.hasAlbedo = true;
 
-        m_Shader = s_StandardShader;
-
-        m_Shader->Bind();
-        m_MaterialTextures.albedo->Bind(0);
-        m_Shader->setInt("material.albedoMap", 0);
-        m_Shader->Unbind();
+        if (UploadQueue::CanUploadNow())
+        {
+            Upload();
+        }
     }
 
     Material::Material(const std::string& name, Ref<Shader> shader) : m_Shader(shader), Resource(ResourceType::Material) {}
@@ -49,8 +51,6 @@ namespace Coffee {
     {
         ZoneScoped;
 
-        s_StandardShader  = s_StandardShader ? s_StandardShader : CreateRef<Shader>("StandardShader", std::string(standardShaderSource));
-        
         m_Name = name;
 
         m_MaterialTextures.albedo = materialTextures.albedo;
@@ -70,6 +70,30 @@ namespace Coffee {
         if(m_MaterialTextureFlags.hasMetallic)m_MaterialProperties.metallic = 1.0f;
         if(m_MaterialTextureFlags.hasEmissive)m_MaterialProperties.emissive = glm::vec3(1.0f);
 
+        if (UploadQueue::CanUploadNow())
+        {
+            Upload();
+        }
+    }
+
+    void Material::Upload()
+    {
+        ZoneScoped;
+
+        for (Texture2D* texture : {m_MaterialTextures.albedo.get(), m_MaterialTextures.normal.get(),
+                                   m_MaterialTextures.metallic.get(), m_MaterialTextures.roughness.get(),
+                                   m_MaterialTextures.ao.get(), m_MaterialTextures.emissive.get()})
+        {
+            if (texture)
+                texture->Upload();
+        }
+
+        // Materials with their own shader set it up themselves
+        if (m_Shader)
+            return;
+
+        s_StandardShader  = s_StandardShader ? s_StandardShader : CreateRef<Shader>("StandardShader", std::string(standardShaderSource));
+
         m_Shader = s_StandardShader;
 
         m_Shader->Bind();
@@ -162,6 +162,12 @@ namespace Coffee {
          */
         void Use();
 
+        /**
+         * @brief Sets up the standard shader if the material was created outside of the main thread, and
+         * uploads its textures.
+         */
+        void Upload() override;
+
         /**
          * @brief Gets the shader associated with the material.
          * @return A reference to the shader.
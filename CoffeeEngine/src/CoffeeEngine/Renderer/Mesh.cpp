@@ -1,34 +1,167 @@
 #include "CoffeeEngine/Renderer/Mesh.h"
 #include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/IO/CacheManager.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
 #include "CoffeeEngine/Renderer/VertexArray.h"
+#include <filesystem>
 #include <tracy/Tracy.hpp>
 
 namespace Coffee {
 
     Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
-        : Resource(ResourceType::Mesh)
+        : Mesh(CacheBuffer<Vertex>(vertices), CacheBuffer<uint32_t>(indices))
+    {
+    }
+
+    Mesh::Mesh(CacheBuffer<Vertex> vertices, CacheBuffer<uint32_t> indices)
+        : Resource(ResourceType::Mesh), m_Indices(std::move(indices)), m_Vertices(std::move(vertices))
+    {
+        ZoneScoped;
+
+        m_IndexCount = static_cast<uint32_t>(m_Indices.size());
+        m_VertexCount = static_cast<uint32_t>(m_Vertices.size());
+        SetCPUMemoryUsage(m_VertexCount * sizeof(Vertex) + m_IndexCount * sizeof(uint32_t));
+
+        // Meshes decoded on job threads are uploaded later by the upload queue
+        if (UploadQueue::CanUploadNow())
+        {
+            Upload();
+        }
+    }
+
+    void Mesh::Upload()
+    {
+        ZoneScoped;
+
+        if (!m_VertexArray && m_Residency != ResourceResidency::CPUOnly && RestoreCPUData())
+        {
+            // The buffers are only read, they may point into a read-only mapping
+            m_VertexBuffer = VertexBuffer::Create((float*)m_Vertices.data(), m_Vertices.size() * sizeof(Vertex));
+            m_IndexBuffer = IndexBuffer::Create(const_cast<uint32_t*>(m_Indices.data()), m_Indices.size());
+
+            BufferLayout layout = {
+                {ShaderDataType::Vec3, "a_Position"},
+                {ShaderDataType::Vec2, "a_TexCoords"},
+                {ShaderDataType::Vec3, "a_Normals"},
+                {ShaderDataType::Vec3, "a_Tangent"},
+                {ShaderDataType::Vec3, "a_Bitangent"}
+            };
+
+            m_VertexBuffer->SetLayout(layout);
+
+            m_VertexArray = VertexArray::Create();
+            m_VertexArray->AddVertexBuffer(m_VertexBuffer);
+            m_VertexArray->SetIndexBuffer(m_IndexBuffer);
+
+            SetGPUMemoryUsage(m_VertexCount * sizeof(Vertex) + m_IndexCount * sizeof(uint32_t));
+        }
+
+        if (m_Material)
+        {
+            m_Material->Upload();
+        }
+    }
+
+    void Mesh::ApplyResidency()
     {
         ZoneScoped;
 
-        m_Vertices = vertices;
-        m_Indices = indices;
+        switch (m_Residency)
+        {
+        case ResourceResidency::CPUAndGPU:
+            RestoreCPUData();
+            Upload();
+            break;
+        case ResourceResidency::GPUOnly:
+            Upload();
 
-        m_VertexBuffer = VertexBuffer::Create((float*)m_Vertices.data(), m_Vertices.size() * sizeof(Vertex));
-        m_IndexBuffer = IndexBuffer::Create(m_Indices.data(), m_Indices.size());
+            // Only released when the cache can give the data back
+            if (m_VertexArray && !m_CPUDataReleased && std::filesystem::exists(CacheManager::GetCachedFilePath(m_UUID)))
+            {
+                std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+                m_Vertices.clear();
+                m_Indices.clear();
+                m_CPUDataReleased.store(true, std::memory_order_release);
+                SetCPUMemoryUsage(0);
+            }
+            break;
+        case ResourceResidency::CPUOnly:
+            if (RestoreCPUData())
+            {
+                m_VertexArray.reset();
+                m_VertexBuffer.reset();
+                m_IndexBuffer.reset();
+                SetGPUMemoryUsage(0);
+            }
+            break;
+        }
+    }
 
-        BufferLayout layout = {
-            {ShaderDataType::Vec3, "a_Position"},
-            {ShaderDataType::Vec2, "a_TexCoords"},
-            {ShaderDataType::Vec3, "a_Normals"},
-            {ShaderDataType::Vec3, "a_Tangent"},
-            {ShaderDataType::Vec3, "a_Bitangent"}
-        };
+    bool Mesh::RestoreCPUData() const
+    {
+        if (!m_CPUDataReleased.load(std::memory_order_acquire))
+            return true;
+
+        std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+        if (!m_CPUDataReleased.load(std::memory_order_relaxed))
+            return true;
+
+        Ref<const Mesh> cached = ReadBackCPUData();
+        if (!cached)
+            return false;
+
+        // Shared with the cached instance, both point into the mapped cache file
+        m_Vertices = cached->m_Vertices;
+        m_Indices = cached->m_Indices;
+        SetCPUMemoryUsage(m_Vertices.size() * sizeof(Vertex) + m_Indices.size() * sizeof(uint32_t));
+        m_CPUDataReleased.store(false, std::memory_order_release);
+        return true;
+    }
+
+    Ref<const Mesh> Mesh::ReadBackCPUData() const
+    {
+        if (Ref<const Mesh> readBack = m_ReadBack.lock())
+            return readBack;
+
+        ZoneScoped;
+
+        Ref<const Mesh> cached = std::dynamic_pointer_cast<const Mesh>(ResourceLoader::LoadCPUData(m_UUID));
+        if (!cached)
+        {
+            COFFEE_CORE_ERROR("Mesh::ReadBackCPUData: Could not read the data of {0} back from the cache", m_Name);
+            return nullptr;
+        }
+
+        m_ReadBack = cached;
+        return cached;
+    }
+
+    CacheBuffer<Vertex> Mesh::GetVertices() const
+    {
+        std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+        if (!m_CPUDataReleased.load(std::memory_order_relaxed))
+            return m_Vertices;
+
+        // The buffer keeps the copy read back alive, the mesh stays released
+        Ref<const Mesh> readBack = ReadBackCPUData();
+        if (!readBack)
+            return {};
+
+        return CacheBuffer<Vertex>(readBack, readBack->m_Vertices.data(), readBack->m_Vertices.size());
+    }
+
+    CacheBuffer<uint32_t> Mesh::GetIndices() const
+    {
+        std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+        if (!m_CPUDataReleased.load(std::memory_order_relaxed))
+            return m_Indices;
 
-        m_VertexBuffer->SetLayout(layout);
+        Ref<const Mesh> readBack = ReadBackCPUData();
+        if (!readBack)
+            return {};
 
-        m_VertexArray = VertexArray::Create();
-        m_VertexArray->AddVertexBuffer(m_VertexBuffer);
-        m_VertexArray->SetIndexBuffer(m_IndexBuffer);
+        return CacheBuffer<uint32_t>(readBack, readBack->m_Indices.data(), readBack->m_Indices.size());
     }
 
 }
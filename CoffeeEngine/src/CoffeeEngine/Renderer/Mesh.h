@@ -1,6 +1,7 @@
 #pragma once
 
 #include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/IO/CacheBuffer.h"
 #include "CoffeeEngine/IO/Resource.h"
 #include "CoffeeEngine/IO/ResourceLoader.h"
 #include "CoffeeEngine/Renderer/Buffer.h"
@@ -12,9 +13,12 @@
 #include <cstdint>
 #include <glm/fwd.hpp>
 #include <glm/glm.hpp>
+#include <span>
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
+#include <mutex>
 #include <cereal/access.hpp>
 #include <cereal/types/vector.hpp>
 #include <cereal/types/polymorphic.hpp>
@@ -60,6 +64,13 @@ namespace Coffee {
          */
         Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
 
+        /**
+         * @brief Constructs a Mesh sharing the specified vertex and index buffers, without copying them.
+         * @param vertices The vertices of the mesh.
+         * @param indices The indices of the mesh.
+         */
+        Mesh(CacheBuffer<Vertex> vertices, CacheBuffer<uint32_t> indices);
+
         /**
          * @brief Gets the vertex array of the mesh.
          * @return A reference to the vertex array.
@@ -110,16 +121,43 @@ namespace Coffee {
         const Ref<Material>& GetMaterial() const { return m_Material; }
 
         /**
-         * @brief Gets the vertices of the mesh.
-         * @return A reference to the vector of vertices.
+         * @brief Gets the vertices of the mesh, read back from the cache if they were released.
+         *
+         * The mesh does not keep the vertices read back, they are released with the last buffer referring to them.
+         * @return A buffer keeping the vertices alive, even if the mesh releases its own meanwhile.
+         */
+        CacheBuffer<Vertex> GetVertices() const;
+
+        /**
+         * @brief Gets the indices of the mesh, read back from the cache if they were released.
+         *
+         * The mesh does not keep the indices read back, they are released with the last buffer referring to them.
+         * @return A buffer keeping the indices alive, even if the mesh releases its own meanwhile.
+         */
+        CacheBuffer<uint32_t> GetIndices() const;
+
+        /**
+         * @brief Gets the number of vertices, without reloading them.
+         * @return The vertex count.
+         */
+        uint32_t GetVertexCount() const { return m_VertexCount; }
+
+        /**
+         * @brief Gets the number of indices, without reloading them.
+         * @return The index count.
+         */
+        uint32_t GetIndexCount() const { return m_IndexCount; }
+
+        /**
+         * @brief Creates the vertex array and buffers if the mesh was created outside of the main thread, and
+         * uploads its material.
          */
-        const std::vector<Vertex>& GetVertices() const { return m_Vertices; }
+        void Upload() override;
 
         /**
-         * @brief Gets the indices of the mesh.
-         * @return A reference to the vector of indices.
+         * @brief Releases the vertices and indices once uploaded, or the buffers of a CPU only mesh.
          */
-        const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+        void ApplyResidency() override;
 
     private:
         friend class cereal::access;
@@ -127,6 +165,7 @@ namespace Coffee {
         template<class Archive>
         void save(Archive& archive) const
         {
+            RestoreCPUData();
             UUID materialUUID = m_Material->GetUUID();
             archive(m_Vertices, m_Indices, m_AABB, materialUUID, cereal::base_class<Resource>(this));
         }
@@ -143,19 +182,30 @@ namespace Coffee {
         template<class Archive>
         static void load_and_construct(Archive& data, cereal::construct<Mesh>& construct)
         {
-            // Try to take this data as a reference
-            std::vector<Vertex> vertices;
-            std::vector<uint32_t> indices;
+            // From a mapped cache file the buffers point into the mapping, nothing is copied
+            CacheBuffer<Vertex> vertices;
+            CacheBuffer<uint32_t> indices;
             data(vertices, indices);
-            construct(vertices, indices);
+            construct(std::move(vertices), std::move(indices));
 
             UUID materialUUID;
 
             data(construct->m_AABB, materialUUID, cereal::base_class<Resource>(construct.ptr()));
-            construct->m_Vertices = vertices;
-            construct->m_Indices = indices;
             construct->m_Material = ResourceLoader::LoadMaterial(materialUUID);
         }
+
+        /**
+         * @brief Reads back the vertices and indices from the cache if they were released.
+         * @return True if the mesh has its CPU data.
+         */
+        bool RestoreCPUData() const;
+
+        /**
+         * @brief Reads the released vertices and indices from the cache, reusing a previous read while a buffer
+         * still refers to it. Called with the CPU data mutex locked.
+         * @return A CPU only copy of the mesh, nullptr if the cache cannot give the data back.
+         */
+        Ref<const Mesh> ReadBackCPUData() const;
       private:
         Ref<VertexArray> m_VertexArray; ///< The vertex array of the mesh.
         Ref<VertexBuffer> m_VertexBuffer; ///< The vertex buffer of the mesh.
@@ -164,8 +214,14 @@ namespace Coffee {
         Ref<Material> m_Material; ///< The material of the mesh.
         AABB m_AABB; ///< The axis-aligned bounding box of the mesh.
 
-        std::vector<uint32_t> m_Indices; ///< The indices of the mesh.
-        std::vector<Vertex> m_Vertices; ///< The vertices of the mesh.
+        mutable CacheBuffer<uint32_t> m_Indices; ///< The indices of the mesh.
+        mutable CacheBuffer<Vertex> m_Vertices; ///< The vertices of the mesh.
+        uint32_t m_IndexCount = 0; ///< The number of indices, kept when they are released.
+        uint32_t m_VertexCount = 0; ///< The number of vertices, kept when they are released.
+
+        mutable std::atomic<bool> m_CPUDataReleased = false; ///< Whether the vertices and indices were released.
+        mutable std::mutex m_CPUDataMutex; ///< Guards releasing and reloading the vertices and indices.
+        mutable std::weak_ptr<const Mesh> m_ReadBack; ///< The last data read back, alive while a buffer refers to it.
     };
 
     /** @} */
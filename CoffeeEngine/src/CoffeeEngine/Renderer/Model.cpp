@@ -182,37 +182,45 @@ namespace Coffee {
         }
     }
 
-    Ref<Texture2D> Model::LoadTexture2D(aiMaterial* material, aiTextureType type)
+    ResourceHandle<Texture2D> Model::LoadTexture2D(aiMaterial* material, aiTextureType type)
     {
         aiString textureName;
         material->GetTexture(type, 0, &textureName);
 
         if(textureName.length == 0)
         {
-            return nullptr;
+            return ResourceHandle<Texture2D>();
         }
 
-        std::string directory = m_FilePath.parent_path().string();
-        std::string texturePath = directory + "/" + std::string(textureName.C_Str());
+        std::filesystem::path texturePath = std::filesystem::current_path() / m_FilePath.parent_path() / textureName.C_Str();
 
         bool srgb = (type == aiTextureType_DIFFUSE || type == aiTextureType_EMISSIVE);
 
-        return Texture2D::Load(texturePath, srgb);
+        return ResourceLoader::LoadTexture2DAsync(texturePath, srgb);
     }
 
     MaterialTextures Model::LoadMaterialTextures(aiMaterial* material)
     {
-        MaterialTextures matTextures;
+        ZoneScoped;
 
-        matTextures.albedo = LoadTexture2D(material, aiTextureType_DIFFUSE);
-        matTextures.normal = LoadTexture2D(material, aiTextureType_NORMALS);
-        matTextures.metallic = LoadTexture2D(material, aiTextureType_METALNESS);
-        matTextures.roughness = LoadTexture2D(material, aiTextureType_DIFFUSE_ROUGHNESS);
-        matTextures.ao = LoadTexture2D(material, aiTextureType_AMBIENT);
+        // Start every texture first so they decode in parallel, then wait for all of them
+        ResourceHandle<Texture2D> albedo = LoadTexture2D(material, aiTextureType_DIFFUSE);
+        ResourceHandle<Texture2D> normal = LoadTexture2D(material, aiTextureType_NORMALS);
+        ResourceHandle<Texture2D> metallic = LoadTexture2D(material, aiTextureType_METALNESS);
+        ResourceHandle<Texture2D> roughness = LoadTexture2D(material, aiTextureType_DIFFUSE_ROUGHNESS);
+        ResourceHandle<Texture2D> ao = LoadTexture2D(material, aiTextureType_AMBIENT);
+        ResourceHandle<Texture2D> emissive = LoadTexture2D(material, aiTextureType_EMISSIVE);
 
-        if(matTextures.ao == nullptr) matTextures.ao = LoadTexture2D(material, aiTextureType_LIGHTMAP);
+        MaterialTextures matTextures;
 
-        matTextures.emissive = LoadTexture2D(material, aiTextureType_EMISSIVE);
+        matTextures.albedo = albedo.Wait();
+        matTextures.normal = normal.Wait();
+        matTextures.metallic = metallic.Wait();
+        matTextures.roughness = roughness.Wait();
+        matTextures.ao = ao.Wait();
+        // The lightmap is only decoded when there is no ambient occlusion texture or it failed to load
+        if(!matTextures.ao) matTextures.ao = LoadTexture2D(material, aiTextureType_LIGHTMAP).Wait();
+        matTextures.emissive = emissive.Wait();
 
         return matTextures;
     }
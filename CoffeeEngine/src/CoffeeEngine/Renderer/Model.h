@@ -99,12 +99,12 @@ namespace Coffee {
         void processNode(aiNode* node, const aiScene* scene);
 
         /**
-         * @brief Loads a texture from the Assimp material and texture type.
+         * @brief Starts loading a texture from the Assimp material and texture type.
          * @param material The Assimp material.
          * @param type The Assimp texture type.
-         * @return A reference to the loaded texture.
+         * @return A handle to the loading texture, invalid if the material has no texture of that type.
          */
-        Ref<Texture2D> LoadTexture2D(aiMaterial* material, aiTextureType type);
+        ResourceHandle<Texture2D> LoadTexture2D(aiMaterial* material, aiTextureType type);
 
         /**
          * @brief Loads material textures from the Assimp material.
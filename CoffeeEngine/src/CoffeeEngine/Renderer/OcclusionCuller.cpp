@@ -0,0 +1,299 @@
+#include "OcclusionCuller.h"
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Renderer/DebugRenderer.h"
+#include "CoffeeEngine/Renderer/Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <tracy/Tracy.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define COFFEE_OCCLUSION_SSE 1
+    #include <emmintrin.h>
+#endif
+
+namespace Coffee {
+
+    // Vertices closer than this (in clip w) are treated as crossing the near plane
+    static constexpr float NearPlaneEpsilon = 1e-4f;
+
+    OcclusionCuller::OcclusionCuller()
+    {
+        m_Depth.resize(Width * Height, 0.0f);
+        m_BlockDepth.resize(BlocksX * BlocksY, 0.0f);
+    }
+
+    void OcclusionCuller::Begin(const glm::mat4& viewProjection)
+    {
+        m_ViewProjection = viewProjection;
+
+        m_Triangles.clear();
+        for (auto& bin : m_TileBins)
+        {
+            bin.clear();
+        }
+
+        m_CulledBounds.clear();
+        m_Stats = {};
+
+        m_PreviousOccluderVertices.swap(m_OccluderVertices);
+        m_PreviousOccluderIndices.swap(m_OccluderIndices);
+        m_OccluderVertices.clear();
+        m_OccluderIndices.clear();
+    }
+
+    void OcclusionCuller::AddOccluder(const Mesh& mesh, const glm::mat4& transform)
+    {
+        ZoneScoped;
+
+        const CacheBuffer<Vertex>& vertices = m_OccluderVertices.emplace_back(mesh.GetVertices());
+        const CacheBuffer<uint32_t>& indices = m_OccluderIndices.emplace_back(mesh.GetIndices());
+
+        if (vertices.empty() || indices.size() < 3)
+            return;
+
+        glm::mat4 modelViewProjection = m_ViewProjection * transform;
+
+        m_ClipVertices.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i)
+        {
+            m_ClipVertices[i] = modelViewProjection * glm::vec4(vertices[i].Position, 1.0f);
+        }
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            const glm::vec4* clip[3] = {&m_ClipVertices[indices[i]], &m_ClipVertices[indices[i + 1]], &m_ClipVertices[indices[i + 2]]};
+
+            // Occluders are not clipped, a triangle crossing the near plane is simply dropped
+            if (clip[0]->w < NearPlaneEpsilon || clip[1]->w < NearPlaneEpsilon || clip[2]->w < NearPlaneEpsilon)
+                continue;
+
+            ScreenTriangle triangle;
+            glm::vec2 minPoint(std::numeric_limits<float>::max());
+            glm::vec2 maxPoint(std::numeric_limits<float>::lowest());
+
+            for (int v = 0; v < 3; ++v)
+            {
+                float invW = 1.0f / clip[v]->w;
+                glm::vec3& screen = triangle.Vertices[v];
+                screen.x = (clip[v]->x * invW * 0.5f + 0.5f) * Width;
+                screen.y = (clip[v]->y * invW * 0.5f + 0.5f) * Height;
+                screen.z = invW;
+
+                minPoint = glm::min(minPoint, glm::vec2(screen));
+                maxPoint = glm::max(maxPoint, glm::vec2(screen));
+            }
+
+            if (maxPoint.x <= 0.0f || maxPoint.y <= 0.0f || minPoint.x >= Width || minPoint.y >= Height)
+                continue;
+
+            uint32_t triangleIndex = static_cast<uint32_t>(m_Triangles.size());
+            m_Triangles.push_back(triangle);
+
+            int tileMinX = std::max(static_cast<int>(minPoint.x) / static_cast<int>(TileSize), 0);
+            int tileMinY = std::max(static_cast<int>(minPoint.y) / static_cast<int>(TileSize), 0);
+            int tileMaxX = std::min(static_cast<int>(maxPoint.x) / static_cast<int>(TileSize), static_cast<int>(TilesX) - 1);
+            int tileMaxY = std::min(static_cast<int>(maxPoint.y) / static_cast<int>(TileSize), static_cast<int>(TilesY) - 1);
+
+            for (int tileY = tileMinY; tileY <= tileMaxY; ++tileY)
+            {
+                for (int tileX = tileMinX; tileX <= tileMaxX; ++tileX)
+                {
+                    m_TileBins[tileX + tileY * TilesX].push_back(triangleIndex);
+                }
+            }
+
+            m_Stats.OccluderTriangles++;
+        }
+
+        m_Stats.OccluderCount++;
+    }
+
+    void OcclusionCuller::Rasterize()
+    {
+        ZoneScoped;
+
+        // Every tile owns its pixels and blocks, so they can be rasterized independently
+        JobSystem::ParallelFor(TilesX * TilesY, 1, [this](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t tile = begin; tile < end; ++tile)
+            {
+                RasterizeTile(tile);
+            }
+        });
+    }
+
+    void OcclusionCuller::RasterizeTile(uint32_t tile)
+    {
+        const int tileX = static_cast<int>((tile % TilesX) * TileSize);
+        const int tileY = static_cast<int>((tile / TilesX) * TileSize);
+
+        for (uint32_t y = 0; y < TileSize; ++y)
+        {
+            std::fill_n(&m_Depth[(tileY + y) * Width + tileX], TileSize, 0.0f);
+        }
+
+        for (uint32_t triangleIndex : m_TileBins[tile])
+        {
+            glm::vec3 v0 = m_Triangles[triangleIndex].Vertices[0];
+            glm::vec3 v1 = m_Triangles[triangleIndex].Vertices[1];
+            glm::vec3 v2 = m_Triangles[triangleIndex].Vertices[2];
+
+            float area = (v1.x - v0.x) * (v2.y - v0.y) - (v1.y - v0.y) * (v2.x - v0.x);
+            if (std::abs(area) < 1e-6f)
+                continue;
+
+            // Occluders are two sided, make the winding counter clockwise
+            if (area < 0.0f)
+            {
+                std::swap(v1, v2);
+                area = -area;
+            }
+
+            // Edge functions E(x, y) = A * x + B * y + C, positive inside the triangle
+            const float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v2.x * v1.y;
+            const float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v0.x * v2.y;
+            const float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v1.x * v0.y;
+
+            // 1/w is linear in screen space, interpolate it as a plane
+            const float invArea = 1.0f / area;
+            const float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * invArea;
+            const float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * invArea;
+            const float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * invArea;
+
+            int minX = std::max(static_cast<int>(std::floor(std::min({v0.x, v1.x, v2.x}))), tileX);
+            int minY = std::max(static_cast<int>(std::floor(std::min({v0.y, v1.y, v2.y}))), tileY);
+            int maxX = std::min(static_cast<int>(std::ceil(std::max({v0.x, v1.x, v2.x}))), tileX + static_cast<int>(TileSize) - 1);
+            int maxY = std::min(static_cast<int>(std::ceil(std::max({v0.y, v1.y, v2.y}))), tileY + static_cast<int>(TileSize) - 1);
+
+            if (minX > maxX || minY > maxY)
+                continue;
+
+            // Process whole groups of four pixels, the tile origin is aligned to four
+            minX &= ~3;
+
+            for (int y = minY; y <= maxY; ++y)
+            {
+                const float py = y + 0.5f;
+                float* row = &m_Depth[y * Width];
+
+#ifdef COFFEE_OCCLUSION_SSE
+                const __m128 zero = _mm_setzero_ps();
+                const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+                for (int x = minX; x <= maxX; x += 4)
+                {
+                    __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), offsets);
+
+                    __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), _mm_set1_ps(b0 * py + c0));
+                    __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), _mm_set1_ps(b1 * py + c1));
+                    __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), _mm_set1_ps(b2 * py + c2));
+
+                    // Pixels on an edge are left out, so occluders never cover more than they should
+                    __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(e0, zero), _mm_cmpgt_ps(e1, zero)), _mm_cmpgt_ps(e2, zero));
+                    if (_mm_movemask_ps(inside) == 0)
+                        continue;
+
+                    __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), _mm_set1_ps(zb * py + zc));
+                    __m128 depth = _mm_loadu_ps(row + x);
+                    __m128 closest = _mm_max_ps(depth, z);
+                    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, closest), _mm_andnot_ps(inside, depth)));
+                }
+#else
+                for (int x = minX; x <= maxX; ++x)
+                {
+                    const float px = x + 0.5f;
+
+                    if (a0 * px + b0 * py + c0 <= 0.0f || a1 * px + b1 * py + c1 <= 0.0f || a2 * px + b2 * py + c2 <= 0.0f)
+                        continue;
+
+                    row[x] = std::max(row[x], za * px + zb * py + zc);
+                }
+#endif
+            }
+        }
+
+        // Keep the farthest depth of every block of the tile
+        for (uint32_t blockY = tileY / BlockSize; blockY < (tileY + TileSize) / BlockSize; ++blockY)
+        {
+            for (uint32_t blockX = tileX / BlockSize; blockX < (tileX + TileSize) / BlockSize; ++blockX)
+            {
+                float farthest = std::numeric_limits<float>::max();
+
+                for (uint32_t y = blockY * BlockSize; y < (blockY + 1) * BlockSize; ++y)
+                {
+                    const float* row = &m_Depth[y * Width + blockX * BlockSize];
+                    farthest = std::min(farthest, *std::min_element(row, row + BlockSize));
+                }
+
+                m_BlockDepth[blockX + blockY * BlocksX] = farthest;
+            }
+        }
+    }
+
+    bool OcclusionCuller::IsVisible(const AABB& aabb)
+    {
+        if (!m_Enabled)
+            return true;
+
+        m_Stats.TestedCount++;
+
+        glm::vec2 minPoint(std::numeric_limits<float>::max());
+        glm::vec2 maxPoint(std::numeric_limits<float>::lowest());
+        float closest = 0.0f;
+
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 position((corner & 1) ? aabb.max.x : aabb.min.x, (corner & 2) ? aabb.max.y : aabb.min.y,
+                               (corner & 4) ? aabb.max.z : aabb.min.z);
+            glm::vec4 clip = m_ViewProjection * glm::vec4(position, 1.0f);
+
+            if (clip.w < NearPlaneEpsilon)
+                return true;
+
+            float invW = 1.0f / clip.w;
+            glm::vec2 screen((clip.x * invW * 0.5f + 0.5f) * Width, (clip.y * invW * 0.5f + 0.5f) * Height);
+
+            minPoint = glm::min(minPoint, screen);
+            maxPoint = glm::max(maxPoint, screen);
+            closest = std::max(closest, invW);
+        }
+
+        // Completely outside of the screen, leave it to the frustum culling
+        if (maxPoint.x < 0.0f || maxPoint.y < 0.0f || minPoint.x >= Width || minPoint.y >= Height)
+            return true;
+
+        int blockMinX = std::clamp(static_cast<int>(minPoint.x) / static_cast<int>(BlockSize), 0, static_cast<int>(BlocksX) - 1);
+        int blockMinY = std::clamp(static_cast<int>(minPoint.y) / static_cast<int>(BlockSize), 0, static_cast<int>(BlocksY) - 1);
+        int blockMaxX = std::clamp(static_cast<int>(maxPoint.x) / static_cast<int>(BlockSize), 0, static_cast<int>(BlocksX) - 1);
+        int blockMaxY = std::clamp(static_cast<int>(maxPoint.y) / static_cast<int>(BlockSize), 0, static_cast<int>(BlocksY) - 1);
+
+        for (int blockY = blockMinY; blockY <= blockMaxY; ++blockY)
+        {
+            for (int blockX = blockMinX; blockX <= blockMaxX; ++blockX)
+            {
+                // The box may show through as soon as one block is farther than its closest point
+                if (m_BlockDepth[blockX + blockY * BlocksX] <= closest)
+                    return true;
+            }
+        }
+
+        m_Stats.CulledCount++;
+
+        if (m_DebugDraw)
+        {
+            m_CulledBounds.push_back(aabb);
+        }
+
+        return false;
+    }
+
+    void OcclusionCuller::DebugDraw() const
+    {
+        for (const AABB& aabb : m_CulledBounds)
+        {
+            DebugRenderer::DrawBox(aabb, glm::vec4(1.0f, 0.2f, 0.2f, 1.0f));
+        }
+    }
+
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "CoffeeEngine/IO/CacheBuffer.h"
+#include "CoffeeEngine/Math/BoundingBox.h"
+#include "CoffeeEngine/Renderer/Mesh.h"
+
+#include <array>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @{
+     */
+
+    /**
+     * @brief Statistics of the last occlusion culling pass.
+     */
+    struct OcclusionStats
+    {
+        uint32_t OccluderCount = 0; ///< Number of occluder meshes rasterized.
+        uint32_t OccluderTriangles = 0; ///< Number of occluder triangles binned.
+        uint32_t TestedCount = 0; ///< Number of bounding boxes tested.
+        uint32_t CulledCount = 0; ///< Number of bounding boxes found occluded.
+    };
+
+    /**
+     * @brief CPU software occlusion culling.
+     *
+     * Designated occluder meshes are rasterized into a small depth buffer split in tiles: triangles are first
+     * binned to the tiles they overlap and then each tile is rasterized on its own, in parallel, four pixels at
+     * a time with SSE when available. The depth stored is 1/w, so 0 means nothing was drawn and bigger values
+     * are closer. After rasterization every 8x8 block keeps its farthest depth, and the bounding box of each
+     * candidate is tested against the blocks its screen rectangle covers.
+     *
+     * The test is conservative: boxes crossing the near plane, and pixels not covered by any occluder, are
+     * always visible.
+     */
+    class OcclusionCuller
+    {
+    public:
+        static constexpr uint32_t Width = 256; ///< Width of the depth buffer in pixels.
+        static constexpr uint32_t Height = 128; ///< Height of the depth buffer in pixels.
+        static constexpr uint32_t TileSize = 32; ///< Size in pixels of a binning tile.
+        static constexpr uint32_t BlockSize = 8; ///< Size in pixels of a hierarchical depth block.
+
+        static constexpr uint32_t TilesX = Width / TileSize;
+        static constexpr uint32_t TilesY = Height / TileSize;
+        static constexpr uint32_t BlocksX = Width / BlockSize;
+        static constexpr uint32_t BlocksY = Height / BlockSize;
+
+        OcclusionCuller();
+
+        /**
+         * @brief Starts a new pass, discarding the occluders of the previous one.
+         * @param viewProjection The camera view projection matrix.
+         */
+        void Begin(const glm::mat4& viewProjection);
+
+        /**
+         * @brief Transforms the triangles of an occluder and bins them to the tiles.
+         * @param mesh The occluder mesh. Its CPU vertex and index data is used, and held until the next pass.
+         * @param transform The world transform of the mesh.
+         */
+        void AddOccluder(const Mesh& mesh, const glm::mat4& transform);
+
+        /**
+         * @brief Rasterizes the binned occluders and builds the hierarchical depth.
+         */
+        void Rasterize();
+
+        /**
+         * @brief Tests a world space bounding box against the occluders.
+         * @param aabb The bounding box in world space.
+         * @return False if the box is completely hidden behind the occluders.
+         */
+        bool IsVisible(const AABB& aabb);
+
+        /**
+         * @brief Draws the boxes culled in the current pass through the DebugRenderer.
+         */
+        void DebugDraw() const;
+
+        /**
+         * @brief Gets the depth buffer, Width * Height values of 1/w with 0 where no occluder was drawn.
+         */
+        const std::vector<float>& GetDepthBuffer() const { return m_Depth; }
+
+        const OcclusionStats& GetStats() const { return m_Stats; }
+
+        bool IsEnabled() const { return m_Enabled; }
+        void SetEnabled(bool enabled) { m_Enabled = enabled; }
+
+        bool IsDebugDrawEnabled() const { return m_DebugDraw; }
+        void SetDebugDrawEnabled(bool enabled) { m_DebugDraw = enabled; }
+
+    private:
+        struct ScreenTriangle
+        {
+            glm::vec3 Vertices[3]; ///< x and y in pixels, z is 1/w.
+        };
+
+        void RasterizeTile(uint32_t tile);
+
+    private:
+        glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+
+        std::vector<glm::vec4> m_ClipVertices; ///< Scratch buffer for the vertices of the occluder being added.
+
+        // The data of the occluders of this pass and of the previous one. A mesh that released its data reads it
+        // back from the cache once while it stays an occluder, and lets it go one pass after it stops being one.
+        std::vector<CacheBuffer<Vertex>> m_OccluderVertices, m_PreviousOccluderVertices;
+        std::vector<CacheBuffer<uint32_t>> m_OccluderIndices, m_PreviousOccluderIndices;
+        std::vector<ScreenTriangle> m_Triangles;
+        std::array<std::vector<uint32_t>, TilesX * TilesY> m_TileBins;
+
+        std::vector<float> m_Depth; ///< Per pixel 1/w of the closest occluder.
+        std::vector<float> m_BlockDepth; ///< Per block 1/w of the farthest pixel.
+
+        std::vector<AABB> m_CulledBounds; ///< Boxes culled this pass, kept for the debug view.
+
+        OcclusionStats m_Stats;
+        bool m_Enabled = true;
+        bool m_DebugDraw = false;
+    };
+
+    /** @} */
+}
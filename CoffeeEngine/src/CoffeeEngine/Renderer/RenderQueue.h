@@ -0,0 +1,180 @@
+#pragma once
+
+#include "CoffeeEngine/Core/DataStructures/LinearAllocator.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <type_traits>
+#include <utility>
+
+namespace Coffee {
+
+    class Mesh;
+    class Material;
+
+    /**
+     * @defgroup renderer Renderer
+     * @{
+     */
+
+    /**
+     * @brief A single draw request.
+     *
+     * Render commands are plain data: the mesh and material are borrowed, not owned. The submitter must
+     * guarantee that both outlive the frame, which holds for anything referenced by a component, the
+     * resource registry or a renderer-owned default.
+     */
+    struct RenderCommand
+    {
+        glm::mat4 transform; ///< The world transform of the mesh.
+        Mesh* mesh; ///< The mesh to draw.
+        Material* material; ///< The material to draw with, nullptr uses the default material.
+        uint32_t entityID; ///< The entity ID written to the picking buffer.
+    };
+
+    static_assert(std::is_trivially_copyable_v<RenderCommand> && std::is_trivially_destructible_v<RenderCommand>,
+                  "RenderCommand must stay POD so it can live in the frame arena");
+
+    /**
+     * @brief Frame-scoped queue of render commands.
+     *
+     * Commands are stored in fixed-size pages carved out of a LinearAllocator, so pushing never
+     * reallocates or moves previously submitted commands and Reset() is O(1). Once the arena has grown to
+     * fit the busiest frame, submitting does not touch the general-purpose allocator anymore.
+     */
+    class RenderQueue
+    {
+    public:
+        static constexpr uint32_t PageCapacity = 1024; ///< Number of commands stored per page.
+
+        RenderQueue() : m_Arena(PageCapacity * sizeof(RenderCommand) * 4) {}
+
+        RenderQueue(const RenderQueue&) = delete;
+        RenderQueue& operator=(const RenderQueue&) = delete;
+
+        RenderQueue(RenderQueue&& other) noexcept
+            : m_Arena(std::move(other.m_Arena)), m_Head(std::exchange(other.m_Head, nullptr)),
+              m_Tail(std::exchange(other.m_Tail, nullptr)), m_Size(std::exchange(other.m_Size, 0))
+        {
+        }
+
+        RenderQueue& operator=(RenderQueue&& other) noexcept
+        {
+            m_Arena = std::move(other.m_Arena);
+            m_Head = std::exchange(other.m_Head, nullptr);
+            m_Tail = std::exchange(other.m_Tail, nullptr);
+            m_Size = std::exchange(other.m_Size, 0);
+            return *this;
+        }
+
+        /**
+         * @brief Appends a command to the queue.
+         * @param command The command to append.
+         */
+        void Push(const RenderCommand& command)
+        {
+            if (!m_Tail || m_Tail->Count == PageCapacity)
+            {
+                AddPage();
+            }
+
+            m_Tail->Commands[m_Tail->Count++] = command;
+            m_Size++;
+        }
+
+        /**
+         * @brief Copies every command of another queue to the end of this one.
+         * @param other The queue to append.
+         */
+        void Append(const RenderQueue& other)
+        {
+            for (const Page* page = other.m_Head; page; page = page->Next)
+            {
+                uint32_t copied = 0;
+                while (copied < page->Count)
+                {
+                    if (!m_Tail || m_Tail->Count == PageCapacity)
+                    {
+                        AddPage();
+                    }
+
+                    uint32_t batch = std::min(page->Count - copied, PageCapacity - m_Tail->Count);
+                    std::copy_n(page->Commands + copied, batch, m_Tail->Commands + m_Tail->Count);
+                    m_Tail->Count += batch;
+                    copied += batch;
+                }
+            }
+
+            m_Size += other.m_Size;
+        }
+
+        /**
+         * @brief Calls a function for every command in submission order.
+         * @param func The function to call, receives a const RenderCommand&.
+         */
+        template <typename Func>
+        void ForEach(Func&& func) const
+        {
+            for (const Page* page = m_Head; page; page = page->Next)
+            {
+                for (uint32_t i = 0; i < page->Count; ++i)
+                {
+                    func(page->Commands[i]);
+                }
+            }
+        }
+
+        /**
+         * @brief Drops every command. The pages stay allocated for the next frame.
+         */
+        void Reset()
+        {
+            m_Arena.Reset();
+            m_Head = m_Tail = nullptr;
+            m_Size = 0;
+        }
+
+        /**
+         * @brief Gets the number of commands in the queue.
+         * @return The command count.
+         */
+        uint32_t Size() const { return m_Size; }
+
+        /**
+         * @brief Checks whether the queue is empty.
+         * @return True if no command has been submitted.
+         */
+        bool Empty() const { return m_Size == 0; }
+
+    private:
+        struct Page
+        {
+            RenderCommand Commands[PageCapacity];
+            uint32_t Count;
+            Page* Next;
+        };
+
+        void AddPage()
+        {
+            Page* page = m_Arena.AllocateArray<Page>(1);
+            page->Count = 0;
+            page->Next = nullptr;
+
+            if (m_Tail)
+                m_Tail->Next = page;
+            else
+                m_Head = page;
+
+            m_Tail = page;
+        }
+
+    private:
+        LinearAllocator m_Arena;
+        Page* m_Head = nullptr;
+        Page* m_Tail = nullptr;
+        uint32_t m_Size = 0;
+    };
+
+    /** @} */
+}
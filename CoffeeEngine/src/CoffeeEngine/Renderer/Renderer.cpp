@@ -23,6 +23,7 @@ namespace Coffee {
 
     static bool s_viewportResized = false;
     static uint32_t s_viewportWidth = 0, s_viewportHeight = 0;
+    static uint32_t s_DroppedLightCount = 0;
 
     RendererData Renderer::s_RendererData;
     RendererStats Renderer::s_Stats;
@@ -70,6 +71,11 @@ namespace Coffee {
         s_RendererData.CameraUniformBuffer = UniformBuffer::Create(sizeof(RendererData::CameraData), 0);
         s_RendererData.RenderDataUniformBuffer = UniformBuffer::Create(sizeof(RendererData::RenderData), 1);
 
+        s_RendererData.lights.reserve(RendererData::MaxLights);
+        s_RendererData.LightStorageBuffer = StorageBuffer::Create(64 * sizeof(LightComponent), 2);
+        s_RendererData.ClusterStorageBuffer = StorageBuffer::Create(LightClusterGrid::ClusterCount * sizeof(LightClusterRange), 3);
+        s_RendererData.LightIndexStorageBuffer = StorageBuffer::Create(1024 * sizeof(uint32_t), 4);
+
         Ref<Shader> missingShader = CreateRef<Shader>("MissingShader", std::string(missingShaderSource));
         s_RendererData.DefaultMaterial = CreateRef<Material>("Missing Material", missingShader); //TODO: Port it to use the Material::Create
 
@@ -110,7 +116,11 @@ namespace Coffee {
         s_RendererData.cameraData.position = camera.GetPosition();
         s_RendererData.CameraUniformBuffer->SetData(&s_RendererData.cameraData, sizeof(RendererData::CameraData));
 
-        s_RendererData.renderData.lightCount = 0;
+        s_RendererData.cameraNearClip = camera.GetNearClip();
+        s_RendererData.cameraFarClip = camera.GetFarClip();
+
+        s_RendererData.lights.clear();
+        s_DroppedLightCount = 0;
 
         BillboardRenderer::BeginScene(camera.GetViewProjection(), camera.GetPosition(), camera.GetUpDirection());
     }
@@ -129,7 +139,11 @@ namespace Coffee {
         s_RendererData.cameraData.position = transform[3];
         s_RendererData.CameraUniformBuffer->SetData(&s_RendererData.cameraData, sizeof(RendererData::CameraData));
 
-        s_RendererData.renderData.lightCount = 0;
+        s_RendererData.cameraNearClip = camera.GetNearClip();
+        s_RendererData.cameraFarClip = camera.GetFarClip();
+
+        s_RendererData.lights.clear();
+        s_DroppedLightCount = 0;
     }
 
     void Renderer::EndScene()
@@ -143,13 +157,17 @@ namespace Coffee {
         // Currently this is done also in the runtime, this should be done only in editor mode
         s_EntityIDTexture->Clear({-1.0f,0.0f,0.0f,0.0f});
 
-        s_RendererData.RenderDataUniformBuffer->SetData(&s_RendererData.renderData, sizeof(RendererData::RenderData));
+        UploadLights();
 
         // Sort the render queue to minimize state changes
 
-        for(const auto& command : s_RendererData.renderQueue)
+        s_RendererData.renderQueue.ForEach([](const RenderCommand& command)
         {
-            Material* material = command.material.get();
+            // CPU only meshes have no buffers to draw
+            if (!command.mesh->GetVertexArray())
+                return;
+
+            Material* material = command.material;
 
             if(material == nullptr)
             {
@@ -179,9 +197,9 @@ namespace Coffee {
 
             s_Stats.DrawCalls++;
 
-            s_Stats.VertexCount += command.mesh->GetVertices().size();
-            s_Stats.IndexCount += command.mesh->GetIndices().size();
-        }
+            s_Stats.VertexCount += command.mesh->GetVertexCount();
+            s_Stats.IndexCount += command.mesh->GetIndexCount();
+        });
 
         // Test drawing the skybox
         RendererAPI::SetDepthMask(false);
@@ -189,6 +207,9 @@ namespace Coffee {
         RendererAPI::DrawIndexed(s_SkyboxMesh->GetVertexArray());
         RendererAPI::SetDepthMask(true);
 
+        // Billboards go after the opaque geometry so they blend over it
+        BillboardRenderer::EndScene();
+
         if(s_RenderSettings.PostProcessing)
         {
             //Render All the fancy effects :D
@@ -230,9 +251,7 @@ namespace Coffee {
 
         s_MainFramebuffer->UnBind();
 
-        s_RendererData.renderQueue.clear();
-
-        BillboardRenderer::EndScene();
+        s_RendererData.renderQueue.Reset();
     }
 
     //TEMPORAL
@@ -253,13 +272,50 @@ namespace Coffee {
 
     void Renderer::Submit(const LightComponent& light)
     {
-        s_RendererData.renderData.lights[s_RendererData.renderData.lightCount] = light;
-        s_RendererData.renderData.lightCount++;
+        if (s_RendererData.lights.size() >= RendererData::MaxLights)
+        {
+            // Warn only on the first dropped light of the frame
+            if (s_DroppedLightCount++ == 0)
+            {
+                COFFEE_CORE_WARN("Renderer: more than {0} lights submitted, the extra lights are ignored", RendererData::MaxLights);
+            }
+            return;
+        }
+
+        s_RendererData.lights.push_back(light);
+    }
+
+    void Renderer::UploadLights()
+    {
+        ZoneScoped;
+
+        RendererData& data = s_RendererData;
+        LightClusterGrid& clusters = data.lightClusters;
+
+        clusters.Build(data.cameraData.projection, data.cameraData.view, data.cameraNearClip, data.cameraFarClip, data.lights);
+
+        data.renderData.clusterGrid = glm::uvec4(LightClusterGrid::GridSizeX, LightClusterGrid::GridSizeY,
+                                                 LightClusterGrid::GridSizeZ, clusters.GetDirectionalLightCount());
+        data.renderData.clusterDepth = glm::vec4(clusters.GetNearClip(), clusters.GetFarClip(), clusters.GetSliceScale(),
+                                                 clusters.GetSliceBias());
+        data.renderData.lightCount = static_cast<int>(data.lights.size());
+
+        data.RenderDataUniformBuffer->SetData(&data.renderData, sizeof(RendererData::RenderData));
+        data.LightStorageBuffer->SetData(data.lights.data(), static_cast<uint32_t>(data.lights.size() * sizeof(LightComponent)));
+        data.ClusterStorageBuffer->SetData(clusters.GetClusterRanges().data(),
+                                           static_cast<uint32_t>(clusters.GetClusterRanges().size() * sizeof(LightClusterRange)));
+        data.LightIndexStorageBuffer->SetData(clusters.GetLightIndices().data(),
+                                              static_cast<uint32_t>(clusters.GetLightIndices().size() * sizeof(uint32_t)));
     }
 
     void Renderer::Submit(const RenderCommand& command)
     {
-        s_RendererData.renderQueue.push_back(command);
+        s_RendererData.renderQueue.Push(command);
+    }
+
+    void Renderer::Submit(const RenderQueue& queue)
+    {
+        s_RendererData.renderQueue.Append(queue);
     }
 
     // Temporal, this should be removed because this is rendering immediately.
@@ -3,9 +3,12 @@
 #include "CoffeeEngine/Core/Base.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
 #include "CoffeeEngine/Renderer/Framebuffer.h"
+#include "CoffeeEngine/Renderer/LightClusterGrid.h"
 #include "CoffeeEngine/Renderer/Material.h"
 #include "CoffeeEngine/Renderer/Mesh.h"
+#include "CoffeeEngine/Renderer/RenderQueue.h"
 #include "CoffeeEngine/Renderer/Shader.h"
+#include "CoffeeEngine/Renderer/StorageBuffer.h"
 #include "CoffeeEngine/Renderer/Texture.h"
 #include "CoffeeEngine/Renderer/UniformBuffer.h"
 #include "CoffeeEngine/Renderer/VertexArray.h"
@@ -21,14 +24,6 @@ namespace Coffee {
      * @{
      */
 
-    struct RenderCommand
-    {
-        glm::mat4 transform;
-        Ref<Mesh> mesh;
-        Ref<Material> material;
-        uint32_t entityID;
-    };
-
     /**
      * @brief Structure containing renderer data.
      */
@@ -49,21 +44,32 @@ namespace Coffee {
          */
         struct RenderData
         {
-            LightComponent lights[32]; ///< Array of light components.
+            glm::uvec4 clusterGrid = glm::uvec4(0); ///< Cluster grid size (xyz) and directional light count (w).
+            glm::vec4 clusterDepth = glm::vec4(0.0f); ///< Near clip, far clip, depth slice scale and bias.
             int lightCount = 0; ///< Number of lights.
         };
 
+        static constexpr uint32_t MaxLights = 1024; ///< Maximum number of lights per frame.
+
         CameraData cameraData; ///< Camera data.
         RenderData renderData; ///< Render data.
+        float cameraNearClip = 0.1f; ///< Near clip of the current camera.
+        float cameraFarClip = 1000.0f; ///< Far clip of the current camera.
+
+        std::vector<LightComponent> lights; ///< Lights submitted this frame.
+        LightClusterGrid lightClusters; ///< Assignment of the lights to the view clusters.
 
         Ref<UniformBuffer> CameraUniformBuffer; ///< Uniform buffer for camera data.
         Ref<UniformBuffer> RenderDataUniformBuffer; ///< Uniform buffer for render data.
+        Ref<StorageBuffer> LightStorageBuffer; ///< Storage buffer with the lights.
+        Ref<StorageBuffer> ClusterStorageBuffer; ///< Storage buffer with the light range of every cluster.
+        Ref<StorageBuffer> LightIndexStorageBuffer; ///< Storage buffer with the light indices of the clusters.
 
         Ref<Material> DefaultMaterial; ///< Default material.
 
         Ref<Texture2D> RenderTexture; ///< Render texture.
 
-        std::vector<RenderCommand> renderQueue; ///< Render queue.
+        RenderQueue renderQueue; ///< Render queue, reset at the end of every frame.
     };
 
     /**
@@ -136,12 +142,25 @@ namespace Coffee {
          */
         static void EndOverlay();
 
+        /**
+         * @brief Submits a mesh to be drawn at the end of the scene.
+         * @param command The render command. The mesh and material must stay alive until EndScene.
+         */
         static void Submit(const RenderCommand& command);
 
+        /**
+         * @brief Submits every command of a queue, usually one filled by a worker thread.
+         * @param queue The queue to copy into the frame render queue.
+         */
+        static void Submit(const RenderQueue& queue);
+
         static void Submit(const Ref<Shader>& shader, const Ref<VertexArray>& vertexArray, const glm::mat4& transform = glm::mat4(1.0f), uint32_t entityID = 4294967295);
 
         /**
          * @brief Submits a light component.
+         *
+         * Lights past RendererData::MaxLights are dropped with a warning.
+         *
          * @param light The light component.
          */
 
@@ -196,6 +215,11 @@ namespace Coffee {
 
         static void ResizeFramebuffers();
 
+        /**
+         * @brief Assigns the submitted lights to the view clusters and uploads them to the GPU buffers.
+         */
+        static void UploadLights();
+
     private:
         static RendererData s_RendererData; ///< Renderer data.
         static RendererStats s_Stats; ///< Renderer statistics.
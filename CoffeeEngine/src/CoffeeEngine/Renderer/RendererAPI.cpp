@@ -49,6 +49,9 @@ namespace Coffee {
 		glCullFace(GL_BACK);
 
 		glDepthFunc(GL_LEQUAL);
+
+		// Vertex color read by the standard shader when the vertex array has none, only billboards provide it
+		glVertexAttrib4f(5, 1.0f, 1.0f, 1.0f, 1.0f);
     }
 
 	void RendererAPI::SetClearColor(const glm::vec4& color)
@@ -83,6 +86,16 @@ namespace Coffee {
         glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, nullptr);
     }
 
+    void RendererAPI::DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount)
+    {
+        ZoneScoped;
+
+        vertexArray->Bind();
+		vertexArray->GetVertexBuffers()[0]->Bind();
+		vertexArray->GetIndexBuffer()->Bind();
+        glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+    }
+
 	void RendererAPI::DrawLines(const Ref<VertexArray>& vertexArray, uint32_t vertexCount, float lineWidth)
 	{
 		ZoneScoped;
@@ -46,6 +46,13 @@ namespace Coffee {
          */
         static void DrawIndexed(const Ref<VertexArray>& vertexArray);
 
+        /**
+         * @brief Draws the first indices of the specified vertex array.
+         * @param vertexArray The vertex array containing the vertices to draw.
+         * @param indexCount The number of indices to draw.
+         */
+        static void DrawIndexed(const Ref<VertexArray>& vertexArray, uint32_t indexCount);
+
         /**
          * @brief Draws lines from the specified vertex array.
          * @param vertexArray The vertex array containing the vertices to draw.
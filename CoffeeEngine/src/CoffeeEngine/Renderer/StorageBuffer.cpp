@@ -0,0 +1,44 @@
+#include "StorageBuffer.h"
+#include "CoffeeEngine/Core/Base.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <glad/glad.h>
+
+namespace Coffee {
+
+    StorageBuffer::StorageBuffer(uint32_t size, uint32_t binding)
+        : m_Size(std::max(size, 16u)), m_Binding(binding)
+    {
+        glCreateBuffers(1, &m_ssboID);
+        glNamedBufferData(m_ssboID, m_Size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_Binding, m_ssboID);
+    }
+
+    StorageBuffer::~StorageBuffer()
+    {
+        glDeleteBuffers(1, &m_ssboID);
+    }
+
+    void StorageBuffer::SetData(const void* data, uint32_t size)
+    {
+        if (size > m_Size)
+        {
+            // Grow geometrically so a steadily increasing amount of data does not reallocate every frame
+            m_Size = std::max(size, m_Size * 2);
+            glNamedBufferData(m_ssboID, m_Size, nullptr, GL_DYNAMIC_DRAW);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, m_Binding, m_ssboID);
+        }
+
+        if (size > 0)
+        {
+            glNamedBufferSubData(m_ssboID, 0, size, data);
+        }
+    }
+
+    Ref<StorageBuffer> StorageBuffer::Create(uint32_t size, uint32_t binding)
+    {
+        return CreateRef<StorageBuffer>(size, binding);
+    }
+
+}
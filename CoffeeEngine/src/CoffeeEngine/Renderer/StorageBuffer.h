@@ -0,0 +1,63 @@
+#pragma once
+
+#include "CoffeeEngine/Core/Base.h"
+
+#include <cstdint>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @brief Renderer components of the CoffeeEngine.
+     * @{
+     */
+
+    /**
+     * @brief Class representing a shader storage buffer.
+     *
+     * Unlike the uniform buffers its size is not fixed, the buffer is reallocated when the data does not fit.
+     */
+    class StorageBuffer
+    {
+    public:
+        /**
+         * @brief Constructs a StorageBuffer with the specified initial size and binding.
+         * @param size The initial size of the buffer.
+         * @param binding The binding point of the buffer.
+         */
+        StorageBuffer(uint32_t size, uint32_t binding);
+
+        /**
+         * @brief Destructor for the StorageBuffer class.
+         */
+        virtual ~StorageBuffer();
+
+        /**
+         * @brief Replaces the contents of the storage buffer, growing it if needed.
+         * @param data A pointer to the data to set.
+         * @param size The size of the data.
+         */
+        void SetData(const void* data, uint32_t size);
+
+        /**
+         * @brief Gets the current capacity of the buffer.
+         * @return The size in bytes.
+         */
+        uint32_t GetSize() const { return m_Size; }
+
+        /**
+         * @brief Creates a storage buffer with the specified initial size and binding.
+         * @param size The initial size of the buffer.
+         * @param binding The binding point of the buffer.
+         * @return A reference to the created storage buffer.
+         */
+        static Ref<StorageBuffer> Create(uint32_t size, uint32_t binding);
+
+    private:
+        uint32_t m_ssboID; ///< The ID of the storage buffer.
+        uint32_t m_Size; ///< The capacity of the buffer in bytes.
+        uint32_t m_Binding; ///< The binding point of the buffer.
+    };
+
+    /** @} */
+}
@@ -1,8 +1,10 @@
 #include "CoffeeEngine/Renderer/Texture.h"
 #include "CoffeeEngine/Core/Base.h"
 #include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/IO/CacheManager.h"
 #include "CoffeeEngine/IO/Resource.h"
 #include "CoffeeEngine/IO/ResourceLoader.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
 
 #include <cereal/archives/binary.hpp>
 #include <cereal/types/vector.hpp>
@@ -69,6 +71,18 @@ namespace Coffee {
         }
     }
 
+    uint32_t ImageFormatToBytesPerPixel(ImageFormat format)
+    {
+        switch(format)
+        {
+            case ImageFormat::R32F: return 4; break;
+            case ImageFormat::RGB32F: return 12; break;
+            case ImageFormat::RGBA32F: return 16; break;
+            case ImageFormat::DEPTH24STENCIL8: return 4; break;
+            default: return ImageFormatToChannelCount(format); break;
+        }
+    }
+
     Texture2D::Texture2D(const TextureProperties& properties)
         : m_Properties(properties), m_Width(properties.Width), m_Height(properties.Height)
     {
@@ -82,22 +96,11 @@ namespace Coffee {
     {
         ZoneScoped;
 
-        int mipLevels = 1 + floor(log2(std::max(m_Width, m_Height)));
-
-        GLenum internalFormat = ImageFormatToOpenGLInternalFormat(m_Properties.Format);
-        GLenum format = ImageFormatToOpenGLFormat(m_Properties.Format);
-
-        glCreateTextures(GL_TEXTURE_2D, 1, &m_textureID);
-        glTextureStorage2D(m_textureID, mipLevels, internalFormat, m_Width, m_Height);
-
-        glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
-
-        glTextureParameteri(m_textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTextureParameteri(m_textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        //Add an option to choose the anisotropic filtering level
-        glTextureParameterf(m_textureID, GL_TEXTURE_MAX_ANISOTROPY, 16.0f);
+        // Textures decoded on job threads get their storage from the upload queue
+        if (UploadQueue::CanUploadNow())
+        {
+            CreateStorage();
+        }
     }
 
     Texture2D::Texture2D(const std::filesystem::path& path, bool srgb)
@@ -111,7 +114,8 @@ namespace Coffee {
         m_Properties.srgb = srgb;
 
         int nrComponents;
-        stbi_set_flip_vertically_on_load(true);
+        // Per thread, textures are decoded on job threads too
+        stbi_set_flip_vertically_on_load_thread(true);
         unsigned char* data = stbi_load(m_FilePath.string().c_str(), &m_Width, &m_Height, &nrComponents, 0);
 
         m_Properties.Width = m_Width, m_Properties.Height = m_Height;
@@ -120,6 +124,7 @@ namespace Coffee {
         {
             m_Data = std::vector<unsigned char>(data, data + m_Width * m_Height * nrComponents);
             stbi_image_free(data);
+            SetCPUMemoryUsage(m_Data.size());
 
             switch (nrComponents)
             {
@@ -131,33 +136,143 @@ namespace Coffee {
                     m_Properties.Format = m_Properties.srgb ? ImageFormat::SRGBA8 : ImageFormat::RGBA8; break;
             }
 
-            int mipLevels = 1 + floor(log2(std::max(m_Width, m_Height)));
-            GLenum internalFormat = ImageFormatToOpenGLInternalFormat(m_Properties.Format);
-            GLenum format = ImageFormatToOpenGLFormat(m_Properties.Format);
+            if (UploadQueue::CanUploadNow())
+            {
+                Upload();
+            }
+        }
+        else
+        {
+            COFFEE_CORE_ERROR("Failed to load texture: {0} (REASON: {1})", m_FilePath.string(), stbi_failure_reason());
+            m_textureID = 0; // Set texture ID to 0 to indicate failure
+        }
+    }
 
-            glCreateTextures(GL_TEXTURE_2D, 1, &m_textureID);
-            glTextureStorage2D(m_textureID, mipLevels, internalFormat, m_Width, m_Height);
+    void Texture2D::CreateStorage()
+    {
+        int mipLevels = 1 + floor(log2(std::max(m_Width, m_Height)));
 
-            glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
-            glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        GLenum internalFormat = ImageFormatToOpenGLInternalFormat(m_Properties.Format);
 
-            glTextureParameteri(m_textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-            glTextureParameteri(m_textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glCreateTextures(GL_TEXTURE_2D, 1, &m_textureID);
+        glTextureStorage2D(m_textureID, mipLevels, internalFormat, m_Width, m_Height);
+
+        glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTextureParameteri(m_textureID, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        glTextureParameteri(m_textureID, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTextureParameteri(m_textureID, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        //Add an option to choose the anisotropic filtering level
+        glTextureParameterf(m_textureID, GL_TEXTURE_MAX_ANISOTROPY, 16.0f);
+
+        // The mip chain adds about a third of the base level
+        uint64_t baseLevelSize = (uint64_t)m_Width * m_Height * ImageFormatToBytesPerPixel(m_Properties.Format);
+        SetGPUMemoryUsage(baseLevelSize + baseLevelSize / 3);
+    }
+
+    void Texture2D::Upload()
+    {
+        ZoneScoped;
 
-            //Add an option to choose the anisotropic filtering level
-            glTextureParameterf(m_textureID, GL_TEXTURE_MAX_ANISOTROPY, 16.0f);
+        // Already uploaded, kept on the CPU, or the image could not be decoded
+        if (m_textureID != 0 || m_Residency == ResourceResidency::CPUOnly || m_Width <= 0 || m_Height <= 0)
+            return;
 
-            glTextureSubImage2D(m_textureID, 0, 0, 0, m_Width, m_Height, format, GL_UNSIGNED_BYTE, m_Data.data());
+        RestoreCPUData();
+        CreateStorage();
 
-            glGenerateTextureMipmap(m_textureID);
+        if (!m_Data.empty())
+        {
+            SetData(m_Data.data(), m_Data.size());
         }
-        else
+    }
+
+    void Texture2D::ApplyResidency()
+    {
+        ZoneScoped;
+
+        switch (m_Residency)
         {
-            COFFEE_CORE_ERROR("Failed to load texture: {0} (REASON: {1})", m_FilePath.string(), stbi_failure_reason());
-            m_textureID = 0; // Set texture ID to 0 to indicate failure
+        case ResourceResidency::CPUAndGPU:
+            RestoreCPUData();
+            Upload();
+            break;
+        case ResourceResidency::GPUOnly:
+            Upload();
+
+            // Only released when the cache can give the pixels back
+            if (m_textureID != 0 && !m_Data.empty() && std::filesystem::exists(CacheManager::GetCachedFilePath(m_UUID)))
+            {
+                std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+                m_Data.clear();
+                m_CPUDataReleased.store(true, std::memory_order_release);
+                SetCPUMemoryUsage(0);
+            }
+            break;
+        case ResourceResidency::CPUOnly:
+            if (RestoreCPUData() && m_textureID != 0)
+            {
+                glDeleteTextures(1, &m_textureID);
+                m_textureID = 0;
+                SetGPUMemoryUsage(0);
+            }
+            break;
         }
     }
 
+    bool Texture2D::RestoreCPUData() const
+    {
+        if (!m_CPUDataReleased.load(std::memory_order_acquire))
+            return true;
+
+        std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+        if (!m_CPUDataReleased.load(std::memory_order_relaxed))
+            return true;
+
+        Ref<const Texture2D> cached = ReadBackCPUData();
+        if (!cached)
+            return false;
+
+        // Shared with the cached instance, both point into the mapped cache file
+        m_Data = cached->m_Data;
+        SetCPUMemoryUsage(m_Data.size());
+        m_CPUDataReleased.store(false, std::memory_order_release);
+        return true;
+    }
+
+    Ref<const Texture2D> Texture2D::ReadBackCPUData() const
+    {
+        if (Ref<const Texture2D> readBack = m_ReadBack.lock())
+            return readBack;
+
+        ZoneScoped;
+
+        Ref<const Texture2D> cached = std::dynamic_pointer_cast<const Texture2D>(ResourceLoader::LoadCPUData(m_UUID));
+        if (!cached)
+        {
+            COFFEE_CORE_ERROR("Texture2D::ReadBackCPUData: Could not read the pixels of {0} back from the cache", m_Name);
+            return nullptr;
+        }
+
+        m_ReadBack = cached;
+        return cached;
+    }
+
+    CacheBuffer<unsigned char> Texture2D::GetData() const
+    {
+        std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+        if (!m_CPUDataReleased.load(std::memory_order_relaxed))
+            return m_Data;
+
+        // The buffer keeps the copy read back alive, the texture stays released
+        Ref<const Texture2D> readBack = ReadBackCPUData();
+        if (!readBack)
+            return {};
+
+        return CacheBuffer<unsigned char>(readBack, readBack->m_Data.data(), readBack->m_Data.size());
+    }
+
     Texture2D::~Texture2D()
     {
         ZoneScoped;
@@ -203,6 +318,9 @@ namespace Coffee {
         //Add an option to choose the anisotropic filtering level
         glTextureParameterf(m_textureID, GL_TEXTURE_MAX_ANISOTROPY, 16.0f);
 
+        uint64_t baseLevelSize = (uint64_t)m_Width * m_Height * ImageFormatToBytesPerPixel(m_Properties.Format);
+        SetGPUMemoryUsage(baseLevelSize + baseLevelSize / 3);
+
         //Te code above is the same as the constructor but for some reason it doesn't work
         //Texture2D(m_Width, m_Height, m_Properties.Format);
     }
@@ -217,7 +335,7 @@ namespace Coffee {
         glClearTexImage(m_textureID, 0, format, GL_FLOAT, &color);
     }
 
-    void Texture2D::SetData(void* data, uint32_t size)
+    void Texture2D::SetData(const void* data, uint32_t size)
     {
         ZoneScoped;
 
@@ -368,9 +486,10 @@ namespace Coffee {
         LoadHDRFromData(m_HDRData);
     }
 
-    void Cubemap::LoadStandardFromData(const std::vector<unsigned char>& data)
+    void Cubemap::LoadStandardFromData(const CacheBuffer<unsigned char>& data)
     {
         m_Data = data;
+        SetCPUMemoryUsage(m_Data.size());
 
         int nrChannels = ImageFormatToChannelCount(m_Properties.Format);
 
@@ -384,6 +503,7 @@ namespace Coffee {
         if (m_Width != faceSize * 4 || m_Height != faceSize * 3) {
             COFFEE_CORE_ERROR("Cubemap texture layout is invalid: {0}", m_FilePath.string());
             m_Data.clear();
+            SetCPUMemoryUsage(0);
             return;
         }
 
@@ -408,27 +528,24 @@ namespace Coffee {
             {3, 1}  // -Z
         };
 
+        // The faces are read in place from the cross layout, the data may be a read-only mapping
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, m_Width);
         for (int i = 0; i < 6; ++i) {
             int offsetX = offsets[i][0] * faceSize;
             int offsetY = offsets[i][1] * faceSize;
 
-            unsigned char* faceBuffer = new unsigned char[faceSize * faceSize * nrChannels];
-            for (int y = 0; y < faceSize; ++y) {
-                memcpy(
-                    faceBuffer + y * faceSize * nrChannels,
-                    m_Data.data() + ((offsetY + y) * m_Width + offsetX) * nrChannels,
-                    faceSize * nrChannels
-                );
-            }
-
             glTexImage2D(
                 targets[i],
                 0, internalFormat, faceSize, faceSize,
-                0, format, GL_UNSIGNED_BYTE, faceBuffer
+                0, format, GL_UNSIGNED_BYTE,
+                m_Data.data() + ((size_t)offsetY * m_Width + offsetX) * nrChannels
             );
-
-            delete[] faceBuffer;
         }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        SetGPUMemoryUsage((uint64_t)faceSize * faceSize * 6 * ImageFormatToBytesPerPixel(m_Properties.Format));
 
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -437,9 +554,10 @@ namespace Coffee {
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     }
 
-    void Cubemap::LoadHDRFromData(const std::vector<float>& data)
+    void Cubemap::LoadHDRFromData(const CacheBuffer<float>& data)
     {
         m_HDRData = data;
+        SetCPUMemoryUsage(m_HDRData.size() * sizeof(float));
 
         int nrChannels = ImageFormatToChannelCount(m_Properties.Format);
         
@@ -452,6 +570,7 @@ namespace Coffee {
         if (m_Width != faceSize * 4 || m_Height != faceSize * 3) {
             COFFEE_CORE_ERROR("Cubemap texture layout is invalid: {0}", m_FilePath.string());
             m_HDRData.clear();
+            SetCPUMemoryUsage(0);
             return;
         }
         
@@ -476,27 +595,21 @@ namespace Coffee {
             {3, 1}  // -Z
         };
         
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, m_Width);
         for (int i = 0; i < 6; ++i) {
             int offsetX = offsets[i][0] * faceSize;
             int offsetY = offsets[i][1] * faceSize;
         
-            float* faceBuffer = new float[faceSize * faceSize * nrChannels];
-            for (int y = 0; y < faceSize; ++y) {
-                memcpy(
-                    faceBuffer + y * faceSize * nrChannels,
-                    m_HDRData.data() + ((offsetY + y) * m_Width + offsetX) * nrChannels,
-                    faceSize * nrChannels * sizeof(float)
-                );
-            }
-        
             glTexImage2D(
                 targets[i],
                 0, internalFormat, faceSize, faceSize,
-                0, format, GL_FLOAT, faceBuffer
+                0, format, GL_FLOAT,
+                m_HDRData.data() + ((size_t)offsetY * m_Width + offsetX) * nrChannels
             );
-        
-            delete[] faceBuffer;
         }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+        SetGPUMemoryUsage((uint64_t)faceSize * faceSize * 6 * ImageFormatToBytesPerPixel(m_Properties.Format));
         
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
@@ -505,6 +618,88 @@ namespace Coffee {
         glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
     }
 
+    bool Cubemap::IsHDR() const
+    {
+        const ImageFormat format = m_Properties.Format;
+        return !(format == ImageFormat::R8 || format == ImageFormat::RG8 || format == ImageFormat::RGB8 || format == ImageFormat::RGBA8);
+    }
+
+    void Cubemap::Upload()
+    {
+        ZoneScoped;
+
+        if (m_textureID != 0 || m_Residency == ResourceResidency::CPUOnly || !RestoreCPUData())
+            return;
+
+        if (IsHDR())
+        {
+            LoadHDRFromData(m_HDRData);
+        }
+        else
+        {
+            LoadStandardFromData(m_Data);
+        }
+    }
+
+    void Cubemap::ApplyResidency()
+    {
+        ZoneScoped;
+
+        switch (m_Residency)
+        {
+        case ResourceResidency::CPUAndGPU:
+            RestoreCPUData();
+            Upload();
+            break;
+        case ResourceResidency::GPUOnly:
+            Upload();
+
+            // Only released when the cache can give the pixels back
+            if (m_textureID != 0 && !m_CPUDataReleased && std::filesystem::exists(CacheManager::GetCachedFilePath(m_UUID)))
+            {
+                std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+                m_Data.clear();
+                m_HDRData.clear();
+                m_CPUDataReleased.store(true, std::memory_order_release);
+                SetCPUMemoryUsage(0);
+            }
+            break;
+        case ResourceResidency::CPUOnly:
+            if (RestoreCPUData() && m_textureID != 0)
+            {
+                glDeleteTextures(1, &m_textureID);
+                m_textureID = 0;
+                SetGPUMemoryUsage(0);
+            }
+            break;
+        }
+    }
+
+    bool Cubemap::RestoreCPUData() const
+    {
+        if (!m_CPUDataReleased.load(std::memory_order_acquire))
+            return true;
+
+        std::lock_guard<std::mutex> lock(m_CPUDataMutex);
+        if (!m_CPUDataReleased.load(std::memory_order_relaxed))
+            return true;
+
+        ZoneScoped;
+
+        Ref<Cubemap> cached = std::dynamic_pointer_cast<Cubemap>(ResourceLoader::LoadCPUData(m_UUID));
+        if (!cached)
+        {
+            COFFEE_CORE_ERROR("Cubemap::RestoreCPUData: Could not read the pixels of {0} back from the cache", m_Name);
+            return false;
+        }
+
+        m_Data = cached->m_Data;
+        m_HDRData = cached->m_HDRData;
+        SetCPUMemoryUsage(m_Data.size() + m_HDRData.size() * sizeof(float));
+        m_CPUDataReleased.store(false, std::memory_order_release);
+        return true;
+    }
+
     Ref<Cubemap> Cubemap::Load(const std::filesystem::path& path)
     {
         return ResourceLoader::LoadCubemap(path);
@@ -1,15 +1,20 @@
 #pragma once
 
 #include "CoffeeEngine/Core/Base.h"
+#include "CoffeeEngine/IO/CacheBuffer.h"
 #include "CoffeeEngine/IO/Resource.h"
 #include "CoffeeEngine/IO/Serialization/FilesystemPathSerialization.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
 
 #include <cereal/access.hpp>
 #include <cereal/types/polymorphic.hpp>
 #include <cereal/archives/binary.hpp>
 #include <cereal/types/vector.hpp>
 #include <cstdint>
+#include <atomic>
 #include <glm/fwd.hpp>
+#include <mutex>
+#include <span>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -94,7 +99,26 @@ namespace Coffee {
         const std::filesystem::path& GetFilePath() const { return m_FilePath; }
 
         void Clear(glm::vec4 color);
-        void SetData(void* data, uint32_t size);
+        void SetData(const void* data, uint32_t size);
+
+        /**
+         * @brief Creates the texture storage and uploads the pixels if the texture was decoded outside of the
+         * main thread.
+         */
+        void Upload() override;
+
+        /**
+         * @brief Releases the pixels once uploaded, or the storage of a CPU only texture.
+         */
+        void ApplyResidency() override;
+
+        /**
+         * @brief Gets the decoded pixels, read back from the cache if they were released.
+         *
+         * The texture does not keep the pixels read back, they are released with the last buffer referring to them.
+         * @return A buffer keeping the pixels alive, even if the texture releases its own meanwhile.
+         */
+        CacheBuffer<unsigned char> GetData() const;
 
         static Ref<Texture2D> Load(const std::filesystem::path& path, bool srgb = true);
         static Ref<Texture2D> Create(uint32_t width, uint32_t height, ImageFormat format);
@@ -105,6 +129,7 @@ namespace Coffee {
         template<class Archive>
         void save(Archive& archive) const
         {
+            RestoreCPUData();
             archive(m_Properties, m_Data, m_Width, m_Height, cereal::base_class<Texture>(this));
         }
 
@@ -124,13 +149,36 @@ namespace Coffee {
             data(construct->m_Data, construct->m_Width, construct->m_Height,
                  cereal::base_class<Texture>(construct.ptr()));
             construct->m_Properties = properties;
-            construct->SetData(construct->m_Data.data(), construct->m_Data.size());
+            construct->SetCPUMemoryUsage(construct->m_Data.size());
+
+            // Without storage the texture was decoded on a job thread and the pixels are uploaded later
+            if (construct->m_textureID != 0)
+                construct->SetData(construct->m_Data.data(), construct->m_Data.size());
         }
+
+        void CreateStorage();
+
+        /**
+         * @brief Reads back the pixels from the cache if they were released.
+         * @return True if the texture has its pixels.
+         */
+        bool RestoreCPUData() const;
+
+        /**
+         * @brief Reads the released pixels from the cache, reusing a previous read while a buffer still refers
+         * to it. Called with the CPU data mutex locked.
+         * @return A CPU only copy of the texture, nullptr if the cache cannot give the pixels back.
+         */
+        Ref<const Texture2D> ReadBackCPUData() const;
     private:
         TextureProperties m_Properties;
-        std::vector<unsigned char> m_Data;
-        uint32_t m_textureID;
-        int m_Width, m_Height;
+        mutable CacheBuffer<unsigned char> m_Data;
+        uint32_t m_textureID = 0;
+        int m_Width = 0, m_Height = 0;
+
+        mutable std::atomic<bool> m_CPUDataReleased = false; ///< Whether the pixels were released.
+        mutable std::mutex m_CPUDataMutex; ///< Guards releasing and reloading the pixels.
+        mutable std::weak_ptr<const Texture2D> m_ReadBack; ///< The last pixels read back, alive while a buffer refers to them.
     };
 
     class Cubemap : public Texture
@@ -149,20 +197,38 @@ namespace Coffee {
         uint32_t GetHeight() override { return m_Height; };
         ImageFormat GetImageFormat() override { return m_Properties.Format; };
 
+        /**
+         * @brief Creates the cube map texture if the cubemap was read without its GPU objects.
+         */
+        void Upload() override;
+
+        /**
+         * @brief Releases the pixels once uploaded, or the texture of a CPU only cubemap.
+         */
+        void ApplyResidency() override;
+
         static Ref<Cubemap> Load(const std::filesystem::path& path);
         static Ref<Cubemap> Create(const std::filesystem::path& path);
     private:
+        bool IsHDR() const;
+
+        /**
+         * @brief Reads back the pixels from the cache if they were released.
+         * @return True if the cubemap has its pixels.
+         */
+        bool RestoreCPUData() const;
 
         void LoadStandardFromFile(const std::filesystem::path& path);
         void LoadHDRFromFile(const std::filesystem::path& path);
-        void LoadStandardFromData(const std::vector<unsigned char>& data);
-        void LoadHDRFromData(const std::vector<float>& data);
+        void LoadStandardFromData(const CacheBuffer<unsigned char>& data);
+        void LoadHDRFromData(const CacheBuffer<float>& data);
 
         friend class cereal::access;
 
         template<class Archive>
         void save(Archive& archive) const
         {
+            RestoreCPUData();
             archive(m_Properties, m_Data, m_HDRData, m_Width, m_Height, cereal::base_class<Texture>(this));
         }
 
@@ -180,23 +246,23 @@ namespace Coffee {
             data(construct->m_Properties, construct->m_Data, construct->m_HDRData, construct->m_Width, construct->m_Height,
                  cereal::base_class<Texture>(construct.ptr()));
 
-            const ImageFormat& format = construct->m_Properties.Format;
-            if (format == ImageFormat::R8 || format == ImageFormat::RG8 || format == ImageFormat::RGB8 || format == ImageFormat::RGBA8)
-            {
-                construct->LoadStandardFromData(construct->m_Data);
-            }
-            else
+            construct->SetCPUMemoryUsage(construct->m_Data.size() + construct->m_HDRData.size() * sizeof(float));
+
+            if (UploadQueue::CanUploadNow())
             {
-                construct->LoadHDRFromData(construct->m_HDRData);
+                construct->Upload();
             }
         }
 
     private:
         TextureProperties m_Properties;
-        std::vector<unsigned char> m_Data;
-        std::vector<float> m_HDRData;
-        uint32_t m_textureID;
-        int m_Width, m_Height;
+        mutable CacheBuffer<unsigned char> m_Data;
+        mutable CacheBuffer<float> m_HDRData;
+        uint32_t m_textureID = 0;
+        int m_Width = 0, m_Height = 0;
+
+        mutable std::atomic<bool> m_CPUDataReleased = false; ///< Whether the pixels were released.
+        mutable std::mutex m_CPUDataMutex; ///< Guards releasing and reloading the pixels.
     };
 
 }
@@ -0,0 +1,108 @@
+#include "UploadQueue.h"
+#include "CoffeeEngine/Core/Assert.h"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <tracy/Tracy.hpp>
+
+namespace Coffee {
+
+    float UploadQueue::s_FrameBudget = 2.0f;
+
+    static std::thread::id s_MainThread;
+    static std::deque<UploadQueue::Upload> s_Uploads;
+    static std::mutex s_UploadMutex;
+    static thread_local uint32_t s_DeferDepth = 0;
+
+    void UploadQueue::Init()
+    {
+        s_MainThread = std::this_thread::get_id();
+    }
+
+    bool UploadQueue::IsMainThread()
+    {
+        return s_MainThread == std::thread::id() || s_MainThread == std::this_thread::get_id();
+    }
+
+    bool UploadQueue::CanUploadNow()
+    {
+        return s_DeferDepth == 0 && IsMainThread();
+    }
+
+    UploadQueue::DeferScope::DeferScope()
+    {
+        ++s_DeferDepth;
+    }
+
+    UploadQueue::DeferScope::~DeferScope()
+    {
+        --s_DeferDepth;
+    }
+
+    void UploadQueue::Submit(Upload upload)
+    {
+        if (IsMainThread())
+        {
+            upload();
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(s_UploadMutex);
+        s_Uploads.push_back(std::move(upload));
+    }
+
+    void UploadQueue::Flush()
+    {
+        ZoneScoped;
+
+        COFFEE_CORE_ASSERT(IsMainThread(), "UploadQueue::Flush must be called from the main thread");
+
+        // Uploads can load resources that submit more uploads, those run inline on this thread
+        std::deque<Upload> uploads;
+        {
+            std::lock_guard<std::mutex> lock(s_UploadMutex);
+            uploads.swap(s_Uploads);
+        }
+
+        for (Upload& upload : uploads)
+        {
+            upload();
+        }
+    }
+
+    void UploadQueue::Flush(float budget)
+    {
+        ZoneScoped;
+
+        COFFEE_CORE_ASSERT(IsMainThread(), "UploadQueue::Flush must be called from the main thread");
+
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point deadline =
+            Clock::now() + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(budget));
+
+        // One at a time, the uploads left over wait for the next frame
+        do
+        {
+            Upload upload;
+            {
+                std::lock_guard<std::mutex> lock(s_UploadMutex);
+                if (s_Uploads.empty())
+                    return;
+
+                upload = std::move(s_Uploads.front());
+                s_Uploads.pop_front();
+            }
+
+            upload();
+        } while (Clock::now() < deadline);
+    }
+
+    uint32_t UploadQueue::GetPendingCount()
+    {
+        std::lock_guard<std::mutex> lock(s_UploadMutex);
+        return static_cast<uint32_t>(s_Uploads.size());
+    }
+
+}
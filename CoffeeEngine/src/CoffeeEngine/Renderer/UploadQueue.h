@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+namespace Coffee {
+
+    /**
+     * @defgroup renderer Renderer
+     * @{
+     */
+
+    /**
+     * @brief Queue of GPU work that has to run on the main thread, where the graphics context is current.
+     *
+     * Resources decoded on job threads keep their CPU data and submit the creation of their GPU objects here.
+     * The main thread runs the queued uploads in submission order, so a resource is uploaded after the
+     * resources it was loaded with.
+     */
+    class UploadQueue
+    {
+    public:
+        using Upload = std::function<void()>;
+
+        /**
+         * @brief Marks the calling thread as the main thread. Until then every thread is considered the main
+         * thread.
+         */
+        static void Init();
+
+        /**
+         * @brief Checks whether the calling thread owns the graphics context.
+         * @return True on the main thread.
+         */
+        static bool IsMainThread();
+
+        /**
+         * @brief Checks whether resources created on the calling thread create their GPU objects right away.
+         * @return True on the main thread outside of a DeferScope.
+         */
+        static bool CanUploadNow();
+
+        /**
+         * @brief While alive, resources created on the calling thread leave the creation of their GPU objects
+         * to Resource::Upload, as they do on job threads. Used to read the CPU data of a resource back from
+         * the cache.
+         */
+        class DeferScope
+        {
+        public:
+            DeferScope();
+            ~DeferScope();
+
+            DeferScope(const DeferScope&) = delete;
+            DeferScope& operator=(const DeferScope&) = delete;
+        };
+
+        /**
+         * @brief Queues an upload, or runs it right away when called from the main thread.
+         * @param upload The upload to run.
+         */
+        static void Submit(Upload upload);
+
+        /**
+         * @brief Runs every queued upload. Main thread only.
+         */
+        static void Flush();
+
+        /**
+         * @brief Runs queued uploads until the time budget is spent, at least one. Main thread only.
+         * @param budget The time budget in milliseconds.
+         */
+        static void Flush(float budget);
+
+        /**
+         * @brief Sets the time the application spends on uploads every frame.
+         * @param budget The time budget in milliseconds.
+         */
+        static void SetFrameBudget(float budget) { s_FrameBudget = budget; }
+
+        /**
+         * @brief Gets the time the application spends on uploads every frame.
+         * @return The time budget in milliseconds.
+         */
+        static float GetFrameBudget() { return s_FrameBudget; }
+
+        /**
+         * @brief Gets the number of uploads waiting for the main thread.
+         * @return The pending upload count.
+         */
+        static uint32_t GetPendingCount();
+
+    private:
+        static float s_FrameBudget; ///< Milliseconds of uploads per frame.
+    };
+
+    /** @} */
+}
@@ -11,6 +11,7 @@
 #include "CoffeeEngine/Scene/SceneCamera.h"
 #include "src/CoffeeEngine/IO/Serialization/GLMSerialization.h"
 #include <cereal/access.hpp>
+#include <cereal/archives/json.hpp>
 #include <cereal/cereal.hpp>
 #include <cereal/types/string.hpp>
 #include <glm/ext/matrix_transform.hpp>
@@ -53,13 +54,30 @@ namespace Coffee
     {
       private:
         glm::mat4 worldMatrix = glm::mat4(1.0f); ///< The world transformation matrix.
+        glm::mat4 localMatrix = glm::mat4(1.0f); ///< The local matrix built from the cached values below.
+        glm::vec3 cachedPosition = {0.0f, 0.0f, 0.0f}; ///< The position the local matrix was built from.
+        glm::vec3 cachedRotation = {0.0f, 0.0f, 0.0f}; ///< The rotation the local matrix was built from.
+        glm::vec3 cachedScale = {1.0f, 1.0f, 1.0f};    ///< The scale the local matrix was built from.
+        bool dirty = true; ///< Flag forcing the world transform to be recomputed.
       public:
         glm::vec3 Position = {0.0f, 0.0f, 0.0f}; ///< The position vector.
         glm::vec3 Rotation = {0.0f, 0.0f, 0.0f}; ///< The rotation vector.
         glm::vec3 Scale = {1.0f, 1.0f, 1.0f};    ///< The scale vector.
 
         TransformComponent() = default;
-        TransformComponent(const TransformComponent&) = default;
+        TransformComponent(const TransformComponent& other)
+            : Position(other.Position), Rotation(other.Rotation), Scale(other.Scale)
+        {
+            // The copy may live under a different parent, its world transform has to be recomputed
+        }
+        TransformComponent& operator=(const TransformComponent& other)
+        {
+            Position = other.Position;
+            Rotation = other.Rotation;
+            Scale = other.Scale;
+            dirty = true;
+            return *this;
+        }
         TransformComponent(const glm::vec3& position) : Position(position) {}
 
         /**
@@ -68,6 +86,9 @@ namespace Coffee
          */
         glm::mat4 GetLocalTransform() const
         {
+            if (!IsDirty())
+                return localMatrix;
+
             glm::mat4 rotation = glm::toMat4(glm::quat(glm::radians(Rotation)));
 
             return glm::translate(glm::mat4(1.0f), Position) * rotation * glm::scale(glm::mat4(1.0f), Scale);
@@ -86,6 +107,7 @@ namespace Coffee
 
             glm::decompose(transform, Scale, orientation, Position, skew, perspective);
             Rotation = glm::degrees(glm::eulerAngles(orientation));
+            dirty = true;
         }
 
         /**
@@ -96,9 +118,39 @@ namespace Coffee
 
         /**
          * @brief Sets the world transformation matrix.
-         * @param transform The transformation matrix to set.
+         * @param transform The world transformation matrix of the parent.
+         */
+        void SetWorldTransform(const glm::mat4& transform)
+        {
+            if (IsDirty())
+            {
+                localMatrix = GetLocalTransform();
+                cachedPosition = Position;
+                cachedRotation = Rotation;
+                cachedScale = Scale;
+            }
+
+            worldMatrix = transform * localMatrix;
+            dirty = false;
+        }
+
+        /**
+         * @brief Checks if the world transform is out of date.
+         *
+         * Position, Rotation and Scale are written directly by the editor and the scripts, so besides the explicit
+         * flag they are compared against the values the local matrix was last built from.
+         *
+         * @return True if the transform changed since the last SetWorldTransform.
+         */
+        bool IsDirty() const
+        {
+            return dirty || Position != cachedPosition || Rotation != cachedRotation || Scale != cachedScale;
+        }
+
+        /**
+         * @brief Forces the world transform to be recomputed on the next scene tree update.
          */
-        void SetWorldTransform(const glm::mat4& transform) { worldMatrix = transform * GetLocalTransform(); }
+        void MarkDirty() { dirty = true; }
 
         /**
          * @brief Serializes the TransformComponent.
@@ -139,6 +191,8 @@ namespace Coffee
     {
         Ref<Mesh> mesh;        ///< The mesh reference.
         bool drawAABB = false; ///< Flag to draw the axis-aligned bounding box (AABB).
+        bool isOccluder = false; ///< Flag to rasterize the mesh in the software occlusion culling pass.
+        AABB worldAABB; ///< World space bounds, refreshed by the scene when the mesh or the transform changes.
 
         MeshComponent()
         {
@@ -164,7 +218,7 @@ namespace Coffee
          */
         template <class Archive> void save(Archive& archive) const
         {
-            archive(cereal::make_nvp("Mesh", mesh->GetUUID()));
+            archive(cereal::make_nvp("Mesh", mesh ? mesh->GetUUID() : UUID::null), cereal::make_nvp("Occluder", isOccluder));
         }
 
         template <class Archive> void load(Archive& archive)
@@ -172,7 +226,25 @@ namespace Coffee
             UUID meshUUID;
             archive(cereal::make_nvp("Mesh", meshUUID));
 
-            Ref<Mesh> mesh = ResourceRegistry::Get<Mesh>(meshUUID);
+            // Scenes saved before occluders existed do not have the field
+            if constexpr (std::is_same_v<Archive, cereal::JSONInputArchive>)
+            {
+                try
+                {
+                    archive(cereal::make_nvp("Occluder", isOccluder));
+                }
+                catch (const cereal::Exception&)
+                {
+                    isOccluder = false;
+                }
+            }
+            else
+            {
+                archive(cereal::make_nvp("Occluder", isOccluder));
+            }
+
+            // Imported here if the scene did not preload it
+            Ref<Mesh> mesh = ResourceLoader::LoadMesh(meshUUID);
             this->mesh = mesh;
         }
     };
@@ -204,7 +276,7 @@ namespace Coffee
          */
         template <class Archive> void save(Archive& archive) const
         {
-            archive(cereal::make_nvp("Material", material->GetUUID()));
+            archive(cereal::make_nvp("Material", material ? material->GetUUID() : UUID::null));
         }
 
         template <class Archive> void load(Archive& archive)
@@ -212,7 +284,7 @@ namespace Coffee
             UUID materialUUID;
             archive(cereal::make_nvp("Material", materialUUID));
 
-            Ref<Material> material = ResourceRegistry::Get<Material>(materialUUID);
+            Ref<Material> material = ResourceLoader::LoadMaterial(materialUUID);
             this->material = material;
         }
     };
@@ -6,6 +6,7 @@
 #include "entt/entity/entity.hpp"
 #include "entt/entity/fwd.hpp"
 #include <cstdint>
+#include <span>
 #include <utility>
 
 namespace Coffee {
@@ -134,6 +135,23 @@ namespace Coffee {
            HierarchyComponent::Reparent(m_Scene->m_Registry, m_EntityHandle, entity);
         }
 
+        /**
+         * @brief Append several entities at the end of the children of the entity.
+         * @param children The entities to attach, in order.
+         */
+        void AddChildren(std::span<const entt::entity> children)
+        {
+            HierarchyComponent::AttachChildren(m_Scene->m_Registry, m_EntityHandle, children);
+        }
+
+        /**
+         * @brief Detach all the children of the entity, turning them into roots.
+         */
+        void DetachChildren()
+        {
+            HierarchyComponent::DetachChildren(m_Scene->m_Registry, m_EntityHandle);
+        }
+
     private:
         entt::entity m_EntityHandle{ entt::null };
         Scene* m_Scene = nullptr;
@@ -216,53 +216,49 @@ namespace Coffee
         //COFFEE_CORE_INFO("Alive particles: {}", AliveParticleCount);
     }
 
-void ParticleSystemComponent::Render(const glm::vec3& cameraPosition, const glm::vec3& cameraUp)
+void ParticleSystemComponent::Render(uint32_t entityID)
     {
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-        std::vector<RenderCommand> renderCommands;
-
-        std::sort(renderCommands.begin(), renderCommands.end(), [&](const RenderCommand& a, const RenderCommand& b) {
-            float distA = glm::length(a.transform[3] - glm::vec4(cameraPosition, 1.0f));
-            float distB = glm::length(b.transform[3] - glm::vec4(cameraPosition, 1.0f));
-            return distA > distB;
-        });
-
         if (ParticleTexture)
         {
             ParticleMaterial->GetMaterialTextures().albedo = ParticleTexture;
         }
 
+        // The billboard renderer sorts and batches the particles of every system at the end of the scene
         for (const auto& particle : Particles)
         {
             if (particle.Age < particle.LifeTime && particle.Billboard)
             {
-                glm::mat4 transform = particle.Billboard->CalculateTransform(cameraPosition, cameraUp);
-                transform = glm::rotate(transform, particle.LocalRotation, glm::vec3(0, 0, 1));
                 particle.Billboard->SetScale(glm::vec3(particle.Size));
                 particle.Billboard->SetColor(particle.Color);
-                renderCommands.push_back({
-                    transform,        // Transformación del Billboard
-                    ParticleMesh,     // Malla de la partícula
-                    ParticleMaterial, // Material de la partícula
-                    0                 // Entity ID (opcional)
-                });
+                particle.Billboard->SetRotation(particle.LocalRotation);
+                BillboardRenderer::Submit(particle.Billboard, ParticleMaterial, entityID);
             }
             else if (!particle.Billboard)
             {
                 COFFEE_CORE_ERROR("Particle has no valid Billboard during render.");
             }
         }
+    }
 
-        // Enviar comandos al renderer
-        for (const auto& command : renderCommands)
+    void ParticleSystemComponent::CopyResources()
+    {
+        // An unnamed material gets a unique name, a named one would be the registered original again
+        if (ParticleMaterial)
         {
-            Renderer::Submit(command);
+            MaterialTextures textures = ParticleMaterial->GetMaterialTextures();
+            Ref<Material> material = Material::Create("", &textures);
+            material->GetMaterialProperties() = ParticleMaterial->GetMaterialProperties();
+            ParticleMaterial = material;
         }
 
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        for (Particle& particle : Particles)
+        {
+            if (particle.Billboard)
+            {
+                particle.Billboard = CreateRef<Billboard>(*particle.Billboard);
+                particle.Billboard->SetMaterial(ParticleMaterial);
+            }
+        }
     }
 
 
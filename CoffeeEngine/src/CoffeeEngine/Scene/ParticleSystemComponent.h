@@ -138,7 +138,13 @@ namespace Coffee
 
         // Métodos principales
         void Update(float deltaTime);
-        void Render(const glm::vec3& cameraPosition, const glm::vec3& cameraUp);
+        void Render(uint32_t entityID);
+
+        /**
+         * @brief Replaces the billboards of the particles and the particle material with copies of their own, so
+         * a copied component can be edited without changing the original. Used by Scene::Clone.
+         */
+        void CopyResources();
 
         // Configuración del emisor
         glm::vec3 LocalEmitterPosition = {0.0f, 0.0f, 0.0f};
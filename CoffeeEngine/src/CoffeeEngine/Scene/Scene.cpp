@@ -1,13 +1,18 @@
 ﻿#include "Scene.h"
 
+#include "CoffeeEngine/Core/Assert.h"
 #include "CoffeeEngine/Core/Base.h"
 #include "CoffeeEngine/Core/DataStructures/Octree.h"
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/IO/MappedFile.h"
+#include "CoffeeEngine/IO/ResourceLoader.h"
 #include "CoffeeEngine/Math/Frustum.h"
 #include "CoffeeEngine/Renderer/DebugRenderer.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
 #include "CoffeeEngine/Renderer/Material.h"
 #include "CoffeeEngine/Renderer/Mesh.h"
 #include "CoffeeEngine/Renderer/Renderer.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
 #include "CoffeeEngine/Scene/Components.h"
 #include "CoffeeEngine/Scene/Entity.h"
 #include "CoffeeEngine/Scene/PrimitiveMesh.h"
@@ -19,22 +24,286 @@
 #include "entt/entity/fwd.hpp"
 #include "entt/entity/snapshot.hpp"
 
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <glm/detail/type_quat.hpp>
 #include <glm/fwd.hpp>
+#include <sstream>
 #include <string>
 #include <tracy/Tracy.hpp>
+#include <vector>
 
 #include <CoffeeEngine/Scripting/Script.h>
+#include <cereal/archives/binary.hpp>
 #include <cereal/archives/json.hpp>
+#include <cereal/types/vector.hpp>
+#include <cstring>
 #include <fstream>
 
 namespace Coffee {
 
+    // Minimum number of entities a worker processes when building render commands
+    static constexpr uint32_t RenderCommandChunkSize = 1024;
+
+    // Minimum number of boxes a worker transforms when refreshing the world bounds
+    static constexpr uint32_t BoundsChunkSize = 1024;
+
+    static std::vector<entt::entity> s_MeshEntities;
+    static std::vector<ObjectContainer<entt::entity>> s_VisibleMeshes;
+    static std::vector<OctreeRayHit<entt::entity>> s_RayCandidates;
+    static std::vector<RenderQueue> s_ChunkQueues;
+
+    // Scratch arrays of the world bounds refresh
+    static std::vector<entt::entity> s_BoundsEntities;
+    static std::vector<AABB> s_LocalBounds;
+    static std::vector<glm::mat4> s_BoundsTransforms;
+    static std::vector<AABB> s_WorldBounds;
+
     Scene::Scene() : m_Octree({glm::vec3(-50.0f), glm::vec3(50.0f)}, 10, 5)
     {
         m_SceneTree = CreateScope<SceneTree>(this);
+
+        // Keep the octree in sync with the mesh entities
+        m_Registry.on_construct<MeshComponent>().connect<&Scene::OnMeshChanged>(*this);
+        m_Registry.on_update<MeshComponent>().connect<&Scene::OnMeshChanged>(*this);
+        m_Registry.on_destroy<MeshComponent>().connect<&Scene::OnMeshDestroyed>(*this);
+        m_SceneTree->OnTransformChanged().connect<&Scene::OnTransformChanged>(*this);
+    }
+
+    Scene::~Scene()
+    {
+        m_Registry.on_construct<MeshComponent>().disconnect(*this);
+        m_Registry.on_update<MeshComponent>().disconnect(*this);
+        m_Registry.on_destroy<MeshComponent>().disconnect(*this);
+
+        if (LuaBackend::GetActiveScene() == this)
+        {
+            LuaBackend::SetActiveScene(nullptr);
+        }
+    }
+
+    void Scene::UpdateWorldBounds()
+    {
+        ZoneScoped;
+
+        if (m_PendingBounds.empty())
+            return;
+
+        // An entity can be queued by both its mesh and its transform in the same frame
+        std::sort(m_PendingBounds.begin(), m_PendingBounds.end());
+        m_PendingBounds.erase(std::unique(m_PendingBounds.begin(), m_PendingBounds.end()), m_PendingBounds.end());
+
+        s_BoundsEntities.clear();
+        s_LocalBounds.clear();
+        s_BoundsTransforms.clear();
+
+        for (auto entity : m_PendingBounds)
+        {
+            if (!m_Registry.valid(entity) || !m_Registry.all_of<MeshComponent, TransformComponent>(entity))
+                continue;
+
+            auto& meshComponent = m_Registry.get<MeshComponent>(entity);
+            if (!meshComponent.mesh)
+            {
+                meshComponent.worldAABB = AABB();
+                m_Octree.Remove(entity);
+                continue;
+            }
+
+            s_BoundsEntities.push_back(entity);
+            s_LocalBounds.push_back(meshComponent.mesh->GetAABB());
+            s_BoundsTransforms.push_back(m_Registry.get<TransformComponent>(entity).GetWorldTransform());
+        }
+
+        m_PendingBounds.clear();
+
+        const uint32_t count = static_cast<uint32_t>(s_BoundsEntities.size());
+        s_WorldBounds.resize(count);
+
+        JobSystem::ParallelFor(count, BoundsChunkSize, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+            TransformAABBs(s_LocalBounds.data() + begin, s_BoundsTransforms.data() + begin, s_WorldBounds.data() + begin, end - begin);
+        });
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            m_Registry.get<MeshComponent>(s_BoundsEntities[i]).worldAABB = s_WorldBounds[i];
+            m_Octree.Update(s_BoundsEntities[i], s_WorldBounds[i]);
+        }
+    }
+
+    void Scene::RebuildOctree()
+    {
+        ZoneScoped;
+
+        m_Octree.Clear();
+
+        auto view = m_Registry.view<MeshComponent, TransformComponent>();
+        m_PendingBounds.assign(view.begin(), view.end());
+
+        UpdateWorldBounds();
+    }
+
+    void Scene::OnMeshChanged(entt::registry& registry, entt::entity entity)
+    {
+        m_PendingBounds.push_back(entity);
+    }
+
+    void Scene::OnMeshDestroyed(entt::registry& registry, entt::entity entity)
+    {
+        m_Octree.Remove(entity);
+    }
+
+    void Scene::OnTransformChanged(entt::registry& registry, entt::entity entity)
+    {
+        if (registry.all_of<MeshComponent>(entity))
+        {
+            m_PendingBounds.push_back(entity);
+        }
+    }
+
+    /**
+     * @brief Intersects a ray with the triangles of a mesh.
+     * @return True if a triangle is hit before maxDistance, the distance is in units of the world ray.
+     */
+    static bool RaycastMesh(const Mesh& mesh, const glm::mat4& transform, const Ray& ray, float maxDistance, float& distance)
+    {
+        // Held for the duration of the test, even if the mesh releases its data meanwhile
+        const CacheBuffer<Vertex> vertices = mesh.GetVertices();
+        const CacheBuffer<uint32_t> indices = mesh.GetIndices();
+
+        // The local ray keeps the parametrization of the world ray, so its distances need no conversion
+        const Ray localRay = ray.Transform(glm::inverse(transform));
+
+        bool hit = false;
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+        {
+            float triangleDistance;
+            if (localRay.Intersect(vertices[indices[i]].Position, vertices[indices[i + 1]].Position,
+                                   vertices[indices[i + 2]].Position, maxDistance, triangleDistance))
+            {
+                maxDistance = triangleDistance;
+                distance = triangleDistance;
+                hit = true;
+            }
+        }
+
+        return hit;
+    }
+
+    bool Scene::Raycast(const Ray& ray, RaycastHit& hit, float maxDistance) const
+    {
+        ZoneScoped;
+
+        s_RayCandidates.clear();
+        m_Octree.Raycast(ray, maxDistance, s_RayCandidates);
+
+        bool found = false;
+        for (const auto& candidate : s_RayCandidates)
+        {
+            // Sorted by the distance to the bounds, nothing farther can beat the current hit
+            if (candidate.distance > maxDistance)
+                break;
+
+            const auto& meshComponent = m_Registry.get<MeshComponent>(candidate.object);
+            const auto& transformComponent = m_Registry.get<TransformComponent>(candidate.object);
+
+            float distance;
+            if (RaycastMesh(*meshComponent.mesh, transformComponent.GetWorldTransform(), ray, maxDistance, distance))
+            {
+                maxDistance = distance;
+                hit = {candidate.object, distance, ray.GetPoint(distance)};
+                found = true;
+            }
+        }
+
+        return found;
+    }
+
+    std::vector<RaycastHit> Scene::RaycastAll(const Ray& ray, float maxDistance) const
+    {
+        ZoneScoped;
+
+        s_RayCandidates.clear();
+        m_Octree.Raycast(ray, maxDistance, s_RayCandidates);
+
+        std::vector<RaycastHit> hits;
+        for (const auto& candidate : s_RayCandidates)
+        {
+            const auto& meshComponent = m_Registry.get<MeshComponent>(candidate.object);
+            const auto& transformComponent = m_Registry.get<TransformComponent>(candidate.object);
+
+            float distance;
+            if (RaycastMesh(*meshComponent.mesh, transformComponent.GetWorldTransform(), ray, maxDistance, distance))
+            {
+                hits.push_back({candidate.object, distance, ray.GetPoint(distance)});
+            }
+        }
+
+        std::sort(hits.begin(), hits.end(), [](const RaycastHit& a, const RaycastHit& b) { return a.distance < b.distance; });
+        return hits;
+    }
+
+    bool Scene::RaycastProxies(const Ray& ray, RaycastHit& hit, float proxySize, float maxDistance) const
+    {
+        ZoneScoped;
+
+        bool found = false;
+        auto test = [&](entt::entity entity, const glm::vec3& center, float size) {
+            float distance;
+            if (ray.Intersect(AABB(center - glm::vec3(size * 0.5f), center + glm::vec3(size * 0.5f)), maxDistance, distance))
+            {
+                maxDistance = distance;
+                hit = {entity, distance, ray.GetPoint(distance)};
+                found = true;
+            }
+        };
+
+        for (auto [entity, light, transform] : m_Registry.view<const LightComponent, const TransformComponent>().each())
+        {
+            test(entity, glm::vec3(transform.GetWorldTransform()[3]), proxySize);
+        }
+
+        for (auto [entity, camera, transform] : m_Registry.view<const CameraComponent, const TransformComponent>().each())
+        {
+            test(entity, glm::vec3(transform.GetWorldTransform()[3]), proxySize);
+        }
+
+        for (auto [entity, particleSystem] : m_Registry.view<const ParticleSystemComponent>().each())
+        {
+            for (const ParticleSystemComponent::Particle& particle : particleSystem.Particles)
+            {
+                if (particle.Age < particle.LifeTime && particle.Billboard)
+                    test(entity, particle.Billboard->GetPosition(), particle.Size);
+            }
+        }
+
+        return found;
+    }
+
+    void Scene::CullViews(std::span<const Frustum> views, OctreeViewResults<entt::entity>& results) const
+    {
+        ZoneScoped;
+
+        m_Octree.QueryViews(views.data(), static_cast<uint32_t>(views.size()), results);
+    }
+
+    std::vector<entt::entity> Scene::OverlapSphere(const glm::vec3& center, float radius) const
+    {
+        ZoneScoped;
+
+        std::vector<entt::entity> entities;
+        m_Octree.Query(center, radius, [&](entt::entity entity, const AABB&) { entities.push_back(entity); });
+        return entities;
+    }
+
+    std::vector<entt::entity> Scene::OverlapBox(const AABB& aabb) const
+    {
+        ZoneScoped;
+
+        std::vector<entt::entity> entities;
+        m_Octree.Query(aabb, [&](entt::entity entity, const AABB&) { entities.push_back(entity); });
+        return entities;
     }
 
 /*     Scene::Scene(Ref<Scene> other)
@@ -60,17 +329,23 @@ namespace Coffee {
 
     void Scene::DestroyEntity(Entity entity)
     {
-        auto& hierarchyComponent = m_Registry.get<HierarchyComponent>(entity);
-        auto curr = hierarchyComponent.m_First;
+        ZoneScoped;
 
-        while(curr != entt::null)
+        // Gather the whole subtree breadth-first instead of recursing, deep hierarchies would overflow the stack
+        std::vector<entt::entity> entities = {(entt::entity)entity};
+        for(size_t i = 0; i < entities.size(); ++i)
         {
-            Entity e{curr, this};
-            curr = m_Registry.get<HierarchyComponent>(curr).m_Next;
-            DestroyEntity(e);
+            auto& hierarchyComponent = m_Registry.get<HierarchyComponent>(entities[i]);
+            entities.reserve(entities.size() + hierarchyComponent.m_ChildCount);
+
+            for(auto child = hierarchyComponent.m_First; child != entt::null; child = m_Registry.get<HierarchyComponent>(child).m_Next)
+            {
+                entities.push_back(child);
+            }
         }
 
-        m_Registry.destroy((entt::entity)entity);
+        // Deepest first, so every entity is unlinked while its parent still exists
+        m_Registry.destroy(entities.rbegin(), entities.rend());
     }
 
     void Scene::OnInitEditor()
@@ -95,19 +370,13 @@ namespace Coffee {
     {
         ZoneScoped;
 
+        // The octree follows the transforms from here on
         m_SceneTree->Update();
+        UpdateWorldBounds();
 
-        auto view = m_Registry.view<MeshComponent>();
+        // The spatial queries of the scripts run on this scene
+        LuaBackend::SetActiveScene(this);
 
-        for (auto& entity : view)
-        {
-            auto& meshComponent = view.get<MeshComponent>(entity);
-            auto& transformComponent = m_Registry.get<TransformComponent>(entity);
-
-            ObjectContainer<Ref<Mesh>> objectContainer = {transformComponent.GetWorldTransform(), meshComponent.GetMesh()->GetAABB(), meshComponent.GetMesh()};
-
-            m_Octree.Insert(objectContainer);
-        }
         auto particleView = m_Registry.view<ParticleSystemComponent>();
         for (auto entity : particleView)
         {
@@ -133,17 +402,59 @@ namespace Coffee {
             // Actualizar el sistema de partículas
             particleSystem.Update(dt);
 
-            // Renderizar las partículas con la información de la cámara
-            particleSystem.Render(cameraPosition, cameraUp);
+            // Enviar las partículas al renderer de billboards
+            particleSystem.Render((uint32_t)entity);
         }
     }
 
 
+    uint32_t Scene::BuildRenderCommands(entt::registry& registry, std::span<const entt::entity> entities,
+                                        std::vector<RenderQueue>& chunkQueues)
+    {
+        ZoneScoped;
+
+        auto view = registry.view<MeshComponent, TransformComponent>();
+        auto materialView = registry.view<MaterialComponent>();
+
+        const uint32_t meshCount = static_cast<uint32_t>(entities.size());
+        const uint32_t chunkCount = JobSystem::GetChunkCount(meshCount, RenderCommandChunkSize);
+        if (chunkQueues.size() < chunkCount)
+        {
+            chunkQueues.resize(chunkCount);
+        }
+
+        JobSystem::ParallelFor(meshCount, RenderCommandChunkSize, [&](uint32_t begin, uint32_t end, uint32_t chunk) {
+            ZoneScopedN("BuildRenderCommands");
+
+            RenderQueue& queue = chunkQueues[chunk];
+            queue.Reset();
+
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                entt::entity entity = entities[i];
+
+                // Get the ModelComponent and TransformComponent for the current entity
+                auto& meshComponent = view.get<MeshComponent>(entity);
+                auto& transformComponent = view.get<TransformComponent>(entity);
+
+                Mesh* mesh = meshComponent.GetMesh().get();
+                Material* material = materialView.contains(entity)
+                                         ? materialView.get<MaterialComponent>(entity).material.get()
+                                         : nullptr;
+
+                queue.Push(RenderCommand{transformComponent.GetWorldTransform(), mesh, material, (uint32_t)entity});
+            }
+        });
+
+        return chunkCount;
+    }
+
     void Scene::OnUpdateEditor(EditorCamera& camera, float dt)
     {
         ZoneScoped;
 
         m_SceneTree->Update();
+        UpdateWorldBounds();
 
         Renderer::BeginScene(camera);
         BillboardRenderer::BeginScene(camera.GetViewProjection(), camera.GetPosition(),camera.GetUpDirection());
@@ -151,21 +462,16 @@ namespace Coffee {
         // TEST ------------------------------
         m_Octree.DebugDraw();
 
-        // Get all entities with ModelComponent and TransformComponent
-        auto view = m_Registry.view<MeshComponent, TransformComponent>();
-
-        // Loop through each entity with the specified components
-        for (auto& entity : view)
-        {
-            // Get the ModelComponent and TransformComponent for the current entity
-            auto& meshComponent = view.get<MeshComponent>(entity);
-            auto& transformComponent = view.get<TransformComponent>(entity);
-            auto materialComponent = m_Registry.try_get<MaterialComponent>(entity);
+        // Get the mesh entities inside the camera frustum
+        s_MeshEntities.clear();
+        m_Octree.Query(Frustum(camera.GetViewProjection()), [](entt::entity entity, const AABB&) { s_MeshEntities.push_back(entity); });
 
-            Ref<Mesh> mesh = meshComponent.GetMesh();
-            Ref<Material> material = (materialComponent) ? materialComponent->material : nullptr;
+        const uint32_t chunkCount = BuildRenderCommands(m_Registry, s_MeshEntities, s_ChunkQueues);
 
-            Renderer::Submit(RenderCommand{transformComponent.GetWorldTransform(), mesh, material, (uint32_t)entity});
+        // Merge in chunk order so the submission order matches the view order
+        for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            Renderer::Submit(s_ChunkQueues[chunk]);
         }
 
         // Get all entities with LightComponent and TransformComponent
@@ -186,7 +492,6 @@ namespace Coffee {
          // Renderizar partículas
         UpdateParticles(dt, camera.GetViewProjection(), camera.GetPosition(), camera.GetUpDirection());
 
-        BillboardRenderer::EndScene();
         Renderer::EndScene();
     }
 
@@ -196,6 +501,7 @@ namespace Coffee {
         ZoneScoped;
 
         m_SceneTree->Update();
+        UpdateWorldBounds();
 
         //// Procesar sistemas de part�culas
         //auto particleView = m_Registry.view<ParticleSystemComponent>();
@@ -217,18 +523,19 @@ namespace Coffee {
             cameraTransform = transform.GetWorldTransform();
         }
 
+        SceneCamera defaultCamera;
         if (!camera)
         {
             COFFEE_ERROR("No camera entity found!");
 
-            SceneCamera sceneCamera;
-            camera = &sceneCamera;
+            camera = &defaultCamera;
 
             cameraTransform = glm::mat4(1.0f);
         }
 
         // Calcular las variables necesarias para el renderizado de partículas
         glm::mat4 viewProjection = camera->GetProjection() * glm::inverse(cameraTransform);
+        m_RuntimeViewProjection = viewProjection;
         glm::vec3 cameraPosition = glm::vec3(cameraTransform[3]);           // Posición de la cámara
         glm::vec3 cameraUp = glm::normalize(glm::vec3(cameraTransform[1])); // Dirección "arriba" de la cámara
 
@@ -244,11 +551,48 @@ namespace Coffee {
         Frustum frustum = Frustum(camera->GetProjection() /* testProjection */ * glm::inverse(cameraTransform));
         DebugRenderer::DrawFrustum(frustum, glm::vec4(1.0f), 1.0f);
 
-        auto meshes = m_Octree.Query(frustum);
+        // Only the rendered camera has a consumer, the other cameras are not culled until something draws them.
+        // A single view goes through the plain query, which keeps the planes each node still has to test
+        s_VisibleMeshes.clear();
+        m_Octree.Query(frustum, s_VisibleMeshes);
+        auto meshView = m_Registry.view<MeshComponent, TransformComponent>();
+        auto materialView = m_Registry.view<MaterialComponent>();
 
-        for (auto& mesh : meshes)
+        if (m_OcclusionCuller.IsEnabled())
         {
-            Renderer::Submit(RenderCommand{mesh.transform, mesh.object, mesh.object->GetMaterial(), 0});
+            m_OcclusionCuller.Begin(viewProjection);
+
+            auto occluderView = m_Registry.view<MeshComponent, TransformComponent>();
+            for (auto entity : occluderView)
+            {
+                auto [meshComponent, transformComponent] = occluderView.get<MeshComponent, TransformComponent>(entity);
+
+                if (meshComponent.isOccluder && meshComponent.mesh)
+                {
+                    m_OcclusionCuller.AddOccluder(*meshComponent.mesh, transformComponent.GetWorldTransform());
+                }
+            }
+
+            m_OcclusionCuller.Rasterize();
+        }
+
+        for (const auto& mesh : s_VisibleMeshes)
+        {
+
+            if (m_OcclusionCuller.IsEnabled() && !m_OcclusionCuller.IsVisible(mesh.aabb))
+                continue;
+
+            auto [meshComponent, transformComponent] = meshView.get<MeshComponent, TransformComponent>(mesh.object);
+            Material* material = materialView.contains(mesh.object)
+                                     ? materialView.get<MaterialComponent>(mesh.object).material.get()
+                                     : meshComponent.mesh->GetMaterial().get();
+
+            Renderer::Submit(RenderCommand{transformComponent.GetWorldTransform(), meshComponent.mesh.get(), material, (uint32_t)mesh.object});
+        }
+
+        if (m_OcclusionCuller.IsEnabled() && m_OcclusionCuller.IsDebugDrawEnabled())
+        {
+            m_OcclusionCuller.DebugDraw();
         }
 
         // Procesar luces
@@ -278,7 +622,6 @@ namespace Coffee {
         // Renderizar partículas
         UpdateParticles(dt, viewProjection, cameraPosition, cameraUp);
 
-        BillboardRenderer::EndScene();
         Renderer::EndScene();
     }
 
@@ -295,90 +638,436 @@ namespace Coffee {
 
     void Scene::OnExitRuntime()
     {
+        if (LuaBackend::GetActiveScene() == this)
+        {
+            LuaBackend::SetActiveScene(nullptr);
+        }
+    }
+
+    /**
+     * @brief Copies the components of every entity of one registry to the same entity of another.
+     */
+    template <typename... Components>
+    static void CopyComponents(entt::registry& source, entt::registry& destination)
+    {
+        ([&]() {
+            auto& storage = source.storage<Components>();
+            destination.storage<Components>().reserve(storage.size());
 
+            for (auto [entity, component] : storage.each())
+            {
+                destination.emplace<Components>(entity, component);
+            }
+        }(), ...);
     }
 
-    Ref<Scene> Scene::Load(const std::filesystem::path& path)
+    Ref<Scene> Scene::Clone(const Ref<Scene>& other)
     {
         ZoneScoped;
 
         Ref<Scene> scene = CreateRef<Scene>();
+        auto& source = other->m_Registry;
+        auto& destination = scene->m_Registry;
+
+        // Same identifiers and versions, the components store entity handles
+        for (auto entity : source.view<entt::entity>())
+        {
+            [[maybe_unused]] entt::entity created = destination.create(entity);
+            COFFEE_CORE_ASSERT(created == entity, "Cloned entity identifier mismatch");
+        }
 
-        std::ifstream sceneFile(path);
-        cereal::JSONInputArchive archive(sceneFile);
+        // The links are copied, appending the children again on construction would duplicate them
+        destination.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
 
-        entt::snapshot_loader{scene->m_Registry}
-            .get<entt::entity>(archive)
-            .get<TagComponent>(archive)
-            .get<TransformComponent>(archive)
-            .get<HierarchyComponent>(archive)
-            .get<CameraComponent>(archive)
-            .get<MeshComponent>(archive)
-            .get<MaterialComponent>(archive)
-            .get<LightComponent>(archive)
-            .get<ParticleSystemComponent>(archive);
+        // Same components as the scene files
+        CopyComponents<TagComponent, TransformComponent, HierarchyComponent, CameraComponent, MeshComponent,
+                       MaterialComponent, LightComponent, ParticleSystemComponent>(source, destination);
 
-        
-        scene->m_FilePath = path;
+        destination.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
 
-        auto view = scene->m_Registry.view<entt::entity>();
-        for (auto entity : view)
+        // The particles are updated in place through their billboards and material, the clone gets its own
+        for (auto&& [entity, particleSystem] : destination.view<ParticleSystemComponent>().each())
         {
-            auto& tag = scene->m_Registry.get<TagComponent>(entity);
-            auto& hierarchy = scene->m_Registry.get<HierarchyComponent>(entity);
-
-            COFFEE_INFO("Entity {0}, {1}", (uint32_t)entity, tag.Tag);
+            particleSystem.CopyResources();
         }
 
+        scene->m_FilePath = other->m_FilePath;
+        scene->m_OcclusionCuller.SetEnabled(other->m_OcclusionCuller.IsEnabled());
+        scene->m_OcclusionCuller.SetDebugDrawEnabled(other->m_OcclusionCuller.IsDebugDrawEnabled());
+
         return scene;
     }
 
-    void Scene::Save(const std::filesystem::path& path, Ref<Scene> scene)
+    // Binary scene files are a header, a table with one entry per chunk and the chunks. Each chunk is a separate
+    // binary archive with the entities or with one component pool, so it can be read from the mapped file
+    // without touching the others. Chunks with an unknown identifier are skipped.
+    static constexpr char SceneFileMagic[4] = {'T', 'E', 'A', 'S'};
+    static constexpr uint32_t SceneFileVersion = 1;
+
+    struct SceneFileHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t chunkCount;
+        uint32_t reserved;
+    };
+
+    struct SceneChunkEntry
+    {
+        uint32_t id;     ///< Hashed name of the chunk.
+        uint32_t count;  ///< Number of elements, used to reserve the pool.
+        uint64_t offset; ///< Offset from the start of the file.
+        uint64_t size;   ///< Size in bytes.
+    };
+
+    // Hashed names rather than entt::type_hash, which depends on the compiler
+    template <typename Type> constexpr entt::id_type SceneChunkId = 0;
+    template <> constexpr entt::id_type SceneChunkId<entt::entity> = entt::hashed_string::value("Entities");
+    template <> constexpr entt::id_type SceneChunkId<TagComponent> = entt::hashed_string::value("TagComponent");
+    template <> constexpr entt::id_type SceneChunkId<TransformComponent> = entt::hashed_string::value("TransformComponent");
+    template <> constexpr entt::id_type SceneChunkId<HierarchyComponent> = entt::hashed_string::value("HierarchyComponent");
+    template <> constexpr entt::id_type SceneChunkId<CameraComponent> = entt::hashed_string::value("CameraComponent");
+    template <> constexpr entt::id_type SceneChunkId<MeshComponent> = entt::hashed_string::value("MeshComponent");
+    template <> constexpr entt::id_type SceneChunkId<MaterialComponent> = entt::hashed_string::value("MaterialComponent");
+    template <> constexpr entt::id_type SceneChunkId<LightComponent> = entt::hashed_string::value("LightComponent");
+    template <> constexpr entt::id_type SceneChunkId<ParticleSystemComponent> = entt::hashed_string::value("ParticleSystemComponent");
+
+    /**
+     * @brief Serializes the entities and every component pool in a chunk of their own.
+     */
+    template <typename... Types>
+    static void WriteSceneChunks(const entt::registry& registry, std::vector<SceneChunkEntry>& entries, std::string& payload)
+    {
+        entt::snapshot snapshot{registry};
+
+        ([&]() {
+            std::ostringstream stream(std::ios::binary);
+            {
+                cereal::BinaryOutputArchive archive(stream);
+                snapshot.get<Types>(archive);
+            }
+
+            const auto* storage = registry.storage<Types>();
+            const std::string data = std::move(stream).str();
+
+            entries.push_back({SceneChunkId<Types>, storage ? static_cast<uint32_t>(storage->size()) : 0u,
+                               payload.size(), data.size()});
+            payload += data;
+        }(), ...);
+    }
+
+    /**
+     * @brief Reads the chunks of the given types present in the table, straight into the pools of the registry.
+     * The entities must be the first type, the loader emplaces the entities of the components that are not
+     * alive yet.
+     */
+    template <typename... Types>
+    static void ReadSceneChunks(entt::registry& registry, entt::snapshot_loader& loader, const MappedFile& file,
+                                std::span<const SceneChunkEntry> entries)
+    {
+        ([&]() {
+            auto entry = std::find_if(entries.begin(), entries.end(),
+                                      [](const SceneChunkEntry& chunk) { return chunk.id == SceneChunkId<Types>; });
+            if (entry == entries.end())
+                return;
+
+            ZoneScopedN("ReadSceneChunk");
+
+            // Each element takes at least its entity in the chunk, a count beyond that is not trusted
+            const uint64_t maxCount = entry->size / sizeof(entt::entity);
+            registry.storage<Types>().reserve(static_cast<size_t>(std::min<uint64_t>(entry->count, maxCount)));
+
+            MemoryStreamBuffer buffer(file.GetData() + entry->offset, entry->size);
+            std::istream stream(&buffer);
+            cereal::BinaryInputArchive archive(stream);
+            loader.get<Types>(archive);
+        }(), ...);
+    }
+
+    // Resources referenced by the components, preloaded in parallel before the component chunks are read
+    static constexpr entt::id_type SceneResourcesChunkId = entt::hashed_string::value("Resources");
+
+    struct SceneResources
+    {
+        std::vector<UUID> materials;
+        std::vector<UUID> meshes;
+
+        template <class Archive> void serialize(Archive& archive) { archive(materials, meshes); }
+    };
+
+    static void WriteSceneResources(entt::registry& registry, std::vector<SceneChunkEntry>& entries, std::string& payload)
+    {
+        SceneResources resources;
+
+        for (auto [entity, meshComponent] : registry.view<MeshComponent>().each())
+        {
+            if (meshComponent.mesh)
+                resources.meshes.push_back(meshComponent.mesh->GetUUID());
+        }
+
+        for (auto [entity, materialComponent] : registry.view<MaterialComponent>().each())
+        {
+            if (materialComponent.material)
+                resources.materials.push_back(materialComponent.material->GetUUID());
+        }
+
+        for (std::vector<UUID>* uuids : {&resources.materials, &resources.meshes})
+        {
+            std::sort(uuids->begin(), uuids->end());
+            uuids->erase(std::unique(uuids->begin(), uuids->end()), uuids->end());
+        }
+
+        std::ostringstream stream(std::ios::binary);
+        {
+            cereal::BinaryOutputArchive archive(stream);
+            archive(resources);
+        }
+
+        const std::string data = std::move(stream).str();
+        entries.push_back({SceneResourcesChunkId, static_cast<uint32_t>(resources.materials.size() + resources.meshes.size()),
+                           payload.size(), data.size()});
+        payload += data;
+    }
+
+    /**
+     * @brief Imports the resources of the scene on the job threads. The GPU objects of the resources decoded on
+     * job threads are created on this thread once every job has finished.
+     */
+    static void PreloadSceneResources(const MappedFile& file, const SceneChunkEntry& entry)
     {
         ZoneScoped;
 
-        std::ofstream sceneFile(path);
-        cereal::JSONOutputArchive archive(sceneFile);
-
-        //archive(*scene);
-
-        //TEMPORAL
-        entt::snapshot{scene->m_Registry}
-            .get<entt::entity>(archive)
-            .get<TagComponent>(archive)
-            .get<TransformComponent>(archive)
-            .get<HierarchyComponent>(archive)
-            .get<CameraComponent>(archive)
-            .get<MeshComponent>(archive)
-            .get<MaterialComponent>(archive)
-            .get<LightComponent>(archive)
-            .get<ParticleSystemComponent>(archive);
-        
-        scene->m_FilePath = path;
+        SceneResources resources;
+        {
+            MemoryStreamBuffer buffer(file.GetData() + entry.offset, entry.size);
+            std::istream stream(&buffer);
+            cereal::BinaryInputArchive archive(stream);
+            archive(resources);
+        }
+
+        // Materials first so the meshes find theirs already loaded
+        JobSystem::ParallelFor(static_cast<uint32_t>(resources.materials.size()), 1, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; ++i)
+                ResourceLoader::LoadMaterial(resources.materials[i]);
+        });
+
+        JobSystem::ParallelFor(static_cast<uint32_t>(resources.meshes.size()), 1, [&](uint32_t begin, uint32_t end, uint32_t) {
+            for (uint32_t i = begin; i < end; ++i)
+                ResourceLoader::LoadMesh(resources.meshes[i]);
+        });
+
+        UploadQueue::Flush();
+    }
+
+    static bool IsBinarySceneFile(const MappedFile& file)
+    {
+        return file.GetSize() >= sizeof(SceneFileHeader) &&
+               std::memcmp(file.GetData(), SceneFileMagic, sizeof(SceneFileMagic)) == 0;
+    }
+
+    static bool LoadBinaryScene(const MappedFile& file, entt::registry& registry)
+    {
+        SceneFileHeader header;
+        std::memcpy(&header, file.GetData(), sizeof(header));
+
+        if (header.version > SceneFileVersion)
+        {
+            COFFEE_CORE_ERROR("Scene file version {0} is newer than the supported version {1}", header.version,
+                              SceneFileVersion);
+            return false;
+        }
+
+        const uint64_t tableSize = static_cast<uint64_t>(header.chunkCount) * sizeof(SceneChunkEntry);
+        if (sizeof(SceneFileHeader) + tableSize > file.GetSize())
+        {
+            COFFEE_CORE_ERROR("Scene file chunk table is truncated");
+            return false;
+        }
+
+        std::vector<SceneChunkEntry> entries(header.chunkCount);
+        std::memcpy(entries.data(), file.GetData() + sizeof(SceneFileHeader), tableSize);
+
+        for (const SceneChunkEntry& entry : entries)
+        {
+            if (entry.offset > file.GetSize() || entry.size > file.GetSize() - entry.offset)
+            {
+                COFFEE_CORE_ERROR("Scene file chunk {0} is out of bounds", entry.id);
+                return false;
+            }
+        }
 
-        auto view = scene->m_Registry.view<entt::entity>();
-        for (auto entity : view)
+        // A chunk whose bounds are valid can still hold corrupted data
+        try
         {
-            auto& tag = scene->m_Registry.get<TagComponent>(entity);
-            auto& hierarchy = scene->m_Registry.get<HierarchyComponent>(entity);
+            auto resources = std::find_if(entries.begin(), entries.end(),
+                                          [](const SceneChunkEntry& chunk) { return chunk.id == SceneResourcesChunkId; });
+            if (resources != entries.end())
+            {
+                PreloadSceneResources(file, *resources);
+            }
 
-            COFFEE_INFO("Entity {0}, {1}", (uint32_t)entity, tag.Tag);
+            entt::snapshot_loader loader{registry};
+
+            ReadSceneChunks<entt::entity, TagComponent, TransformComponent, HierarchyComponent, CameraComponent,
+                            MeshComponent, MaterialComponent, LightComponent, ParticleSystemComponent>(registry, loader,
+                                                                                                       file, entries);
+        }
+        catch (const std::exception& e)
+        {
+            COFFEE_CORE_ERROR("Scene file is corrupted ({0})", e.what());
+            return false;
         }
+
+        return true;
     }
 
-    // Is possible that this function will be moved to the SceneTreePanel but for now it will stay here
-    void AddModelToTheSceneTree(Scene* scene, Ref<Model> model)
+    static bool LoadJSONScene(const MappedFile& file, entt::registry& registry)
     {
-        static Entity parent;
+        try
+        {
+            MemoryStreamBuffer buffer(file.GetData(), file.GetSize());
+            std::istream stream(&buffer);
+            cereal::JSONInputArchive archive(stream);
+
+            entt::snapshot_loader{registry}
+                .get<entt::entity>(archive)
+                .get<TagComponent>(archive)
+                .get<TransformComponent>(archive)
+                .get<HierarchyComponent>(archive)
+                .get<CameraComponent>(archive)
+                .get<MeshComponent>(archive)
+                .get<MaterialComponent>(archive)
+                .get<LightComponent>(archive)
+                .get<ParticleSystemComponent>(archive);
+        }
+        catch (const std::exception& e)
+        {
+            COFFEE_CORE_ERROR("Scene file is not a valid JSON scene ({0})", e.what());
+            return false;
+        }
 
-        Entity modelEntity = scene->CreateEntity(model->GetName());
+        return true;
+    }
+
+    Ref<Scene> Scene::Load(const std::filesystem::path& path)
+    {
+        ZoneScoped;
+
+        MappedFile file(path);
+        if (!file.IsOpen())
+        {
+            COFFEE_CORE_ERROR("Scene::Load: Could not open {0}", path.string());
+            return nullptr;
+        }
+
+        Ref<Scene> scene = CreateRef<Scene>();
+
+        // The links are read from the file, appending the children again on construction would duplicate them
+        scene->m_Registry.on_construct<HierarchyComponent>().disconnect<&HierarchyComponent::OnConstruct>();
+
+        // The format is detected from the content, scenes saved as JSON keep loading
+        if (IsBinarySceneFile(file))
+        {
+            if (!LoadBinaryScene(file, scene->m_Registry))
+                return nullptr;
+        }
+        else
+        {
+            if (!LoadJSONScene(file, scene->m_Registry))
+                return nullptr;
+        }
+
+        scene->m_Registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
+
+        for (auto entity : scene->m_Registry.view<HierarchyComponent>())
+        {
+            HierarchyComponent::RelinkChildren(scene->m_Registry, entity);
+        }
+
+        scene->m_FilePath = path;
+
+        return scene;
+    }
+
+    void Scene::Save(const std::filesystem::path& path, Ref<Scene> scene, ResourceFormat format)
+    {
+        ZoneScoped;
+
+        if (format == ResourceFormat::JSON)
+        {
+            std::ofstream sceneFile(path);
+            {
+                cereal::JSONOutputArchive archive(sceneFile);
+
+                entt::snapshot{scene->m_Registry}
+                    .get<entt::entity>(archive)
+                    .get<TagComponent>(archive)
+                    .get<TransformComponent>(archive)
+                    .get<HierarchyComponent>(archive)
+                    .get<CameraComponent>(archive)
+                    .get<MeshComponent>(archive)
+                    .get<MaterialComponent>(archive)
+                    .get<LightComponent>(archive)
+                    .get<ParticleSystemComponent>(archive);
+            }
+
+            // The archive writes its closing brace when destroyed
+            sceneFile.flush();
+            if (!sceneFile)
+            {
+                COFFEE_CORE_ERROR("Scene::Save: Failed to write {0}", path.string());
+                return;
+            }
+        }
+        else
+        {
+            std::vector<SceneChunkEntry> entries;
+            std::string payload;
+
+            WriteSceneChunks<entt::entity, TagComponent, TransformComponent, HierarchyComponent, CameraComponent,
+                             MeshComponent, MaterialComponent, LightComponent, ParticleSystemComponent>(
+                scene->m_Registry, entries, payload);
+            WriteSceneResources(scene->m_Registry, entries, payload);
+
+            SceneFileHeader header{};
+            std::memcpy(header.magic, SceneFileMagic, sizeof(SceneFileMagic));
+            header.version = SceneFileVersion;
+            header.chunkCount = static_cast<uint32_t>(entries.size());
+
+            const uint64_t payloadOffset = sizeof(SceneFileHeader) + entries.size() * sizeof(SceneChunkEntry);
+            for (SceneChunkEntry& entry : entries)
+            {
+                entry.offset += payloadOffset;
+            }
+
+            std::ofstream sceneFile(path, std::ios::binary);
+            sceneFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            sceneFile.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(SceneChunkEntry));
+            sceneFile.write(payload.data(), payload.size());
 
-        if((entt::entity)parent != entt::null)modelEntity.SetParent(parent);
+            sceneFile.flush();
+            if (!sceneFile)
+            {
+                COFFEE_CORE_ERROR("Scene::Save: Failed to write {0}", path.string());
+                return;
+            }
+        }
+
+        scene->m_FilePath = path;
+    }
+
+    // Creates the entities of a model and, recursively, of its children. Returns the entity of the model.
+    static Entity CreateModelEntities(Scene* scene, const Ref<Model>& model)
+    {
+        Entity modelEntity = scene->CreateEntity(model->GetName());
         modelEntity.GetComponent<TransformComponent>().SetLocalTransform(model->GetTransform());
 
         auto& meshes = model->GetMeshes();
         bool hasMultipleMeshes = meshes.size() > 1;
 
+        std::vector<entt::entity> children;
+        children.reserve((hasMultipleMeshes ? meshes.size() : 0) + model->GetChildren().size());
+
         for(auto& mesh : meshes)
         {
             Entity entity = hasMultipleMeshes ? scene->CreateEntity(mesh->GetName()) : modelEntity;
@@ -392,15 +1081,27 @@ namespace Coffee {
 
             if(hasMultipleMeshes)
             {
-                entity.SetParent(modelEntity);
+                children.push_back((entt::entity)entity);
             }
         }
 
         for(auto& c : model->GetChildren())
         {
-            parent = modelEntity;
-            AddModelToTheSceneTree(scene, c);
+            children.push_back((entt::entity)CreateModelEntities(scene, c));
         }
+
+        // Attach everything at once instead of one reparent per child
+        modelEntity.AddChildren(children);
+
+        return modelEntity;
+    }
+
+    // Is possible that this function will be moved to the SceneTreePanel but for now it will stay here
+    void AddModelToTheSceneTree(Scene* scene, Ref<Model> model)
+    {
+        ZoneScoped;
+
+        CreateModelEntities(scene, model);
     }
 
 }
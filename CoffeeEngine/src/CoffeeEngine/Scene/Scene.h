@@ -2,13 +2,19 @@
 
 #include "CoffeeEngine/Core/DataStructures/Octree.h"
 #include "CoffeeEngine/Events/Event.h"
+#include "CoffeeEngine/IO/ResourceFormat.h"
 #include "CoffeeEngine/Renderer/EditorCamera.h"
+#include "CoffeeEngine/Renderer/OcclusionCuller.h"
+#include "CoffeeEngine/Renderer/RenderQueue.h"
 #include "CoffeeEngine/Scene/SceneTree.h"
 #include "entt/entity/fwd.hpp"
 
 #include <entt/entt.hpp>
 #include <filesystem>
+#include <limits>
+#include <span>
 #include <string>
+#include <vector>
 
 namespace Coffee {
 
@@ -20,6 +26,17 @@ namespace Coffee {
     class Entity;
     class Model;
 
+    /**
+     * @brief Result of a scene raycast.
+     * @ingroup scene
+     */
+    struct RaycastHit
+    {
+        entt::entity entity = entt::null; ///< The entity hit.
+        float distance = 0.0f;            ///< The distance along the ray.
+        glm::vec3 point = glm::vec3(0.0f); ///< The hit point in world space.
+    };
+
     /**
      * @brief Class representing a scene.
      * @ingroup scene
@@ -33,9 +50,9 @@ namespace Coffee {
         Scene();
 
         /**
-         * @brief Default destructor.
+         * @brief Destructor, disconnects from the registry signals.
          */
-        ~Scene() = default;
+        ~Scene();
 
         //Scene(Ref<Scene> other);
 
@@ -92,25 +109,149 @@ namespace Coffee {
             return m_Registry.view<Components...>();
         }
 
+        /**
+         * @brief Creates a copy of a scene in memory, used to enter play mode.
+         *
+         * The component pools are copied entity by entity, keeping the same entity identifiers so the hierarchy
+         * links stay valid. Resources are shared by reference, except the particle billboards and material, which
+         * the particle systems edit in place. The scene tree and the octree of the copy are rebuilt from the
+         * registry signals on its first update.
+         *
+         * @param other The scene to copy.
+         * @return The copy.
+         */
+        static Ref<Scene> Clone(const Ref<Scene>& other);
+
         /**
          * @brief Load a scene from a file.
+         *
+         * The file is memory mapped and the format is detected from its content. Binary files are read chunk by
+         * chunk straight into the component pools, only the pages of the chunks that are read are loaded.
+         *
          * @param path The path to the file.
-         * @return The loaded scene.
+         * @return The loaded scene, or nullptr if the file could not be read.
          */
         static Ref<Scene> Load(const std::filesystem::path& path);
 
         /**
          * @brief Save a scene to a file.
+         *
+         * The binary format is a versioned header, a table of chunks and one chunk with the entities and one per
+         * component pool. JSON is kept to export scenes in a readable, diffable form.
+         *
          * @param path The path to the file.
          * @param scene The scene to save.
+         * @param format The format of the file.
+         */
+        static void Save(const std::filesystem::path& path, Ref<Scene> scene, ResourceFormat format = ResourceFormat::Binary);
+
+        /**
+         * @brief Builds the render commands of mesh entities on the job system, as the editor update does.
+         *
+         * The entities are split in chunks and each chunk is built by a worker into its own queue. Submitting the
+         * queues in chunk order keeps the order of the entities.
+         *
+         * @param registry The registry of the entities.
+         * @param entities The entities to draw, each with a MeshComponent and a TransformComponent.
+         * @param chunkQueues The queues of the chunks, grown as needed.
+         * @return The number of chunk queues that were filled.
          */
-        static void Save(const std::filesystem::path& path, Ref<Scene> scene);
+        static uint32_t BuildRenderCommands(entt::registry& registry, std::span<const entt::entity> entities,
+                                            std::vector<RenderQueue>& chunkQueues);
 
         const std::filesystem::path& GetFilePath() { return m_FilePath; }
+
+        /**
+         * @brief Gets the software occlusion culler used by the runtime update.
+         * @return The occlusion culler.
+         */
+        OcclusionCuller& GetOcclusionCuller() { return m_OcclusionCuller; }
+
+        /**
+         * @brief Gets the view projection of the camera rendered by the last runtime update.
+         * @return The view projection matrix, used to pick what the runtime camera shows.
+         */
+        const glm::mat4& GetRuntimeViewProjection() const { return m_RuntimeViewProjection; }
+
+        /**
+         * @brief Finds the closest mesh entity hit by a ray.
+         *
+         * The candidates come from the octree sorted by the distance to their bounds, and are refined against
+         * the triangles of their mesh until no remaining bounds can be closer than the best hit.
+         *
+         * @param ray The ray in world space.
+         * @param hit The closest hit.
+         * @param maxDistance The maximum distance along the ray.
+         * @return True if a mesh was hit.
+         */
+        bool Raycast(const Ray& ray, RaycastHit& hit, float maxDistance = std::numeric_limits<float>::max()) const;
+
+        /**
+         * @brief Finds every mesh entity hit by a ray, tested against the triangles of their mesh.
+         * @param ray The ray in world space.
+         * @param maxDistance The maximum distance along the ray.
+         * @return The closest hit of each entity, sorted by distance.
+         */
+        std::vector<RaycastHit> RaycastAll(const Ray& ray, float maxDistance = std::numeric_limits<float>::max()) const;
+
+        /**
+         * @brief Finds the closest entity without mesh bounds hit by a ray. Lights and cameras are tested against
+         * a box around their position, particle systems against a box around each live particle.
+         * @param ray The ray in world space.
+         * @param hit Receives the closest hit.
+         * @param proxySize The size of the boxes around the lights and cameras.
+         * @param maxDistance The maximum distance along the ray.
+         * @return True if an entity was hit.
+         */
+        bool RaycastProxies(const Ray& ray, RaycastHit& hit, float proxySize,
+                            float maxDistance = std::numeric_limits<float>::max()) const;
+
+        /**
+         * @brief Culls the mesh entities against several views in a single traversal of the octree.
+         *
+         * Meant for several views rendered in the same frame, such as split-screen cameras or shadow cascades. The
+         * views are tested in parallel. A single view is cheaper through Octree::Query, as the runtime camera does.
+         *
+         * @param views The frusta of the views, at most Octree::MaxViews.
+         * @param results The entities visible in at least one view, with bit v of their mask set if view v sees them.
+         */
+        void CullViews(std::span<const Frustum> views, OctreeViewResults<entt::entity>& results) const;
+
+        /**
+         * @brief Finds the mesh entities whose world bounds overlap a sphere.
+         * @param center The center of the sphere in world space.
+         * @param radius The radius of the sphere.
+         */
+        std::vector<entt::entity> OverlapSphere(const glm::vec3& center, float radius) const;
+
+        /**
+         * @brief Finds the mesh entities whose world bounds overlap a box.
+         * @param aabb The box in world space.
+         */
+        std::vector<entt::entity> OverlapBox(const AABB& aabb) const;
+    private:
+        /**
+         * @brief Recomputes the cached world bounds of the mesh entities whose mesh or transform changed, and
+         * moves their octree entries.
+         */
+        void UpdateWorldBounds();
+
+        /**
+         * @brief Rebuilds the octree from all the mesh entities of the scene.
+         */
+        void RebuildOctree();
+
+        void OnMeshChanged(entt::registry& registry, entt::entity entity);
+        void OnMeshDestroyed(entt::registry& registry, entt::entity entity);
+        void OnTransformChanged(entt::registry& registry, entt::entity entity);
+
     private:
         entt::registry m_Registry;
         Scope<SceneTree> m_SceneTree;
-        Octree<Ref<Mesh>> m_Octree;
+        Octree<entt::entity> m_Octree; ///< World bounds of every mesh entity, kept in sync with the transforms.
+        std::vector<entt::entity> m_PendingBounds; ///< Mesh entities whose world bounds are out of date.
+        OcclusionCuller m_OcclusionCuller;
+        glm::mat4 m_RuntimeViewProjection = glm::mat4(1.0f); ///< The camera rendered by the last runtime update.
 
         // Temporal: Scenes should be Resources and the Base Resource class already has a path variable.
         std::filesystem::path m_FilePath;
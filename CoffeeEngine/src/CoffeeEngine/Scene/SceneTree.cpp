@@ -1,4 +1,5 @@
 #include "SceneTree.h"
+#include "CoffeeEngine/Core/JobSystem.h"
 #include "CoffeeEngine/Core/Log.h"
 #include "CoffeeEngine/Scene/Components.h"
 #include "CoffeeEngine/Scene/Scene.h"
@@ -12,6 +13,7 @@ namespace Coffee {
     {
         m_Parent = parent;
         m_First = entt::null;
+        m_Last = entt::null;
         m_Next = entt::null;
         m_Prev = entt::null;
     }
@@ -19,90 +21,91 @@ namespace Coffee {
     {
         m_Parent = entt::null;
         m_First = entt::null;
+        m_Last = entt::null;
         m_Next = entt::null;
         m_Prev = entt::null;
     }
 
-    void HierarchyComponent::OnConstruct(entt::registry& registry, entt::entity entity)
+    // Appends an entity at the end of the children of a parent in O(1)
+    static void LinkLastChild(entt::registry& registry, entt::entity parent, HierarchyComponent& parentHierarchy,
+                              entt::entity entity, HierarchyComponent& hierarchy)
     {
-        auto& hierarchy = registry.get<HierarchyComponent>(entity);
+        hierarchy.m_Parent = parent;
+        hierarchy.m_Prev = parentHierarchy.m_Last;
+        hierarchy.m_Next = entt::null;
 
-        if(hierarchy.m_Parent != entt::null)
+        if(parentHierarchy.m_Last != entt::null)
+        {
+            registry.get<HierarchyComponent>(parentHierarchy.m_Last).m_Next = entity;
+        }
+        else
         {
-            auto& parentHierarchy = registry.get<HierarchyComponent>(hierarchy.m_Parent);
+            parentHierarchy.m_First = entity;
+        }
 
-            if(parentHierarchy.m_First == entt::null)
-            {
-                parentHierarchy.m_First = entity;
-            }
-            else
-            {
-                //Get the last child of the parent
-                auto lastEntity = parentHierarchy.m_First;
-                auto lastHierarchy = registry.try_get<HierarchyComponent>(lastEntity);
-                while(lastHierarchy != nullptr && lastHierarchy->m_Next != entt::null)
-                {
-                    auto nextEntity = lastHierarchy->m_Next;
-                    auto nextHierarchy = registry.try_get<HierarchyComponent>(nextEntity);
+        parentHierarchy.m_Last = entity;
+        parentHierarchy.m_ChildCount++;
+    }
 
-                    if(nextHierarchy == nullptr)
-                    {
-                        break;
-                    }
+    // Removes an entity from the children of its parent in O(1), the entity keeps its own children
+    static void Unlink(entt::registry& registry, entt::entity entity, HierarchyComponent& hierarchy)
+    {
+        HierarchyComponent* parentHierarchy = nullptr;
+        if(hierarchy.m_Parent != entt::null && registry.valid(hierarchy.m_Parent))
+        {
+            parentHierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Parent);
+        }
 
-                    lastEntity = nextEntity;
-                    lastHierarchy = nextHierarchy;
-                }
-                if (lastEntity == entity)
-                {
-                    return;
-                }
-                lastHierarchy->m_Next = entity;
-                lastHierarchy->m_Prev = lastEntity;
-            }
+        auto prevHierarchy = hierarchy.m_Prev != entt::null ? registry.try_get<HierarchyComponent>(hierarchy.m_Prev) : nullptr;
+        auto nextHierarchy = hierarchy.m_Next != entt::null ? registry.try_get<HierarchyComponent>(hierarchy.m_Next) : nullptr;
+
+        if(prevHierarchy != nullptr)
+        {
+            prevHierarchy->m_Next = hierarchy.m_Next;
+        }
+        else if(parentHierarchy != nullptr && parentHierarchy->m_First == entity)
+        {
+            parentHierarchy->m_First = hierarchy.m_Next;
         }
-    }
 
-    void HierarchyComponent::OnDestroy(entt::registry& registry, entt::entity entity)
-    {
-        auto& hierarchy = registry.get<HierarchyComponent>(entity);
-        // if is the first child
-        if(hierarchy.m_Prev == entt::null || !registry.valid(hierarchy.m_Prev))
+        if(nextHierarchy != nullptr)
         {
-            if(hierarchy.m_Parent != entt::null && registry.valid(hierarchy.m_Parent))
-            {
-                auto parent_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Parent);
-                if(parent_hierarchy != nullptr)
-                {
-                    parent_hierarchy->m_First = hierarchy.m_Next;
-                    if(hierarchy.m_Next != entt::null)
-                    {
-                        auto next_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Next);
-                        if(next_hierarchy != nullptr)
-                        {
-                            next_hierarchy->m_Prev = entt::null;
-                        }
-                    }
-                }
-            }
+            nextHierarchy->m_Prev = hierarchy.m_Prev;
         }
-        else
+        else if(parentHierarchy != nullptr && parentHierarchy->m_Last == entity)
         {
-            auto prev_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Prev);
-            if(prev_hierarchy != nullptr)
-            {
-                prev_hierarchy->m_Next = hierarchy.m_Next;
-            }
-            if(hierarchy.m_Next != entt::null)
-            {
-                auto next_hierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Next);
-                if(next_hierarchy != nullptr)
-                {
-                    next_hierarchy->m_Prev = hierarchy.m_Prev;
-                }
-            }
+            parentHierarchy->m_Last = hierarchy.m_Prev;
+        }
+
+        if(parentHierarchy != nullptr && parentHierarchy->m_ChildCount > 0)
+        {
+            parentHierarchy->m_ChildCount--;
         }
+
+        hierarchy.m_Parent = entt::null;
+        hierarchy.m_Next = entt::null;
+        hierarchy.m_Prev = entt::null;
+    }
+
+    void HierarchyComponent::OnConstruct(entt::registry& registry, entt::entity entity)
+    {
+        auto& hierarchy = registry.get<HierarchyComponent>(entity);
+
+        if(hierarchy.m_Parent == entt::null)
+            return;
+
+        auto parentHierarchy = registry.try_get<HierarchyComponent>(hierarchy.m_Parent);
+        if(parentHierarchy == nullptr || parentHierarchy->m_Last == entity)
+            return;
+
+        LinkLastChild(registry, hierarchy.m_Parent, *parentHierarchy, entity, hierarchy);
+    }
+
+    void HierarchyComponent::OnDestroy(entt::registry& registry, entt::entity entity)
+    {
+        Unlink(registry, entity, registry.get<HierarchyComponent>(entity));
     }
+
     void HierarchyComponent::OnUpdate(entt::registry& registry, entt::entity entity)
     {
         
@@ -112,19 +115,100 @@ namespace Coffee {
     {
         ZoneScoped;
         
-        auto hierarchyComponent = registry.try_get<HierarchyComponent>(entity);
-
-        HierarchyComponent::OnDestroy(registry, entity);
+        auto& hierarchyComponent = registry.get<HierarchyComponent>(entity);
 
-        hierarchyComponent->m_Parent = entt::null;
-        hierarchyComponent->m_Next = entt::null;
-        hierarchyComponent->m_Prev = entt::null;
+        Unlink(registry, entity, hierarchyComponent);
 
         if(parent != entt::null)
         {
-            hierarchyComponent->m_Parent = parent;
-            HierarchyComponent::OnConstruct(registry, entity);
+            LinkLastChild(registry, parent, registry.get<HierarchyComponent>(parent), entity, hierarchyComponent);
+        }
+
+        // The local transform is unchanged but it is now relative to another parent
+        if(auto transformComponent = registry.try_get<TransformComponent>(entity))
+        {
+            transformComponent->MarkDirty();
+        }
+
+        // Let the scene tree know the hierarchy changed
+        registry.patch<HierarchyComponent>(entity);
+    }
+
+    void HierarchyComponent::AttachChildren(entt::registry& registry, entt::entity parent, std::span<const entt::entity> children)
+    {
+        ZoneScoped;
+
+        if(children.empty())
+            return;
+
+        auto& parentHierarchy = registry.get<HierarchyComponent>(parent);
+
+        for(auto child : children)
+        {
+            auto& hierarchy = registry.get<HierarchyComponent>(child);
+
+            Unlink(registry, child, hierarchy);
+            LinkLastChild(registry, parent, parentHierarchy, child, hierarchy);
+
+            if(auto transformComponent = registry.try_get<TransformComponent>(child))
+            {
+                transformComponent->MarkDirty();
+            }
+        }
+
+        registry.patch<HierarchyComponent>(parent);
+    }
+
+    void HierarchyComponent::DetachChildren(entt::registry& registry, entt::entity parent)
+    {
+        ZoneScoped;
+
+        auto& parentHierarchy = registry.get<HierarchyComponent>(parent);
+
+        entt::entity child = parentHierarchy.m_First;
+        while(child != entt::null)
+        {
+            auto& hierarchy = registry.get<HierarchyComponent>(child);
+            entt::entity next = hierarchy.m_Next;
+
+            hierarchy.m_Parent = entt::null;
+            hierarchy.m_Next = entt::null;
+            hierarchy.m_Prev = entt::null;
+
+            if(auto transformComponent = registry.try_get<TransformComponent>(child))
+            {
+                transformComponent->MarkDirty();
+            }
+
+            child = next;
+        }
+
+        parentHierarchy.m_First = entt::null;
+        parentHierarchy.m_Last = entt::null;
+        parentHierarchy.m_ChildCount = 0;
+
+        registry.patch<HierarchyComponent>(parent);
+    }
+
+    void HierarchyComponent::RelinkChildren(entt::registry& registry, entt::entity parent)
+    {
+        auto& parentHierarchy = registry.get<HierarchyComponent>(parent);
+
+        entt::entity prev = entt::null;
+        uint32_t count = 0;
+
+        for(entt::entity child = parentHierarchy.m_First; child != entt::null; child = registry.get<HierarchyComponent>(child).m_Next)
+        {
+            auto& hierarchy = registry.get<HierarchyComponent>(child);
+            hierarchy.m_Parent = parent;
+            hierarchy.m_Prev = prev;
+
+            prev = child;
+            count++;
         }
+
+        parentHierarchy.m_Last = prev;
+        parentHierarchy.m_ChildCount = count;
     }
 
     SceneTree::SceneTree(Scene* scene) : m_Context(scene)
@@ -133,51 +217,140 @@ namespace Coffee {
         registry.on_construct<HierarchyComponent>().connect<&HierarchyComponent::OnConstruct>();
         registry.on_update<HierarchyComponent>().connect<&HierarchyComponent::OnUpdate>();
         registry.on_destroy<HierarchyComponent>().connect<&HierarchyComponent::OnDestroy>();
+
+        // Any structural change invalidates the flat hierarchy and the transform pointers it caches
+        registry.on_construct<HierarchyComponent>().connect<&SceneTree::OnHierarchyChanged>(*this);
+        registry.on_update<HierarchyComponent>().connect<&SceneTree::OnHierarchyChanged>(*this);
+        registry.on_destroy<HierarchyComponent>().connect<&SceneTree::OnHierarchyChanged>(*this);
+        registry.on_construct<TransformComponent>().connect<&SceneTree::OnHierarchyChanged>(*this);
+        registry.on_destroy<TransformComponent>().connect<&SceneTree::OnHierarchyChanged>(*this);
     }
 
-    void SceneTree::Update()
+    SceneTree::~SceneTree()
     {
         auto& registry = m_Context->m_Registry;
-        auto view = registry.view<HierarchyComponent>();
+        registry.on_construct<HierarchyComponent>().disconnect(*this);
+        registry.on_update<HierarchyComponent>().disconnect(*this);
+        registry.on_destroy<HierarchyComponent>().disconnect(*this);
+        registry.on_construct<TransformComponent>().disconnect(*this);
+        registry.on_destroy<TransformComponent>().disconnect(*this);
+    }
+
+    void SceneTree::OnHierarchyChanged(entt::registry& registry, entt::entity entity)
+    {
+        m_HierarchyDirty = true;
+    }
+
+    void SceneTree::RebuildHierarchy()
+    {
+        ZoneScoped;
+
+        auto& registry = m_Context->m_Registry;
+
+        m_Nodes.clear();
+        m_Transforms.clear();
+        m_ParentIndices.clear();
+        m_LevelOffsets.clear();
+
+        auto view = registry.view<HierarchyComponent, TransformComponent>();
         for(auto entity : view)
         {
-            const auto hierarchy = registry.get<HierarchyComponent>(entity);
+            if(view.get<HierarchyComponent>(entity).m_Parent == entt::null)
+            {
+                m_Nodes.push_back(entity);
+                m_ParentIndices.push_back(InvalidIndex);
+            }
+        }
+
+        // Breadth-first walk, every level is appended right after the previous one
+        uint32_t levelBegin = 0;
+        while(levelBegin < m_Nodes.size())
+        {
+            uint32_t levelEnd = static_cast<uint32_t>(m_Nodes.size());
+            m_LevelOffsets.push_back(levelBegin);
 
-            if(hierarchy.m_Parent == entt::null)
+            for(uint32_t parentIndex = levelBegin; parentIndex < levelEnd; ++parentIndex)
             {
-                UpdateTransform(entity);
+                entt::entity child = registry.get<HierarchyComponent>(m_Nodes[parentIndex]).m_First;
+                while(child != entt::null)
+                {
+                    if(registry.all_of<TransformComponent>(child))
+                    {
+                        m_Nodes.push_back(child);
+                        m_ParentIndices.push_back(parentIndex);
+                    }
+                    child = registry.get<HierarchyComponent>(child).m_Next;
+                }
             }
+
+            levelBegin = levelEnd;
+        }
+        m_LevelOffsets.push_back(static_cast<uint32_t>(m_Nodes.size()));
+
+        m_Transforms.reserve(m_Nodes.size());
+        for(auto entity : m_Nodes)
+        {
+            m_Transforms.push_back(&registry.get<TransformComponent>(entity));
         }
+
+        m_NodeChanged.assign(m_Nodes.size(), 0);
+
+        m_HierarchyDirty = false;
     }
 
-    void SceneTree::UpdateTransform(entt::entity entity)
+    void SceneTree::Update()
     {
+        ZoneScoped;
+
         auto& registry = m_Context->m_Registry;
-        
-        auto& hierarchyComponent = registry.get<HierarchyComponent>(entity);
-        auto& transformComponent = registry.get<TransformComponent>(entity);
 
-        // Update the world transform of the entity
+        // Reparented and new entities are already dirty, rebuilding does not force a full recompute
+        if(m_HierarchyDirty)
+        {
+            RebuildHierarchy();
+        }
+
+        m_ChangedEntities.clear();
 
-        if(hierarchyComponent.m_Parent != entt::null)
+        for(size_t level = 0; level + 1 < m_LevelOffsets.size(); ++level)
         {
-            auto& parentTransformComponent = registry.get<TransformComponent>(hierarchyComponent.m_Parent);
+            ZoneScopedN("SceneTree Level");
+
+            uint32_t levelBegin = m_LevelOffsets[level];
+            uint32_t levelCount = m_LevelOffsets[level + 1] - levelBegin;
 
-            transformComponent.SetWorldTransform(parentTransformComponent.GetWorldTransform());
+            JobSystem::ParallelFor(levelCount, 256, [this, levelBegin](uint32_t begin, uint32_t end, uint32_t) {
+                for(uint32_t i = levelBegin + begin; i < levelBegin + end; ++i)
+                {
+                    uint32_t parentIndex = m_ParentIndices[i];
+                    bool parentChanged = parentIndex != InvalidIndex && m_NodeChanged[parentIndex];
+
+                    TransformComponent& transform = *m_Transforms[i];
+                    if(!parentChanged && !transform.IsDirty())
+                    {
+                        m_NodeChanged[i] = 0;
+                        continue;
+                    }
+
+                    transform.SetWorldTransform(parentIndex != InvalidIndex ? m_Transforms[parentIndex]->GetWorldTransform()
+                                                                            : glm::mat4(1.0f));
+                    m_NodeChanged[i] = 1;
+                }
+            });
         }
-        else
+
+        for(size_t i = 0; i < m_Nodes.size(); ++i)
         {
-            transformComponent.SetWorldTransform(glm::mat4(1.0f));
+            if(m_NodeChanged[i])
+            {
+                m_ChangedEntities.push_back(m_Nodes[i]);
+            }
         }
 
-        // Recursively update all the children
-
-        entt::entity child = hierarchyComponent.m_First;
-        while(child != entt::null)
+        for(auto entity : m_ChangedEntities)
         {
-            UpdateTransform(child);
-            child = registry.get<HierarchyComponent>(child).m_Next;
+            m_OnTransformChanged.publish(registry, entity);
         }
     }
 
-}
\ No newline at end of file
+}
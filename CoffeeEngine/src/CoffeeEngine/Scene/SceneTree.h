@@ -3,11 +3,15 @@
 #include "CoffeeEngine/Core/Base.h"
 #include "entt/entity/fwd.hpp"
 #include <cereal/cereal.hpp>
+#include <cstdint>
 #include <entt/entt.hpp>
+#include <span>
+#include <vector>
 
 namespace Coffee {
 
     class Scene;
+    struct TransformComponent;
 
     /**
      * @defgroup scene Scene
@@ -60,10 +64,39 @@ namespace Coffee {
          */
         static void Reparent(entt::registry& registry, entt::entity entity, entt::entity parent);
 
+        /**
+         * @brief Appends several entities at the end of the children of a parent.
+         *
+         * Each child is unlinked from its previous parent, if any, and the scene tree is notified once for the
+         * whole batch.
+         *
+         * @param registry The entity registry.
+         * @param parent The new parent entity.
+         * @param children The entities to attach, in order.
+         */
+        static void AttachChildren(entt::registry& registry, entt::entity parent, std::span<const entt::entity> children);
+
+        /**
+         * @brief Detaches all the children of an entity, turning them into roots.
+         * @param registry The entity registry.
+         * @param parent The parent entity.
+         */
+        static void DetachChildren(entt::registry& registry, entt::entity parent);
+
+        /**
+         * @brief Rebuilds the last child, previous sibling and child count of an entity from its first child and
+         * the next sibling links, which are the only ones stored in scene files.
+         * @param registry The entity registry.
+         * @param parent The parent entity.
+         */
+        static void RelinkChildren(entt::registry& registry, entt::entity parent);
+
         entt::entity m_Parent;
         entt::entity m_First;
+        entt::entity m_Last;
         entt::entity m_Next;
         entt::entity m_Prev;
+        uint32_t m_ChildCount = 0;
 
         /**
          * @brief Serialize the component.
@@ -101,23 +134,60 @@ namespace Coffee {
         SceneTree(Scene* scene);
 
         /**
-         * @brief Default destructor.
+         * @brief Destructor, disconnects from the registry signals.
          */
-        ~SceneTree() = default;
+        ~SceneTree();
 
         /**
          * @brief Update the scene tree.
+         *
+         * The hierarchy is kept flattened in breadth-first order, sorted by depth, with the index of the parent of
+         * every node. World transforms are computed one depth level at a time: all the parents of a level are
+         * already up to date, so the nodes of a level are independent and are split across the job system.
+         *
+         * Only nodes with a dirty transform, or whose parent changed, are recomputed, a static scene costs a
+         * single pass over the flat array. Every entity whose world transform changed is then notified through
+         * OnTransformChanged().
          */
         void Update();
 
         /**
-         * @brief Update the transform of an entity.
-         * @param entity The entity to update.
+         * @brief Sink to connect to the signal published for each entity whose world transform changed.
+         *
+         * The signal is published at the end of Update(), once every world transform is up to date.
+         */
+        auto OnTransformChanged() { return entt::sink{m_OnTransformChanged}; }
+
+        /**
+         * @brief Gets the entities whose world transform changed in the last update, parents before children.
+         */
+        const std::vector<entt::entity>& GetChangedEntities() const { return m_ChangedEntities; }
+
+    private:
+        /**
+         * @brief Flags the flat hierarchy to be rebuilt on the next update.
+         */
+        void OnHierarchyChanged(entt::registry& registry, entt::entity entity);
+
+        /**
+         * @brief Rebuilds the flat hierarchy from the HierarchyComponent links.
          */
-        void UpdateTransform(entt::entity entity);
+        void RebuildHierarchy();
 
     private:
+        static constexpr uint32_t InvalidIndex = UINT32_MAX;
+
         Scene* m_Context;
+
+        std::vector<entt::entity> m_Nodes; ///< Entities in breadth-first order.
+        std::vector<TransformComponent*> m_Transforms; ///< Transform of each node.
+        std::vector<uint32_t> m_ParentIndices; ///< Index of the parent of each node, InvalidIndex for roots.
+        std::vector<uint32_t> m_LevelOffsets; ///< First node of each depth level, plus the node count at the end.
+        std::vector<uint8_t> m_NodeChanged; ///< Whether the world transform of each node changed this update.
+        bool m_HierarchyDirty = true;
+
+        entt::sigh<void(entt::registry&, entt::entity)> m_OnTransformChanged;
+        std::vector<entt::entity> m_ChangedEntities;
     };
 
     /** @} */ // end of scene group
@@ -6,6 +6,7 @@
 #include "CoffeeEngine/Core/MouseCodes.h"
 #include "CoffeeEngine/Scene/Components.h"
 #include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/Scene.h"
 
 #define SOL_PRINT_ERRORS 1
 
@@ -13,6 +14,7 @@ namespace Coffee {
 
     sol::state LuaBackend::luaState;
     std::unordered_map<std::string, sol::environment> LuaBackend::scriptEnvironments;
+    Scene* LuaBackend::activeScene = nullptr;
 
     void BindKeyCodesToLua(sol::state& lua, sol::table& inputTable)
     {
@@ -335,6 +337,53 @@ namespace Coffee {
         # pragma region Bind Timer Functions
         # pragma endregion
 
+        # pragma region Bind Scene Query Functions
+        sol::table sceneTable = luaState.create_table();
+
+        sceneTable.set_function("raycast", [](float originX, float originY, float originZ, float directionX, float directionY,
+                                              float directionZ, sol::optional<float> maxDistance) -> sol::variadic_results {
+            sol::variadic_results results;
+
+            RaycastHit hit;
+            Ray ray({originX, originY, originZ}, glm::normalize(glm::vec3(directionX, directionY, directionZ)));
+            if (activeScene && activeScene->Raycast(ray, hit, maxDistance.value_or(std::numeric_limits<float>::max())))
+            {
+                results.push_back(sol::make_object(luaState, Entity(hit.entity, activeScene)));
+                results.push_back(sol::make_object(luaState, hit.distance));
+                results.push_back(sol::make_object(luaState, hit.point.x));
+                results.push_back(sol::make_object(luaState, hit.point.y));
+                results.push_back(sol::make_object(luaState, hit.point.z));
+            }
+            else
+            {
+                results.push_back(sol::make_object(luaState, sol::lua_nil));
+            }
+            return results;
+        });
+
+        sceneTable.set_function("overlap_sphere", [](float centerX, float centerY, float centerZ, float radius) {
+            std::vector<Entity> entities;
+            if (activeScene)
+            {
+                for (auto entity : activeScene->OverlapSphere({centerX, centerY, centerZ}, radius))
+                    entities.emplace_back(entity, activeScene);
+            }
+            return sol::as_table(entities);
+        });
+
+        sceneTable.set_function("overlap_box", [](float minX, float minY, float minZ, float maxX, float maxY, float maxZ) {
+            std::vector<Entity> entities;
+            if (activeScene)
+            {
+                for (auto entity : activeScene->OverlapBox(AABB({minX, minY, minZ}, {maxX, maxY, maxZ})))
+                    entities.emplace_back(entity, activeScene);
+            }
+            return sol::as_table(entities);
+        });
+
+        luaState["scene"] = sceneTable;
+        # pragma endregion
+
         #pragma region Bind Entity Functions
 
         luaState.new_usertype<Entity>("Entity",
@@ -416,6 +465,7 @@ namespace Coffee {
             sol::constructors<MeshComponent(), MeshComponent(Ref<Mesh>)>(),
             "mesh", &MeshComponent::mesh,
             "drawAABB", &MeshComponent::drawAABB,
+            "isOccluder", &MeshComponent::isOccluder,
             "get_mesh", &MeshComponent::GetMesh
         );
 
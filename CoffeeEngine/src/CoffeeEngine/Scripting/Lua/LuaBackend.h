@@ -10,6 +10,8 @@
 
 namespace Coffee {
 
+    class Scene;
+
     struct LuaVariable {
         std::string name;
         std::string value;
@@ -26,8 +28,17 @@ namespace Coffee {
             void BindFunction(const std::string& script, const std::string& name, std::function<int()>& func) override;
             void RegisterVariable(const std::string& name, void* variable) override;
             static std::vector<LuaVariable> MapVariables(const std::string& script);
+
+            /**
+             * @brief Sets the scene the spatial queries of the scripts run on.
+             * @param scene The running scene, or nullptr.
+             */
+            static void SetActiveScene(Scene* scene) { activeScene = scene; }
+            static Scene* GetActiveScene() { return activeScene; }
+
             static sol::state luaState;
             static std::unordered_map<std::string, sol::environment> scriptEnvironments;
+            static Scene* activeScene;
     };
 
 } // namespace Coffee
\ No newline at end of file
@@ -292,6 +292,22 @@ input = {
 -- Timer functions
 -- Add timer functions here if any
 
+-- Scene query functions
+scene = {
+    raycast = function(originX, originY, originZ, directionX, directionY, directionZ, maxDistance)
+        -- Returns the entity hit, the distance and the hit point, or nil
+        return nil
+    end,
+    overlap_sphere = function(centerX, centerY, centerZ, radius)
+        -- Returns the entities whose bounds overlap the sphere
+        return {}
+    end,
+    overlap_box = function(minX, minY, minZ, maxX, maxY, maxZ)
+        -- Returns the entities whose bounds overlap the box
+        return {}
+    end
+}
+
 -- Component stubs
 TagComponent = {
     Tag = ""
@@ -324,6 +340,7 @@ CameraComponent = {
 MeshComponent = {
     mesh = {},
     drawAABB = false,
+    isOccluder = false,
     GetMesh = function()
         -- Implementation here
         return {}
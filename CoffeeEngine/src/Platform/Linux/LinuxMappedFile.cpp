@@ -0,0 +1,50 @@
+#include "CoffeeEngine/IO/MappedFile.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Coffee {
+
+    bool MappedFile::Open(const std::filesystem::path& path)
+    {
+        Close();
+
+        int file = open(path.c_str(), O_RDONLY);
+        if (file == -1)
+            return false;
+
+        struct stat status;
+        if (fstat(file, &status) == -1 || status.st_size == 0)
+        {
+            close(file);
+            return false;
+        }
+
+        void* data = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        // The mapping keeps its own reference to the file
+        close(file);
+
+        if (data == MAP_FAILED)
+            return false;
+
+        m_Data = static_cast<const uint8_t*>(data);
+        m_Size = status.st_size;
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data)
+            munmap(const_cast<uint8_t*>(m_Data), m_Size);
+
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+}
+
+#endif
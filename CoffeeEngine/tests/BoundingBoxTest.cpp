@@ -0,0 +1,119 @@
+/**
+ * @file BoundingBoxTest.cpp
+ * @brief Checks the batched TransformAABBs against AABB::CalculateTransformedAABB and the corners of the boxes.
+ */
+
+#include "Test.h"
+
+#include "CoffeeEngine/Math/BoundingBox.h"
+
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+using namespace Coffee;
+
+static constexpr float Epsilon = 1e-3f;
+
+static bool NearlyEqual(const glm::vec3& a, const glm::vec3& b)
+{
+    glm::vec3 difference = glm::abs(a - b);
+    return difference.x <= Epsilon && difference.y <= Epsilon && difference.z <= Epsilon;
+}
+
+static bool NearlyEqual(const AABB& a, const AABB& b)
+{
+    return NearlyEqual(a.min, b.min) && NearlyEqual(a.max, b.max);
+}
+
+static void TestSimpleTransforms()
+{
+    AABB box(glm::vec3(-1.0f, -2.0f, -3.0f), glm::vec3(1.0f, 2.0f, 3.0f));
+
+    AABB identity;
+    glm::mat4 identityTransform(1.0f);
+    TransformAABBs(&box, &identityTransform, &identity, 1);
+    COFFEE_CHECK(NearlyEqual(identity, box));
+
+    AABB moved;
+    glm::mat4 translation = glm::translate(glm::mat4(1.0f), glm::vec3(10.0f, 0.0f, -5.0f));
+    TransformAABBs(&box, &translation, &moved, 1);
+    COFFEE_CHECK(NearlyEqual(moved, AABB(glm::vec3(9.0f, -2.0f, -8.0f), glm::vec3(11.0f, 2.0f, -2.0f))));
+
+    // A quarter turn around Y swaps the x and z extents
+    AABB turned;
+    glm::mat4 rotation = glm::rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    TransformAABBs(&box, &rotation, &turned, 1);
+    COFFEE_CHECK(NearlyEqual(turned, AABB(glm::vec3(-3.0f, -2.0f, -1.0f), glm::vec3(3.0f, 2.0f, 1.0f))));
+
+    // Negative scale mirrors the box without turning it inside out
+    AABB mirrored;
+    glm::mat4 mirror = glm::scale(glm::mat4(1.0f), glm::vec3(-2.0f, 1.0f, 1.0f));
+    TransformAABBs(&box, &mirror, &mirrored, 1);
+    COFFEE_CHECK(NearlyEqual(mirrored, AABB(glm::vec3(-2.0f, -2.0f, -3.0f), glm::vec3(2.0f, 2.0f, 3.0f))));
+}
+
+static void TestMatchesSingleTransform()
+{
+    std::mt19937 random(42);
+    std::uniform_real_distribution<float> position(-50.0f, 50.0f);
+    std::uniform_real_distribution<float> size(0.01f, 10.0f);
+    std::uniform_real_distribution<float> angle(-3.14159f, 3.14159f);
+    std::uniform_real_distribution<float> scale(0.1f, 4.0f);
+
+    const uint32_t count = 1000;
+    std::vector<AABB> boxes(count);
+    std::vector<glm::mat4> transforms(count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        glm::vec3 center(position(random), position(random), position(random));
+        glm::vec3 halfSize(size(random), size(random), size(random));
+        boxes[i] = AABB(center - halfSize, center + halfSize);
+
+        glm::vec3 axis = glm::normalize(glm::vec3(position(random), position(random), position(random)) + glm::vec3(0.001f));
+        transforms[i] = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+        transforms[i] = glm::rotate(transforms[i], angle(random), axis);
+        transforms[i] = glm::scale(transforms[i], glm::vec3(scale(random), scale(random), scale(random)));
+    }
+
+    std::vector<AABB> transformed(count);
+    TransformAABBs(boxes.data(), transforms.data(), transformed.data(), count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        COFFEE_CHECK(NearlyEqual(transformed[i], boxes[i].CalculateTransformedAABB(transforms[i])));
+
+        // Tight: every corner is inside, and some corner reaches each face
+        glm::vec3 reached = glm::vec3(0.0f);
+        glm::vec3 reachedMin = glm::vec3(0.0f);
+        for (int corner = 0; corner < 8; ++corner)
+        {
+            glm::vec3 local((corner & 1) ? boxes[i].max.x : boxes[i].min.x, (corner & 2) ? boxes[i].max.y : boxes[i].min.y,
+                            (corner & 4) ? boxes[i].max.z : boxes[i].min.z);
+            glm::vec3 world = glm::vec3(transforms[i] * glm::vec4(local, 1.0f));
+
+            COFFEE_CHECK(NearlyEqual(glm::max(world, transformed[i].max), transformed[i].max));
+            COFFEE_CHECK(NearlyEqual(glm::min(world, transformed[i].min), transformed[i].min));
+            reached = glm::max(reached, glm::vec3(glm::lessThan(glm::abs(world - transformed[i].max), glm::vec3(Epsilon))));
+            reachedMin = glm::max(reachedMin, glm::vec3(glm::lessThan(glm::abs(world - transformed[i].min), glm::vec3(Epsilon))));
+        }
+        COFFEE_CHECK(reached == glm::vec3(1.0f) && reachedMin == glm::vec3(1.0f));
+    }
+
+    // The output may alias the input
+    std::vector<AABB> inPlace = boxes;
+    TransformAABBs(inPlace.data(), transforms.data(), inPlace.data(), count);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        COFFEE_CHECK(NearlyEqual(inPlace[i], transformed[i]));
+    }
+}
+
+int main()
+{
+    TestSimpleTransforms();
+    TestMatchesSingleTransform();
+
+    return Test::Result();
+}
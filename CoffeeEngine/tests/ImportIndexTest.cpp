@@ -0,0 +1,130 @@
+/**
+ * @file ImportIndexTest.cpp
+ * @brief Saves and loads the ImportIndex, and checks that outdated or damaged index files are rejected.
+ */
+
+#include "Test.h"
+
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/IO/ImportIndex.h"
+
+#include <cereal/archives/binary.hpp>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace Coffee;
+
+static const std::filesystem::path s_ProjectDirectory = std::filesystem::temp_directory_path() / "CoffeeImportIndexTest";
+static const std::filesystem::path s_IndexPath = s_ProjectDirectory / "Cache" / "ImportIndex.bin";
+
+static ImportEntry MakeEntry(uint64_t uuid, const std::string& name)
+{
+    ImportEntry entry;
+    entry.uuid = UUID(uuid);
+    entry.type = ResourceType::Texture;
+    entry.sourcePath = "Textures/" + name + ".png";
+    entry.importPath = "Textures/" + name + ".import";
+    entry.cachePath = name + ".res";
+    entry.sourceHash = uuid * 31;
+    entry.sourceTime = static_cast<int64_t>(uuid) * 1000;
+    entry.importTime = static_cast<int64_t>(uuid) * 2000;
+    return entry;
+}
+
+static bool SameEntry(const ImportEntry& a, const ImportEntry& b)
+{
+    return a.uuid == b.uuid && a.type == b.type && a.sourcePath == b.sourcePath && a.importPath == b.importPath &&
+           a.cachePath == b.cachePath && a.sourceHash == b.sourceHash && a.sourceTime == b.sourceTime &&
+           a.importTime == b.importTime;
+}
+
+static void TestRoundTrip()
+{
+    COFFEE_CHECK(!ImportIndex::Load(s_IndexPath, s_ProjectDirectory));
+    COFFEE_CHECK(ImportIndex::GetCount() == 0);
+
+    for (uint64_t i = 1; i <= 100; ++i)
+    {
+        ImportIndex::Add(MakeEntry(i, "Texture" + std::to_string(i)));
+    }
+
+    // A regenerated .import file gives the same texture a new UUID, the old entry goes
+    ImportIndex::Add(MakeEntry(1000, "Texture1"));
+    ImportIndex::Remove(UUID(2));
+    COFFEE_CHECK(ImportIndex::GetCount() == 99);
+
+    ImportIndex::Save();
+    COFFEE_CHECK(std::filesystem::exists(s_IndexPath));
+
+    ImportIndex::Clear();
+    COFFEE_CHECK(ImportIndex::Load(s_IndexPath, s_ProjectDirectory));
+    COFFEE_CHECK(ImportIndex::GetCount() == 99);
+
+    ImportEntry entry;
+    COFFEE_CHECK(!ImportIndex::Find(UUID(1), entry));
+    COFFEE_CHECK(!ImportIndex::Find(UUID(2), entry));
+    COFFEE_CHECK(ImportIndex::Find(UUID(1000), entry) && SameEntry(entry, MakeEntry(1000, "Texture1")));
+    COFFEE_CHECK(ImportIndex::Find(UUID(50), entry) && SameEntry(entry, MakeEntry(50, "Texture50")));
+
+    // Either the resource or its .import file finds the entry
+    COFFEE_CHECK(ImportIndex::Find(s_ProjectDirectory / "Textures/Texture3.png", entry) && entry.uuid == UUID(3));
+    COFFEE_CHECK(ImportIndex::Find(s_ProjectDirectory / "Textures/Texture3.import", entry) && entry.uuid == UUID(3));
+    COFFEE_CHECK(!ImportIndex::Find(s_ProjectDirectory / "Textures/Texture2.png", entry));
+
+    // Unchanged since it was loaded, nothing is written
+    std::filesystem::remove(s_IndexPath);
+    ImportIndex::Save();
+    COFFEE_CHECK(!std::filesystem::exists(s_IndexPath));
+}
+
+static void TestOutdatedVersion()
+{
+    ImportIndex::Load(s_IndexPath, s_ProjectDirectory);
+    ImportIndex::Add(MakeEntry(1, "Texture1"));
+    ImportIndex::Save();
+
+    // Same magic, previous version
+    std::ifstream input(s_IndexPath, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    input.close();
+
+    std::string outdated = content;
+    outdated[4] = static_cast<char>(outdated[4] - 1);
+    std::ofstream(s_IndexPath, std::ios::binary | std::ios::trunc) << outdated;
+
+    COFFEE_CHECK(!ImportIndex::Load(s_IndexPath, s_ProjectDirectory));
+    COFFEE_CHECK(ImportIndex::GetCount() == 0);
+
+    // Not an index at all
+    {
+        std::ofstream file(s_IndexPath, std::ios::binary | std::ios::trunc);
+        cereal::BinaryOutputArchive archive(file);
+        archive(uint32_t(0x12345678), uint32_t(2));
+    }
+    COFFEE_CHECK(!ImportIndex::Load(s_IndexPath, s_ProjectDirectory));
+    COFFEE_CHECK(ImportIndex::GetCount() == 0);
+
+    // Cut short in the middle of the entries
+    std::ofstream(s_IndexPath, std::ios::binary | std::ios::trunc) << content.substr(0, content.size() / 2);
+    COFFEE_CHECK(!ImportIndex::Load(s_IndexPath, s_ProjectDirectory));
+    COFFEE_CHECK(ImportIndex::GetCount() == 0);
+
+    // The intact file still loads
+    std::ofstream(s_IndexPath, std::ios::binary | std::ios::trunc) << content;
+    COFFEE_CHECK(ImportIndex::Load(s_IndexPath, s_ProjectDirectory));
+    COFFEE_CHECK(ImportIndex::GetCount() == 1);
+}
+
+int main()
+{
+    Log::Init();
+
+    std::filesystem::remove_all(s_ProjectDirectory);
+
+    TestRoundTrip();
+    TestOutdatedVersion();
+
+    std::filesystem::remove_all(s_ProjectDirectory);
+    return Test::Result();
+}
@@ -0,0 +1,176 @@
+/**
+ * @file LightClusterGridTest.cpp
+ * @brief Checks the CPU light assignment of LightClusterGrid against its own cluster bounds.
+ */
+
+#include "Test.h"
+
+#include "CoffeeEngine/Renderer/LightClusterGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <vector>
+
+using namespace Coffee;
+
+static constexpr float NearClip = 0.1f;
+static constexpr float FarClip = 100.0f;
+
+static const glm::mat4 s_Projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, NearClip, FarClip);
+static const glm::mat4 s_View = glm::mat4(1.0f); // Looking down -Z from the origin
+
+static LightComponent MakeLight(LightComponent::Type type, const glm::vec3& position, float range)
+{
+    LightComponent light;
+    light.type = static_cast<int>(type);
+    light.Position = position;
+    light.Range = range;
+    return light;
+}
+
+static bool ClusterHasLight(const LightClusterGrid& grid, uint32_t cluster, uint32_t lightIndex)
+{
+    const LightClusterRange& range = grid.GetClusterRanges()[cluster];
+    const std::vector<uint32_t>& indices = grid.GetLightIndices();
+    return std::find(indices.begin() + range.Offset, indices.begin() + range.Offset + range.Count, lightIndex) !=
+           indices.begin() + range.Offset + range.Count;
+}
+
+static void TestDepthSlices()
+{
+    LightClusterGrid grid;
+    std::vector<LightComponent> lights;
+    grid.Build(s_Projection, s_View, NearClip, FarClip, lights);
+
+    COFFEE_CHECK(grid.GetDepthSlice(NearClip * 0.5f) == 0);
+    COFFEE_CHECK(grid.GetDepthSlice(NearClip) == 0);
+    COFFEE_CHECK(grid.GetDepthSlice(FarClip * 0.999f) == LightClusterGrid::GridSizeZ - 1);
+    COFFEE_CHECK(grid.GetDepthSlice(FarClip * 10.0f) == LightClusterGrid::GridSizeZ - 1);
+
+    // The middle of every slice, as bounded by the cluster boxes, maps back to that slice
+    for (uint32_t z = 0; z < LightClusterGrid::GridSizeZ; ++z)
+    {
+        const AABB& bounds = grid.GetClusterBounds(z * LightClusterGrid::GridSizeX * LightClusterGrid::GridSizeY);
+        float sliceNear = -bounds.max.z;
+        float sliceFar = -bounds.min.z;
+        COFFEE_CHECK(grid.GetDepthSlice(std::sqrt(sliceNear * sliceFar)) == z);
+    }
+
+    uint32_t previous = 0;
+    for (float depth = NearClip; depth < FarClip; depth *= 1.05f)
+    {
+        uint32_t slice = grid.GetDepthSlice(depth);
+        COFFEE_CHECK(slice >= previous);
+        previous = slice;
+    }
+}
+
+static void TestDirectionalLightsComeFirst()
+{
+    LightClusterGrid grid;
+    std::vector<LightComponent> lights = {
+        MakeLight(LightComponent::PointLight, {0.0f, 0.0f, -10.0f}, 2.0f),
+        MakeLight(LightComponent::DirectionalLight, {0.0f, 0.0f, -10.0f}, 2.0f),
+        MakeLight(LightComponent::SpotLight, {0.0f, 0.0f, -20.0f}, 2.0f),
+    };
+    grid.Build(s_Projection, s_View, NearClip, FarClip, lights);
+
+    COFFEE_CHECK(grid.GetDirectionalLightCount() == 1);
+    COFFEE_CHECK(lights[0].type == LightComponent::DirectionalLight);
+    COFFEE_CHECK(lights[1].type == LightComponent::PointLight);
+    COFFEE_CHECK(lights[2].type == LightComponent::SpotLight);
+
+    // Directional lights affect every cluster without being listed
+    const std::vector<uint32_t>& indices = grid.GetLightIndices();
+    COFFEE_CHECK(std::find(indices.begin(), indices.end(), 0u) == indices.end());
+    COFFEE_CHECK(std::find(indices.begin(), indices.end(), 1u) != indices.end());
+    COFFEE_CHECK(std::find(indices.begin(), indices.end(), 2u) != indices.end());
+}
+
+static void TestLightPlacement()
+{
+    LightClusterGrid grid;
+    std::vector<LightComponent> lights = {
+        MakeLight(LightComponent::PointLight, {0.0f, 0.0f, -10.0f}, 1.0f),
+        MakeLight(LightComponent::PointLight, {0.0f, 0.0f, 10.0f}, 1.0f),
+        MakeLight(LightComponent::PointLight, {0.0f, 0.0f, -500.0f}, 1.0f),
+    };
+    grid.Build(s_Projection, s_View, NearClip, FarClip, lights);
+
+    // In front of the camera: in the center cluster at its depth, not in the corner one
+    COFFEE_CHECK(ClusterHasLight(grid, grid.GetClusterIndex({0.5f, 0.5f}, 10.0f), 0));
+    COFFEE_CHECK(!ClusterHasLight(grid, grid.GetClusterIndex({0.0f, 0.0f}, 10.0f), 0));
+    COFFEE_CHECK(!ClusterHasLight(grid, grid.GetClusterIndex({0.5f, 0.5f}, 50.0f), 0));
+
+    // Behind the camera and past the far plane: nowhere
+    const std::vector<uint32_t>& indices = grid.GetLightIndices();
+    COFFEE_CHECK(std::find(indices.begin(), indices.end(), 1u) == indices.end());
+    COFFEE_CHECK(std::find(indices.begin(), indices.end(), 2u) == indices.end());
+}
+
+static void TestAssignmentsMatchBounds()
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> side(-40.0f, 40.0f);
+    std::uniform_real_distribution<float> depth(-120.0f, 5.0f);
+    std::uniform_real_distribution<float> range(0.5f, 8.0f);
+
+    std::vector<LightComponent> lights;
+    for (int i = 0; i < 256; ++i)
+    {
+        lights.push_back(MakeLight(LightComponent::PointLight, {side(random), side(random), depth(random)}, range(random)));
+    }
+
+    LightClusterGrid grid;
+    grid.Build(s_Projection, s_View, NearClip, FarClip, lights);
+
+    const std::vector<LightClusterRange>& ranges = grid.GetClusterRanges();
+    const std::vector<uint32_t>& indices = grid.GetLightIndices();
+
+    // The ranges tile the index list, and every listed light touches its cluster
+    uint32_t offset = 0;
+    for (uint32_t cluster = 0; cluster < LightClusterGrid::ClusterCount; ++cluster)
+    {
+        COFFEE_CHECK(ranges[cluster].Offset == offset);
+        offset += ranges[cluster].Count;
+
+        const AABB& bounds = grid.GetClusterBounds(cluster);
+        for (uint32_t i = ranges[cluster].Offset; i < ranges[cluster].Offset + ranges[cluster].Count; ++i)
+        {
+            if (i > ranges[cluster].Offset)
+                COFFEE_CHECK(indices[i - 1] < indices[i]);
+
+            const LightComponent& light = lights[indices[i]];
+            glm::vec3 delta = glm::clamp(light.Position, bounds.min, bounds.max) - light.Position;
+            COFFEE_CHECK(glm::dot(delta, delta) <= light.Range * light.Range);
+        }
+    }
+    COFFEE_CHECK(offset == indices.size());
+
+    // A light inside the view volume is listed in the cluster that contains its center
+    for (uint32_t lightIndex = 0; lightIndex < lights.size(); ++lightIndex)
+    {
+        const LightComponent& light = lights[lightIndex];
+        glm::vec4 clip = s_Projection * glm::vec4(light.Position, 1.0f);
+        glm::vec3 ndc = glm::vec3(clip) / clip.w;
+        float lightDepth = -light.Position.z;
+
+        if (lightDepth <= NearClip || lightDepth >= FarClip || glm::abs(ndc.x) >= 1.0f || glm::abs(ndc.y) >= 1.0f)
+            continue;
+
+        uint32_t cluster = grid.GetClusterIndex(glm::vec2(ndc) * 0.5f + 0.5f, lightDepth);
+        COFFEE_CHECK(ClusterHasLight(grid, cluster, lightIndex));
+    }
+}
+
+int main()
+{
+    TestDepthSlices();
+    TestDirectionalLightsComeFirst();
+    TestLightPlacement();
+    TestAssignmentsMatchBounds();
+
+    return Test::Result();
+}
@@ -0,0 +1,140 @@
+/**
+ * @file OcclusionCullerTest.cpp
+ * @brief Rasterizes occluder quads with OcclusionCuller and checks its depth buffer and visibility tests.
+ */
+
+#include "Test.h"
+
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Renderer/Mesh.h"
+#include "CoffeeEngine/Renderer/OcclusionCuller.h"
+#include "CoffeeEngine/Renderer/UploadQueue.h"
+
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+using namespace Coffee;
+
+// Same aspect as the depth buffer, looking down -Z from the origin
+static const glm::mat4 s_ViewProjection = glm::perspective(glm::radians(60.0f), 2.0f, 0.1f, 100.0f);
+
+// A quad facing the camera at the given depth, covering [min, max] in x and y
+static Ref<Mesh> CreateQuad(const glm::vec2& min, const glm::vec2& max, float z)
+{
+    std::vector<Vertex> vertices(4);
+    vertices[0].Position = {min.x, min.y, z};
+    vertices[1].Position = {max.x, min.y, z};
+    vertices[2].Position = {max.x, max.y, z};
+    vertices[3].Position = {min.x, max.y, z};
+    std::vector<uint32_t> indices = {0, 1, 2, 2, 3, 0};
+
+    // Deferred, the test has no graphics context to upload to
+    UploadQueue::DeferScope deferScope;
+    return CreateRef<Mesh>(vertices, indices);
+}
+
+static AABB MakeBox(const glm::vec3& center, float halfSize)
+{
+    return AABB(center - glm::vec3(halfSize), center + glm::vec3(halfSize));
+}
+
+static void TestWithoutOccluders()
+{
+    OcclusionCuller culler;
+    culler.Begin(s_ViewProjection);
+    culler.Rasterize();
+
+    COFFEE_CHECK(culler.IsVisible(MakeBox({0.0f, 0.0f, -50.0f}, 1.0f)));
+    COFFEE_CHECK(culler.GetStats().CulledCount == 0);
+}
+
+static void TestFullScreenOccluder()
+{
+    Ref<Mesh> wall = CreateQuad({-100.0f, -100.0f}, {100.0f, 100.0f}, -10.0f);
+
+    OcclusionCuller culler;
+    culler.Begin(s_ViewProjection);
+    culler.AddOccluder(*wall, glm::mat4(1.0f));
+    culler.Rasterize();
+
+    COFFEE_CHECK(culler.GetStats().OccluderCount == 1);
+    COFFEE_CHECK(culler.GetStats().OccluderTriangles == 2);
+
+    // The depth stored is 1/w, the distance to the wall everywhere
+    const std::vector<float>& depth = culler.GetDepthBuffer();
+    for (uint32_t pixel : {0u, OcclusionCuller::Width / 2 + OcclusionCuller::Height / 2 * OcclusionCuller::Width,
+                           OcclusionCuller::Width * OcclusionCuller::Height - 1})
+    {
+        COFFEE_CHECK(std::abs(depth[pixel] - 0.1f) < 1e-4f);
+    }
+
+    COFFEE_CHECK(!culler.IsVisible(MakeBox({0.0f, 0.0f, -30.0f}, 1.0f)));
+    COFFEE_CHECK(!culler.IsVisible(MakeBox({5.0f, 2.0f, -60.0f}, 3.0f)));
+    COFFEE_CHECK(culler.IsVisible(MakeBox({0.0f, 0.0f, -5.0f}, 1.0f)));
+
+    // Crossing the wall, or the near plane, is always visible
+    COFFEE_CHECK(culler.IsVisible(MakeBox({0.0f, 0.0f, -10.0f}, 1.0f)));
+    COFFEE_CHECK(culler.IsVisible(MakeBox({0.0f, 0.0f, 0.0f}, 1.0f)));
+
+    COFFEE_CHECK(culler.GetStats().TestedCount == 5);
+    COFFEE_CHECK(culler.GetStats().CulledCount == 2);
+
+    // Disabled, nothing is culled
+    culler.SetEnabled(false);
+    COFFEE_CHECK(culler.IsVisible(MakeBox({0.0f, 0.0f, -30.0f}, 1.0f)));
+}
+
+static void TestPartialOccluder()
+{
+    // Covers the left half of the screen at its depth, the right half shows through
+    Ref<Mesh> wall = CreateQuad({-100.0f, -100.0f}, {0.0f, 100.0f}, -10.0f);
+
+    OcclusionCuller culler;
+    culler.Begin(s_ViewProjection);
+    culler.AddOccluder(*wall, glm::mat4(1.0f));
+    culler.Rasterize();
+
+    COFFEE_CHECK(!culler.IsVisible(MakeBox({-20.0f, 0.0f, -40.0f}, 2.0f)));
+    COFFEE_CHECK(culler.IsVisible(MakeBox({20.0f, 0.0f, -40.0f}, 2.0f)));
+    COFFEE_CHECK(culler.IsVisible(MakeBox({0.0f, 0.0f, -40.0f}, 2.0f)));
+
+    // The next pass starts empty
+    culler.Begin(s_ViewProjection);
+    culler.Rasterize();
+    COFFEE_CHECK(culler.IsVisible(MakeBox({-20.0f, 0.0f, -40.0f}, 2.0f)));
+}
+
+static void TestTransformedOccluder()
+{
+    // The same wall, built at the origin and moved in place by its transform, turned to face either way
+    Ref<Mesh> wall = CreateQuad({-100.0f, -100.0f}, {100.0f, 100.0f}, 0.0f);
+
+    for (float angle : {0.0f, 180.0f})
+    {
+        glm::mat4 transform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -10.0f));
+        transform = glm::rotate(transform, glm::radians(angle), glm::vec3(0.0f, 1.0f, 0.0f));
+
+        OcclusionCuller culler;
+        culler.Begin(s_ViewProjection);
+        culler.AddOccluder(*wall, transform);
+        culler.Rasterize();
+
+        COFFEE_CHECK(!culler.IsVisible(MakeBox({0.0f, 0.0f, -30.0f}, 1.0f)));
+        COFFEE_CHECK(culler.IsVisible(MakeBox({0.0f, 0.0f, -5.0f}, 1.0f)));
+    }
+}
+
+int main()
+{
+    // The tiles are rasterized on the workers
+    JobSystem::Init();
+
+    TestWithoutOccluders();
+    TestFullScreenOccluder();
+    TestPartialOccluder();
+    TestTransformedOccluder();
+
+    JobSystem::Shutdown();
+    return Test::Result();
+}
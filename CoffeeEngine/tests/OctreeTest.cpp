@@ -0,0 +1,183 @@
+/**
+ * @file OctreeTest.cpp
+ * @brief Checks that the octree node pool is reused as objects come and go, that Clear empties the tree, and
+ * that the queries match a brute force search throughout.
+ */
+
+#include "Test.h"
+
+#include "CoffeeEngine/Core/DataStructures/Octree.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+using namespace Coffee;
+
+static const AABB s_Bounds(glm::vec3(-50.0f), glm::vec3(50.0f));
+
+static AABB MakeBox(const glm::vec3& center, float halfSize)
+{
+    return AABB(center - glm::vec3(halfSize), center + glm::vec3(halfSize));
+}
+
+static bool Overlaps(const AABB& a, const AABB& b)
+{
+    return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+}
+
+static std::set<uint32_t> QueryBox(const Octree<uint32_t>& octree, const AABB& box)
+{
+    std::set<uint32_t> found;
+    octree.Query(box, [&](uint32_t object, const AABB&) { COFFEE_CHECK(found.insert(object).second); });
+    return found;
+}
+
+// Small boxes packed in a corner, enough to subdivide down to the maximum depth
+static std::vector<AABB> MakeCluster(uint32_t count)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-45.0f, -35.0f);
+
+    std::vector<AABB> boxes;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        boxes.push_back(MakeBox({position(random), position(random), position(random)}, 0.05f));
+    }
+    return boxes;
+}
+
+static void TestNodesAreReused()
+{
+    Octree<uint32_t> octree(s_Bounds, 4, 5);
+    COFFEE_CHECK(octree.GetNodeCount() == 1);
+
+    std::vector<AABB> boxes = MakeCluster(200);
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+    {
+        octree.Insert({i, boxes[i]});
+    }
+
+    const size_t subdividedCount = octree.GetNodeCount();
+    COFFEE_CHECK(subdividedCount > 1);
+    COFFEE_CHECK((subdividedCount - 1) % 8 == 0);
+
+    // Emptying the tree returns every block of children to the pool
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+    {
+        COFFEE_CHECK(octree.Remove(i));
+    }
+    COFFEE_CHECK(octree.Size() == 0);
+    COFFEE_CHECK(octree.GetNodeCount() == 1);
+    COFFEE_CHECK(!octree.Remove(0));
+
+    // The same objects again take the released blocks and end up in the same shape
+    for (int pass = 0; pass < 3; ++pass)
+    {
+        for (uint32_t i = 0; i < boxes.size(); ++i)
+        {
+            octree.Insert({i, boxes[i]});
+        }
+        COFFEE_CHECK(octree.GetNodeCount() == subdividedCount);
+        COFFEE_CHECK(QueryBox(octree, s_Bounds).size() == boxes.size());
+
+        for (uint32_t i = 0; i < boxes.size(); ++i)
+        {
+            octree.Remove(i);
+        }
+        COFFEE_CHECK(octree.GetNodeCount() == 1);
+    }
+}
+
+static void TestClear()
+{
+    Octree<uint32_t> octree(s_Bounds, 4, 5);
+
+    std::vector<AABB> boxes = MakeCluster(100);
+    for (uint32_t i = 0; i < boxes.size(); ++i)
+    {
+        octree.Insert({i, boxes[i]});
+    }
+
+    // Also an object outside of the bounds, kept by the root
+    octree.Insert({1000, MakeBox({200.0f, 0.0f, 0.0f}, 1.0f)});
+    COFFEE_CHECK(octree.Size() == boxes.size() + 1);
+
+    octree.Clear();
+    COFFEE_CHECK(octree.Size() == 0);
+    COFFEE_CHECK(octree.GetNodeCount() == 1);
+    COFFEE_CHECK(!octree.Contains(0));
+    COFFEE_CHECK(!octree.Contains(1000));
+    COFFEE_CHECK(QueryBox(octree, AABB(glm::vec3(-500.0f), glm::vec3(500.0f))).empty());
+
+    // Still usable, with the same bounds
+    octree.Insert({1, boxes[1]});
+    COFFEE_CHECK(octree.Contains(1));
+    COFFEE_CHECK(QueryBox(octree, boxes[1]) == std::set<uint32_t>{1});
+}
+
+static void TestMatchesBruteForce()
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> position(-70.0f, 70.0f);
+    std::uniform_real_distribution<float> size(0.05f, 8.0f);
+    std::uniform_int_distribution<uint32_t> object(0, 299);
+    std::uniform_int_distribution<int> operation(0, 3);
+
+    Octree<uint32_t> octree(s_Bounds, 4, 5);
+    std::map<uint32_t, AABB> reference;
+    size_t largestNodeCount = 0;
+
+    for (int step = 0; step < 20000; ++step)
+    {
+        uint32_t id = object(random);
+        switch (operation(random))
+        {
+        case 0:
+        case 1: {
+            AABB box = MakeBox({position(random), position(random), position(random)}, size(random));
+            octree.Update(id, box);
+            reference[id] = box;
+            break;
+        }
+        case 2:
+            COFFEE_CHECK(octree.Remove(id) == (reference.erase(id) == 1));
+            break;
+        default: {
+            AABB box = MakeBox({position(random), position(random), position(random)}, size(random) * 4.0f);
+
+            std::set<uint32_t> expected;
+            for (const auto& [referenceId, referenceBox] : reference)
+            {
+                if (Overlaps(referenceBox, box))
+                    expected.insert(referenceId);
+            }
+
+            COFFEE_CHECK(QueryBox(octree, box) == expected);
+            break;
+        }
+        }
+
+        COFFEE_CHECK(octree.Size() == reference.size());
+        largestNodeCount = std::max(largestNodeCount, octree.GetNodeCount());
+    }
+
+    // Removing everything left gives back all the blocks
+    for (const auto& [id, box] : reference)
+    {
+        octree.Remove(id);
+    }
+    COFFEE_CHECK(octree.GetNodeCount() == 1);
+    COFFEE_CHECK(largestNodeCount > 1);
+}
+
+int main()
+{
+    TestNodesAreReused();
+    TestClear();
+    TestMatchesBruteForce();
+
+    return Test::Result();
+}
@@ -0,0 +1,100 @@
+/**
+ * @file ResourceRegistryTest.cpp
+ * @brief Checks that the names interned by ResourceRegistry are released once no entry or name index key uses
+ * them, as resources are added, renamed, replaced and removed.
+ */
+
+#include "Test.h"
+
+#include "CoffeeEngine/IO/Resource.h"
+#include "CoffeeEngine/IO/ResourceRegistry.h"
+
+#include <string>
+
+using namespace Coffee;
+
+static Ref<Resource> CreateResource(const std::string& name)
+{
+    Ref<Resource> resource = CreateRef<Resource>(ResourceType::Texture);
+    resource->SetName(name);
+    return resource;
+}
+
+static void TestSharedName()
+{
+    ResourceRegistry::Add(UUID(1), CreateResource("Rock"));
+    ResourceRegistry::Add(UUID(2), CreateResource("Rock"));
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 1);
+    COFFEE_CHECK(ResourceRegistry::GetUUIDByName("Rock") == UUID(2));
+
+    // The name index still maps to the second resource, the name stays
+    ResourceRegistry::Remove(UUID(1));
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 1);
+    COFFEE_CHECK(ResourceRegistry::GetUUIDByName("Rock") == UUID(2));
+
+    ResourceRegistry::Remove(UUID(2));
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 0);
+    COFFEE_CHECK(!ResourceRegistry::Exists("Rock"));
+
+    // Removed in the other order, the first resource keeps the name once the index moved on
+    ResourceRegistry::Add(UUID(1), CreateResource("Rock"));
+    ResourceRegistry::Add(UUID(2), CreateResource("Rock"));
+    ResourceRegistry::Remove(UUID(2));
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 1);
+    COFFEE_CHECK(ResourceRegistry::GetUUIDByName("Rock") == UUID::null);
+    COFFEE_CHECK(ResourceRegistry::Exists(UUID(1)));
+
+    ResourceRegistry::Remove(UUID(1));
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 0);
+}
+
+static void TestRename()
+{
+    ResourceRegistry::Add(UUID(10), CreateResource("Old"));
+    ResourceRegistry::Add(UUID(10), CreateResource("New"));
+
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 1);
+    COFFEE_CHECK(ResourceRegistry::GetUUIDByName("Old") == UUID::null);
+    COFFEE_CHECK(ResourceRegistry::GetUUIDByName("New") == UUID(10));
+
+    // Replacing with the same name keeps a single reference per use
+    ResourceRegistry::Add(UUID(10), CreateResource("New"));
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 1);
+
+    ResourceRegistry::Remove(UUID(10));
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 0);
+    COFFEE_CHECK(!ResourceRegistry::Exists(UUID(10)));
+}
+
+static void TestChurn()
+{
+    // Many short lived names, none of them may be left behind
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        ResourceRegistry::Add(UUID(100 + i), CreateResource("Resource" + std::to_string(i)));
+        ResourceRegistry::Add(UUID(100 + i), CreateResource("Renamed" + std::to_string(i)));
+        if (i % 2 == 0)
+            ResourceRegistry::Remove(UUID(100 + i - 1));
+    }
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 500);
+
+    for (uint64_t i = 1; i <= 1000; ++i)
+    {
+        ResourceRegistry::Remove(UUID(100 + i));
+    }
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 0);
+
+    ResourceRegistry::Add(UUID(1), CreateResource("Cleared"));
+    ResourceRegistry::Clear();
+    COFFEE_CHECK(ResourceRegistry::GetInternedNameCount() == 0);
+    COFFEE_CHECK(!ResourceRegistry::Exists("Cleared"));
+}
+
+int main()
+{
+    TestSharedName();
+    TestRename();
+    TestChurn();
+
+    return Test::Result();
+}
@@ -0,0 +1,172 @@
+/**
+ * @file SceneSerializationTest.cpp
+ * @brief Saves scenes and loads them back, in both formats, and checks that truncated or damaged binary scene
+ * files are rejected instead of read past their end.
+ */
+
+#include "Test.h"
+
+#include "CoffeeEngine/Core/JobSystem.h"
+#include "CoffeeEngine/Core/Log.h"
+#include "CoffeeEngine/Scene/Components.h"
+#include "CoffeeEngine/Scene/Entity.h"
+#include "CoffeeEngine/Scene/Scene.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace Coffee;
+
+static const std::filesystem::path s_Directory = std::filesystem::temp_directory_path() / "CoffeeSceneSerializationTest";
+
+static constexpr uint32_t EntityCount = 50;
+
+// Every fifth entity is a root, the others hang from the previous root, and every third one is a light
+static Ref<Scene> CreateTestScene()
+{
+    Ref<Scene> scene = CreateRef<Scene>();
+
+    Entity root;
+    for (uint32_t i = 0; i < EntityCount; ++i)
+    {
+        Entity entity = scene->CreateEntity("Entity" + std::to_string(i));
+        entity.GetComponent<TransformComponent>().Position = glm::vec3(float(i), float(i) * 2.0f, -float(i));
+
+        if (i % 5 == 0)
+            root = entity;
+        else
+            entity.SetParent(root);
+
+        if (i % 3 == 0)
+        {
+            LightComponent& light = entity.AddComponent<LightComponent>();
+            light.Color = glm::vec3(float(i) / EntityCount, 0.5f, 1.0f);
+            light.Intensity = float(i);
+        }
+    }
+
+    return scene;
+}
+
+static std::string ReadFile(const std::filesystem::path& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::filesystem::path& path, const std::string& content)
+{
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << content;
+}
+
+// Compares the components by tag, the entity identifiers are kept by the snapshot
+static void CheckSameScene(const Ref<Scene>& expected, const Ref<Scene>& loaded)
+{
+    auto expectedView = expected->GetAllEntitiesWithComponents<TagComponent>();
+    auto loadedView = loaded->GetAllEntitiesWithComponents<TagComponent>();
+    COFFEE_CHECK(loadedView.size() == expectedView.size());
+
+    for (entt::entity handle : expectedView)
+    {
+        Entity source(handle, expected.get());
+        Entity copy(handle, loaded.get());
+        if (!copy.HasComponent<TagComponent>())
+        {
+            COFFEE_CHECK(copy.HasComponent<TagComponent>());
+            continue;
+        }
+
+        COFFEE_CHECK(copy.GetComponent<TagComponent>().Tag == source.GetComponent<TagComponent>().Tag);
+        COFFEE_CHECK(copy.GetComponent<TransformComponent>().Position == source.GetComponent<TransformComponent>().Position);
+
+        const HierarchyComponent& sourceHierarchy = source.GetComponent<HierarchyComponent>();
+        const HierarchyComponent& copyHierarchy = copy.GetComponent<HierarchyComponent>();
+        COFFEE_CHECK(copyHierarchy.m_Parent == sourceHierarchy.m_Parent);
+        COFFEE_CHECK(copyHierarchy.m_First == sourceHierarchy.m_First);
+        COFFEE_CHECK(copyHierarchy.m_Last == sourceHierarchy.m_Last);
+        COFFEE_CHECK(copyHierarchy.m_ChildCount == sourceHierarchy.m_ChildCount);
+
+        COFFEE_CHECK(copy.HasComponent<LightComponent>() == source.HasComponent<LightComponent>());
+        if (source.HasComponent<LightComponent>() && copy.HasComponent<LightComponent>())
+        {
+            COFFEE_CHECK(copy.GetComponent<LightComponent>().Color == source.GetComponent<LightComponent>().Color);
+            COFFEE_CHECK(copy.GetComponent<LightComponent>().Intensity == source.GetComponent<LightComponent>().Intensity);
+        }
+    }
+}
+
+static void TestRoundTrip()
+{
+    Ref<Scene> scene = CreateTestScene();
+
+    for (ResourceFormat format : {ResourceFormat::Binary, ResourceFormat::JSON})
+    {
+        std::filesystem::path path = s_Directory / (format == ResourceFormat::Binary ? "Scene.bin" : "Scene.json");
+        Scene::Save(path, scene, format);
+
+        Ref<Scene> loaded = Scene::Load(path);
+        COFFEE_CHECK(loaded != nullptr);
+        if (!loaded)
+            continue;
+
+        COFFEE_CHECK(loaded->GetFilePath() == path);
+        CheckSameScene(scene, loaded);
+    }
+}
+
+static void TestTruncatedFile()
+{
+    std::filesystem::path path = s_Directory / "Scene.bin";
+    Scene::Save(path, CreateTestScene(), ResourceFormat::Binary);
+    const std::string content = ReadFile(path);
+
+    // Cut inside the header, the chunk table and the chunks
+    std::filesystem::path truncatedPath = s_Directory / "Truncated.bin";
+    for (size_t size : {size_t(0), size_t(8), size_t(24), content.size() / 2, content.size() - 1})
+    {
+        WriteFile(truncatedPath, content.substr(0, size));
+        COFFEE_CHECK(Scene::Load(truncatedPath) == nullptr);
+    }
+
+    // A table that claims more elements than a chunk can hold only costs its real size
+    std::string inflated = content;
+    const uint32_t count = 0xFFFFFFFF;
+    std::memcpy(inflated.data() + 16 + sizeof(uint32_t), &count, sizeof(count));
+    WriteFile(truncatedPath, inflated);
+    COFFEE_CHECK(Scene::Load(truncatedPath) != nullptr);
+
+    // The intact file still loads
+    COFFEE_CHECK(Scene::Load(path) != nullptr);
+}
+
+static void TestSaveFailure()
+{
+    // The directory does not exist, the error is logged and the scene keeps its previous path
+    Ref<Scene> scene = CreateTestScene();
+    std::filesystem::path path = s_Directory / "Missing" / "Scene.bin";
+    Scene::Save(path, scene, ResourceFormat::Binary);
+
+    COFFEE_CHECK(!std::filesystem::exists(path));
+    COFFEE_CHECK(scene->GetFilePath() != path);
+}
+
+int main()
+{
+    Log::Init();
+    JobSystem::Init();
+
+    std::filesystem::remove_all(s_Directory);
+    std::filesystem::create_directories(s_Directory);
+
+    TestRoundTrip();
+    TestTruncatedFile();
+    TestSaveFailure();
+
+    std::filesystem::remove_all(s_Directory);
+
+    JobSystem::Shutdown();
+    return Test::Result();
+}
@@ -0,0 +1,39 @@
+/**
+ * @file Test.h
+ * @brief Minimal checks shared by the unit tests.
+ */
+
+#pragma once
+
+#include <cstdio>
+
+namespace Coffee::Test {
+
+    inline int s_Failures = 0; ///< Number of failed checks.
+
+    /**
+     * @brief Records a check, printing it when it fails.
+     */
+    inline void Check(bool condition, const char* expression, const char* file, int line)
+    {
+        if (!condition)
+        {
+            std::printf("%s:%d: check failed: %s\n", file, line, expression);
+            s_Failures++;
+        }
+    }
+
+    /**
+     * @brief Gets the exit code of the test executable.
+     * @return 0 if every check passed, 1 otherwise.
+     */
+    inline int Result()
+    {
+        if (s_Failures == 0)
+            std::printf("All checks passed\n");
+        return s_Failures == 0 ? 0 : 1;
+    }
+
+}
+
+#define COFFEE_CHECK(condition) ::Coffee::Test::Check((condition), #condition, __FILE__, __LINE__)